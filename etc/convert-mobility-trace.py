@@ -0,0 +1,150 @@
+#!/usr/bin/env python
+
+#
+# convert-mobility-trace.py -- converts BonnMotion and ns-2 mobility traces
+# to the binary trace format of INET (see MobilityTraceFile.h)
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program; if not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+Converts a BonnMotion (native format) or ns-2 (setdest) mobility trace to
+the binary columnar format that BonnMotionMobility and Ns2MotionMobility
+memory-map instead of parsing. The converted file can be used in place of
+the original one in the traceFile parameter. The file is written in the
+byte order of the machine running the script.
+
+Usage:
+  convert-mobility-trace.py bonnmotion [--3d] <input> <output>
+  convert-mobility-trace.py ns2 <input> <output>
+
+The input is interpreted the same way as by the mobility modules: every
+line of a BonnMotion trace is a node, and its incomplete last waypoint is
+ignored; ns-2 traces are searched for the "set X_/Y_/Z_" and "setdest"
+commands of each "$node_(i)".
+"""
+
+import array
+import re
+import struct
+import sys
+
+MAGIC = b'INETMTRC'
+VERSION = 1
+BYTE_ORDER_MARK = 0x01020304
+TYPE_BONNMOTION = 1
+TYPE_NS2 = 2
+
+NUMBER = re.compile(r'\s*[-+]?(\d+\.?\d*|\.\d+)([eE][-+]?\d+)?')
+
+
+def leading_number(s):
+    """Returns the number at the start of s like atof(), or None."""
+    m = NUMBER.match(s)
+    return float(m.group(0)) if m else None
+
+
+def read_numbers(s):
+    """Reads numbers from s like repeated 'stream >> d' does."""
+    result = []
+    pos = 0
+    while True:
+        m = NUMBER.match(s, pos)
+        if not m:
+            return result
+        result.append(float(m.group(0)))
+        pos = m.end()
+        if pos < len(s) and not s[pos].isspace():
+            return result
+
+
+def parse_bonnmotion(filename, num_columns):
+    nodes = []
+    with open(filename) as f:
+        for line in f:
+            values = read_numbers(line)
+            n = len(values) // num_columns
+            nodes.append([values[i * num_columns:(i + 1) * num_columns] for i in range(n)])
+    return nodes, None
+
+
+def parse_ns2(filename):
+    nodes = {}
+    initial = {}
+    with open(filename) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.rstrip('\r\n')
+            if line.startswith('#') or '$node_' not in line:
+                continue
+            pos1, pos2 = line.find('('), line.find(')')
+            if pos2 - pos1 <= 1:
+                continue
+            node = int(leading_number(line[pos1 + 1:]) or 0)
+            records = nodes.setdefault(node, [])
+            position = initial.setdefault(node, [-1.0, -1.0, -1.0])
+            if 'set ' in line:
+                for i, coord in enumerate(('X_', 'Y_', 'Z_')):
+                    found = line.find(coord)
+                    if found != -1:
+                        position[i] = leading_number(line[found + 3:]) or 0.0
+            found = line.find('setdest')
+            if found != -1:
+                time = leading_number(line[line.find('at') + 3:]) or 0.0
+                params = read_numbers(line[line.find('setdest ') + 8:])
+                if len(params) < 3:
+                    sys.exit('%s:%d: invalid setdest command' % (filename, lineno))
+                records.append([time] + params[:3])
+    num_nodes = max(nodes) + 1 if nodes else 0
+    return [nodes.get(i, []) for i in range(num_nodes)], \
+           [initial.get(i, [-1.0, -1.0, -1.0]) for i in range(num_nodes)]
+
+
+def write_trace(filename, trace_type, num_columns, nodes, initial):
+    num_records = sum(len(records) for records in nodes)
+    offsets = [0]
+    for records in nodes:
+        offsets.append(offsets[-1] + len(records))
+    positions = array.array('d')
+    for i in range(len(nodes)):
+        positions.extend(initial[i] if initial else [-1.0, -1.0, -1.0])
+    with open(filename, 'wb') as f:
+        f.write(MAGIC)
+        f.write(struct.pack('=6IQ', VERSION, BYTE_ORDER_MARK, trace_type, num_columns, len(nodes), 0, num_records))
+        f.write(struct.pack('=%dQ' % len(offsets), *offsets))
+        positions.tofile(f)
+        for column in range(num_columns):
+            values = array.array('d', (record[column] for records in nodes for record in records))
+            values.tofile(f)
+    return num_records
+
+
+def main(argv):
+    args = argv[1:]
+    is3d = '--3d' in args
+    args = [a for a in args if a != '--3d']
+    if len(args) != 3 or args[0] not in ('bonnmotion', 'ns2') or (is3d and args[0] != 'bonnmotion'):
+        sys.exit(__doc__)
+    kind, infile, outfile = args
+    if kind == 'bonnmotion':
+        num_columns = 4 if is3d else 3
+        nodes, initial = parse_bonnmotion(infile, num_columns)
+        num_records = write_trace(outfile, TYPE_BONNMOTION, num_columns, nodes, initial)
+    else:
+        nodes, initial = parse_ns2(infile)
+        num_records = write_trace(outfile, TYPE_NS2, 4, nodes, initial)
+    print('%s: %d nodes, %d records' % (outfile, len(nodes), num_records))
+
+
+if __name__ == '__main__':
+    main(sys.argv)
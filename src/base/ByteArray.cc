@@ -13,25 +13,145 @@
 // See the GNU Lesser General Public License for more details.
 //
 
+#include <algorithm>
+
 #include "ByteArray.h"
 
 
-void ByteArray::setDataFromBuffer(const void *ptr, unsigned int length)
+void ByteArray::addSlice(const ByteArraySlice& slice)
+{
+    ASSERT(slice.getLength() > 0);
+    if (!slices.empty())
+    {
+        // merge with the last slice if they are adjacent in the same chunk
+        ByteArraySlice& last = slices.back();
+        if (last.getChunk() == slice.getChunk() && last.getOffset() + last.getLength() == slice.getOffset())
+        {
+            last.extend(slice.getLength());
+            length += slice.getLength();
+            return;
+        }
+    }
+    slices.push_back(slice);
+    length += slice.getLength();
+}
+
+char *ByteArray::makeWritable(unsigned int capacity)
+{
+    ASSERT(capacity >= length);
+    if (slices.size() == 1 && !slices[0].getChunk()->isShared())
+    {
+        // we are the sole owner of the bytes, they can be modified in place
+        ByteArraySlice& slice = slices[0];
+        if (capacity == length)
+            return slice.getChunk()->getWritableData() + slice.getOffset();
+        if (slice.isAtChunkEnd() && capacity - length <= slice.getChunk()->getFreeSpace())
+        {
+            slice.getChunk()->appendZeros(capacity - length);
+            slice.extend(capacity - length);
+            length = capacity;
+            return slice.getChunk()->getWritableData() + slice.getOffset();
+        }
+    }
+
+    if (capacity == 0)
+        return NULL;
+
+    ByteArrayChunk *chunk = new ByteArrayChunk(capacity);
+    for (SliceVector::const_iterator i = slices.begin(); i != slices.end(); ++i)
+        chunk->append(i->getData(), i->getLength());
+    chunk->appendZeros(capacity - length);
+    slices.clear();
+    length = 0;
+    addSlice(ByteArraySlice(chunk, 0, capacity));
+    return chunk->getWritableData();
+}
+
+void ByteArray::setDataArraySize(unsigned int size)
+{
+    if (size < length)
+        truncateData(0, length - size);
+    else if (size > length)
+        makeWritable(size);
+}
+
+char ByteArray::getData(unsigned int k) const
 {
-    if (length != data_arraysize)
+    if (k >= length)
+        throw cRuntimeError("Array of size %d indexed by %d", length, k);
+    for (SliceVector::const_iterator i = slices.begin(); ; ++i)
     {
-        delete [] data_var;
-        data_var = length ? new char[length] : NULL;
-        data_arraysize = length;
+        if (k < i->getLength())
+            return i->getData()[k];
+        k -= i->getLength();
     }
+}
+
+void ByteArray::setData(unsigned int k, char data)
+{
+    if (k >= length)
+        throw cRuntimeError("Array of size %d indexed by %d", length, k);
+    makeWritable(length)[k] = data;
+}
+
+void ByteArray::parsimPack(cCommBuffer *b)
+{
+    ByteArray_Base::parsimPack(b);
+    b->pack(length);
+    for (SliceVector::const_iterator i = slices.begin(); i != slices.end(); ++i)
+        b->pack(i->getData(), i->getLength());
+}
+
+void ByteArray::parsimUnpack(cCommBuffer *b)
+{
+    ByteArray_Base::parsimUnpack(b);
+    unsigned int size;
+    b->unpack(size);
+    char *buffer = size ? new char[size] : NULL;
+    b->unpack(buffer, size);
+    assignBuffer(buffer, size);
+}
+
+void ByteArray::setDataFromBuffer(const void *ptr, unsigned int length)
+{
+    slices.clear();
+    this->length = 0;
     if (length)
-        memcpy(data_var, ptr, length);
+    {
+        ByteArrayChunk *chunk = new ByteArrayChunk(length);
+        chunk->append(ptr, length);
+        addSlice(ByteArraySlice(chunk, 0, length));
+    }
 }
 
 void ByteArray::setDataFromByteArray(const ByteArray& other, unsigned int srcOffs, unsigned int length)
 {
-    ASSERT(srcOffs+length <= other.data_arraysize);
-    setDataFromBuffer(other.data_var+srcOffs, length);
+    ASSERT(srcOffs+length <= other.length);
+    ByteArray tmp;
+    tmp.addDataFromByteArray(other, srcOffs, length);
+    slices.swap(tmp.slices);
+    this->length = tmp.length;
+}
+
+void ByteArray::addDataFromByteArray(const ByteArray& other, unsigned int srcOffs, unsigned int length)
+{
+    ASSERT(srcOffs+length <= other.length);
+    ASSERT(&other != this);
+    for (SliceVector::const_iterator i = other.slices.begin(); length > 0 && i != other.slices.end(); ++i)
+    {
+        if (srcOffs >= i->getLength())
+        {
+            srcOffs -= i->getLength();
+            continue;
+        }
+        ByteArraySlice slice(*i);
+        slice.trimFront(srcOffs);
+        if (slice.getLength() > length)
+            slice.trimBack(slice.getLength() - length);
+        length -= slice.getLength();
+        srcOffs = 0;
+        addSlice(slice);
+    }
 }
 
 void ByteArray::addDataFromBuffer(const void *ptr, unsigned int length)
@@ -39,49 +159,78 @@ void ByteArray::addDataFromBuffer(const void *ptr, unsigned int length)
     if (0 == length)
         return;
 
-    unsigned int nlength = data_arraysize + length;
-    char *ndata_var = new char[nlength];
-    if (data_arraysize)
-        memcpy(ndata_var, data_var, data_arraysize);
-    memcpy(ndata_var + data_arraysize, ptr, length);
-    delete [] data_var;
-    data_var = ndata_var;
-    data_arraysize = nlength;
+    if (!slices.empty() && slices.back().isAtChunkEnd())
+    {
+        // fill the free space of the last chunk; bytes already stored there are not affected
+        ByteArraySlice& last = slices.back();
+        unsigned int appended = last.getChunk()->append(ptr, length);
+        last.extend(appended);
+        this->length += appended;
+        ptr = (const char *)ptr + appended;
+        length -= appended;
+        if (0 == length)
+            return;
+    }
+
+    // grow geometrically, so that repeated small additions produce few slices
+    ByteArrayChunk *chunk = new ByteArrayChunk(std::max(length, this->length));
+    chunk->append(ptr, length);
+    addSlice(ByteArraySlice(chunk, 0, length));
 }
 
 unsigned int ByteArray::copyDataToBuffer(void *ptr, unsigned int length, unsigned int srcOffs) const
 {
-    if (srcOffs >= data_arraysize)
+    if (srcOffs >= this->length)
         return 0;
 
-    if (srcOffs + length > data_arraysize)
-        length = data_arraysize - srcOffs;
-    memcpy(ptr, data_var+srcOffs, length);
+    if (srcOffs + length > this->length)
+        length = this->length - srcOffs;
+    char *dest = (char *)ptr;
+    unsigned int copied = 0;
+    for (SliceVector::const_iterator i = slices.begin(); copied < length; ++i)
+    {
+        if (srcOffs >= i->getLength())
+        {
+            srcOffs -= i->getLength();
+            continue;
+        }
+        unsigned int len = std::min(i->getLength() - srcOffs, length - copied);
+        memcpy(dest + copied, i->getData() + srcOffs, len);
+        copied += len;
+        srcOffs = 0;
+    }
     return length;
 }
 
 void ByteArray::assignBuffer(void *ptr, unsigned int length)
 {
-    delete [] data_var;
-    data_var = (char *)ptr;
-    data_arraysize = length;
+    slices.clear();
+    this->length = 0;
+    ByteArrayChunk *chunk = new ByteArrayChunk((char *)ptr, length);
+    if (length)
+        addSlice(ByteArraySlice(chunk, 0, length));
+    else
+        delete chunk;
 }
 
 void ByteArray::truncateData(unsigned int truncleft, unsigned int truncright)
 {
-    ASSERT(data_arraysize >= (truncleft + truncright));
+    ASSERT(length >= (truncleft + truncright));
+
+    length -= truncleft + truncright;
 
-    if ((truncleft || truncright))
+    SliceVector::iterator first = slices.begin();
+    while (truncleft > 0 && truncleft >= first->getLength())
+        truncleft -= (first++)->getLength();
+    slices.erase(slices.begin(), first);
+    if (truncleft)
+        slices.front().trimFront(truncleft);
+
+    while (truncright > 0 && truncright >= slices.back().getLength())
     {
-        unsigned int nlength = data_arraysize - (truncleft + truncright);
-        char *ndata_var = NULL;
-        if (nlength)
-        {
-            ndata_var = new char[nlength];
-            memcpy(ndata_var, data_var+truncleft, nlength);
-        }
-        delete [] data_var;
-        data_var = ndata_var;
-        data_arraysize = nlength;
+        truncright -= slices.back().getLength();
+        slices.pop_back();
     }
+    if (truncright)
+        slices.back().trimBack(truncright);
 }
@@ -16,34 +16,84 @@
 #ifndef __INET_BYTEARRAY_H
 #define __INET_BYTEARRAY_H
 
+#include <vector>
+
 #include "ByteArray_m.h"
+#include "ByteArrayChunk.h"
 
 /**
  * Class that carries raw bytes.
+ *
+ * The bytes are stored as a sequence of slices of reference counted
+ * chunks (see ByteArrayChunk), so copying a ByteArray, taking a part of
+ * another one and truncating are done without copying the bytes. Bytes
+ * are copied only when a shared content is modified in place via
+ * setData() or setDataArraySize().
  */
 class ByteArray : public ByteArray_Base
 {
+  protected:
+    typedef std::vector<ByteArraySlice> SliceVector;
+    SliceVector slices;
+    unsigned int length;
+
+  private:
+    void copy(const ByteArray& other) { slices = other.slices; length = other.length; }
+
+  protected:
+    /**
+     * Makes the content a single unshared slice of the given capacity
+     * and returns a writable pointer to it.
+     */
+    char *makeWritable(unsigned int capacity);
+
   public:
     /**
      * Constructor
      */
-    ByteArray() : ByteArray_Base() {}
+    ByteArray() : ByteArray_Base(), length(0) {}
 
     /**
      * Copy constructor
      */
-    ByteArray(const ByteArray& other) : ByteArray_Base(other) { }
+    ByteArray(const ByteArray& other) : ByteArray_Base(other) { copy(other); }
 
     /**
      * operator =
      */
-    ByteArray& operator=(const ByteArray& other) {ByteArray_Base::operator=(other); return *this;}
+    ByteArray& operator=(const ByteArray& other) {if (this==&other) return *this; ByteArray_Base::operator=(other); copy(other); return *this;}
 
     /**
      * Creates and returns an exact copy of this object.
      */
     virtual ByteArray *dup() const {return new ByteArray(*this);}
 
+    /** @name Implementation of the data field */
+    //@{
+    virtual void setDataArraySize(unsigned int size);
+    virtual unsigned int getDataArraySize() const { return length; }
+    virtual char getData(unsigned int k) const;
+    virtual void setData(unsigned int k, char data);
+    virtual void parsimPack(cCommBuffer *b);
+    virtual void parsimUnpack(cCommBuffer *b);
+    //@}
+
+    /**
+     * Returns the number of slices the content consists of.
+     */
+    virtual unsigned int getNumSlices() const { return slices.size(); }
+
+    /**
+     * Returns the kth slice of the content.
+     */
+    virtual const ByteArraySlice& getSlice(unsigned int k) const { return slices.at(k); }
+
+    /**
+     * Add a slice to the end of existing content, without copying its bytes
+     * @param slice: the slice, must not be empty
+     */
+    virtual void addSlice(const ByteArraySlice& slice);
+
     /**
      * Copy data from buffer
      * @param ptr: pointer to buffer
@@ -52,13 +102,21 @@ class ByteArray : public ByteArray_Base
     virtual void setDataFromBuffer(const void *ptr, unsigned int length);
 
     /**
-     * Copy data from other ByteArray
+     * Set data from other ByteArray, without copying the bytes
      * @param other: reference to other ByteArray
      * @param offset: skipped first bytes from other
      * @param length: length of data
      */
     virtual void setDataFromByteArray(const ByteArray& other, unsigned int offset, unsigned int length);
 
+    /**
+     * Add data from other ByteArray to the end of existing content, without copying the bytes
+     * @param other: reference to other ByteArray
+     * @param offset: skipped first bytes from other
+     * @param length: length of data
+     */
+    virtual void addDataFromByteArray(const ByteArray& other, unsigned int offset, unsigned int length);
+
     /**
      * Add data from buffer to the end of existing content
      * @param ptr: pointer to input buffer
@@ -12,8 +12,15 @@
 // See the GNU Lesser General Public License for more details.
 //
 
+#include <algorithm>
+
 #include "ByteArrayBuffer.h"
 
+// maximum number of emptied chunks kept for reuse
+#define MAX_SPARE_CHUNKS  4
+
+const unsigned int ByteArrayBuffer::CHUNK_SIZE;
+
 ByteArrayBuffer::ByteArrayBuffer()
  :
     dataLengthM(0)
@@ -34,18 +41,97 @@ ByteArrayBuffer& ByteArrayBuffer::operator=(const ByteArrayBuffer& other)
     return *this;
 }
 
+ByteArrayBuffer::~ByteArrayBuffer()
+{
+    dataListM.clear();
+    for (ChunkVector::iterator i = spareChunksM.begin(); i != spareChunksM.end(); ++i)
+        (*i)->unref();
+}
+
+ByteArrayChunk *ByteArrayBuffer::allocateChunk()
+{
+    // the returned chunk carries one reference, which belongs to the caller
+    if (!spareChunksM.empty())
+    {
+        ByteArrayChunk *chunk = spareChunksM.back();
+        spareChunksM.pop_back();
+        return chunk;
+    }
+    ByteArrayChunk *chunk = new ByteArrayChunk(CHUNK_SIZE);
+    chunk->ref();
+    return chunk;
+}
+
+void ByteArrayBuffer::popFrontSlice()
+{
+    ByteArrayChunk *chunk = dataListM.front().getChunk();
+    chunk->ref();
+    dataListM.pop_front();
+    if (chunk->getRefCount() == 1 && chunk->getCapacity() == CHUNK_SIZE && spareChunksM.size() < MAX_SPARE_CHUNKS)
+    {
+        // nobody refers to the chunk any more, keep it for new data
+        chunk->reset();
+        spareChunksM.push_back(chunk);
+    }
+    else
+        chunk->unref();
+}
+
+void ByteArrayBuffer::pushSlice(const ByteArraySlice& slice)
+{
+    if (!dataListM.empty())
+    {
+        ByteArraySlice& last = dataListM.back();
+        if (last.getChunk() == slice.getChunk() && last.getOffset() + last.getLength() == slice.getOffset())
+        {
+            last.extend(slice.getLength());
+            dataLengthM += slice.getLength();
+            return;
+        }
+    }
+    dataListM.push_back(slice);
+    dataLengthM += slice.getLength();
+}
+
 void ByteArrayBuffer::push(const ByteArray& byteArrayP)
 {
-    dataListM.push_back(byteArrayP);
-    dataLengthM += byteArrayP.getDataArraySize();
+    // large arrays are referenced; small ones are copied into the ring,
+    // so that segments do not end up consisting of many tiny slices
+    unsigned int numSlices = byteArrayP.getNumSlices();
+    for (unsigned int i = 0; i < numSlices; i++)
+    {
+        const ByteArraySlice& slice = byteArrayP.getSlice(i);
+        if (byteArrayP.getDataArraySize() >= CHUNK_SIZE)
+            pushSlice(slice);
+        else
+            push(slice.getData(), slice.getLength());
+    }
 }
 
 void ByteArrayBuffer::push(const void* bufferP, unsigned int bufferLengthP)
 {
-    ByteArray byteArray;
-    dataListM.push_back(byteArray);
-    dataListM.back().setDataFromBuffer(bufferP, bufferLengthP);
-    dataLengthM += bufferLengthP;
+    const char *ptr = (const char *)bufferP;
+    while (bufferLengthP > 0)
+    {
+        unsigned int len;
+        if (!dataListM.empty() && dataListM.back().isAtChunkEnd() && dataListM.back().getChunk()->getFreeSpace() > 0)
+        {
+            // bytes already stored in the chunk are not affected, even if it is shared
+            ByteArraySlice& last = dataListM.back();
+            len = last.getChunk()->append(ptr, bufferLengthP);
+            last.extend(len);
+        }
+        else
+        {
+            ByteArrayChunk *chunk = allocateChunk();
+            len = chunk->append(ptr, bufferLengthP);
+            dataListM.push_back(ByteArraySlice(chunk, 0, len));
+            chunk->unref();
+        }
+        dataLengthM += len;
+        ptr += len;
+        bufferLengthP -= len;
+    }
 }
 
 unsigned int ByteArrayBuffer::getBytesToBuffer(void* bufferP, unsigned int bufferLengthP, unsigned int srcOffsP) const
@@ -53,21 +139,42 @@ unsigned int ByteArrayBuffer::getBytesToBuffer(void* bufferP, unsigned int buffe
     unsigned int copiedBytes = 0;
     DataList::const_iterator i;
 
-    for (i = this->dataListM.begin(); (copiedBytes < bufferLengthP) && (i != dataListM.end()); ++i)
+    for (i = dataListM.begin(); (copiedBytes < bufferLengthP) && (i != dataListM.end()); ++i)
     {
-        unsigned int cbytes = i->copyDataToBuffer((char *)bufferP + copiedBytes,
-                bufferLengthP - copiedBytes, srcOffsP);
-        if (cbytes)
+        if (srcOffsP >= i->getLength())
         {
-            copiedBytes += cbytes;
-            srcOffsP = 0;
+            srcOffsP -= i->getLength();
+            continue;
         }
-        else
+        unsigned int cbytes = std::min(i->getLength() - srcOffsP, bufferLengthP - copiedBytes);
+        memcpy((char *)bufferP + copiedBytes, i->getData() + srcOffsP, cbytes);
+        copiedBytes += cbytes;
+        srcOffsP = 0;
+    }
+    return copiedBytes;
+}
+
+unsigned int ByteArrayBuffer::getBytesToByteArray(ByteArray& byteArrayP, unsigned int lengthP, unsigned int srcOffsP) const
+{
+    unsigned int appendedBytes = 0;
+    DataList::const_iterator i;
+
+    for (i = dataListM.begin(); (appendedBytes < lengthP) && (i != dataListM.end()); ++i)
+    {
+        if (srcOffsP >= i->getLength())
         {
-            srcOffsP -= i->getDataArraySize();
+            srcOffsP -= i->getLength();
+            continue;
         }
+        ByteArraySlice slice(*i);
+        slice.trimFront(srcOffsP);
+        if (slice.getLength() > lengthP - appendedBytes)
+            slice.trimBack(slice.getLength() - (lengthP - appendedBytes));
+        byteArrayP.addSlice(slice);
+        appendedBytes += slice.getLength();
+        srcOffsP = 0;
     }
-    return copiedBytes;
+    return appendedBytes;
 }
 
 unsigned int ByteArrayBuffer::popBytesToBuffer(void* bufferP, unsigned int bufferLengthP)
@@ -83,17 +190,17 @@ unsigned int ByteArrayBuffer::drop(unsigned int lengthP)
 
     while (length > 0)
     {
-        unsigned int sliceLength = dataListM.front().getDataArraySize();
+        unsigned int sliceLength = dataListM.front().getLength();
 
         if (sliceLength <= length)
         {
-            dataListM.pop_front();
+            popFrontSlice();
             dataLengthM -= sliceLength;
             length -= sliceLength;
         }
         else
         {
-            dataListM.front().truncateData(length);
+            dataListM.front().trimFront(length);
             dataLengthM -= length;
             length = 0;
         }
@@ -106,9 +213,8 @@ void ByteArrayBuffer::clear()
 {
     dataLengthM = 0;
 
-    while (dataListM.begin() != dataListM.end())
+    while (!dataListM.empty())
     {
-        dataListM.pop_front();
+        popFrontSlice();
     }
 }
-
@@ -15,21 +15,45 @@
 #ifndef __INET_BYTEARRAYBUFFER_H
 #define __INET_BYTEARRAYBUFFER_H
 
+#include <deque>
+
 #include "ByteArray.h"
 
 /**
  * Buffer that carries BytesArrays.
+ *
+ * The bytes are kept in a ring of fixed-size, reference counted chunks:
+ * pushed data is appended to the last chunk, and chunks emptied by drop()
+ * are recycled for new data unless some ByteArray still refers to them.
+ * getBytesToByteArray() returns views of the stored bytes, which lets
+ * TCP send queues put payload into segments without copying it.
  */
 class ByteArrayBuffer : public cObject
 {
+  public:
+    /** Size of the chunks allocated by the buffer */
+    static const unsigned int CHUNK_SIZE = 16384;
+
   protected:
-    typedef std::list<ByteArray> DataList;
+    typedef std::deque<ByteArraySlice> DataList;
+    typedef std::vector<ByteArrayChunk *> ChunkVector;
     uint64 dataLengthM;
     DataList dataListM;
+    ChunkVector spareChunksM;   // emptied chunks kept for reuse, not referenced by anyone
 
   private:
     void copy(const ByteArrayBuffer& other) { dataLengthM = other.dataLengthM; dataListM = other.dataListM; }
 
+  protected:
+    /** Returns an empty chunk of CHUNK_SIZE bytes, a recycled one if possible */
+    ByteArrayChunk *allocateChunk();
+
+    /** Removes the first slice, and recycles its chunk if it is not referenced elsewhere */
+    void popFrontSlice();
+
+    /** Appends a slice to the end of buffer */
+    void pushSlice(const ByteArraySlice& slice);
+
   public:
     /** Ctor. */
     ByteArrayBuffer();
@@ -38,6 +62,9 @@ class ByteArrayBuffer : public cObject
     ByteArrayBuffer(const ByteArrayBuffer& other);
     ByteArrayBuffer& operator=(const ByteArrayBuffer& other);
 
+    /** Dtor. */
+    virtual ~ByteArrayBuffer();
+
     virtual ByteArrayBuffer *dup() const {return new ByteArrayBuffer(*this);}
 
     /** Clear buffer */
@@ -61,6 +88,18 @@ class ByteArrayBuffer : public cObject
      */
     virtual unsigned int getBytesToBuffer(void* bufferP, unsigned int bufferLengthP, unsigned int srcOffsP = 0) const;
 
+    /**
+     * Append bytes to a ByteArray without copying them
+     * @param byteArrayP: output ByteArray, it will refer to the bytes of the buffer
+     * @param lengthP: maximum of appended bytes
+     * @param srcOffsP: source offset
+     * @return count of appended bytes
+     */
+    virtual unsigned int getBytesToByteArray(ByteArray& byteArrayP, unsigned int lengthP, unsigned int srcOffsP = 0) const;
+
+    /** Returns the number of slices the stored data consists of */
+    virtual unsigned int getNumSlices() const { return dataListM.size(); }
+
     /**
      * Move bytes to an external buffer
      * @param bufferP: pointer to output buffer
@@ -0,0 +1,147 @@
+//
+// This library is free software, you can redistribute it
+// and/or modify
+// it under  the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation;
+// either version 2 of the License, or any later version.
+// The library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+
+#ifndef __INET_BYTEARRAYCHUNK_H
+#define __INET_BYTEARRAYCHUNK_H
+
+#include <string.h>
+
+#include "INETDefs.h"
+
+/**
+ * Reference counted storage of raw bytes, shared by ByteArray and
+ * ByteArrayBuffer through ByteArraySlice views.
+ *
+ * A chunk is append-only: bytes below getLength() never change while the
+ * chunk is shared, so any number of slices may refer to them, and an owner
+ * may still append to the free space at the end. Bytes may only be
+ * overwritten in place by the sole owner of the chunk (see isShared()).
+ */
+class INET_API ByteArrayChunk
+{
+  protected:
+    char *data;
+    unsigned int capacity;
+    unsigned int length;    // bytes stored, data[0..length)
+    int refCount;
+
+  private:
+    ByteArrayChunk(const ByteArrayChunk&);
+    ByteArrayChunk& operator=(const ByteArrayChunk&);
+
+  public:
+    /** Allocates an empty chunk of the given capacity. */
+    explicit ByteArrayChunk(unsigned int capacity) :
+        data(capacity ? new char[capacity] : NULL), capacity(capacity), length(0), refCount(0) {}
+
+    /** Takes over a buffer allocated with new char[], the chunk is full. */
+    ByteArrayChunk(char *buffer, unsigned int length) :
+        data(buffer), capacity(length), length(length), refCount(0) {}
+
+    ~ByteArrayChunk() { ASSERT(refCount == 0); delete [] data; }
+
+    /** Reference counting; the chunk is deleted when the last reference is released. */
+    void ref() { refCount++; }
+    void unref() { ASSERT(refCount > 0); if (--refCount == 0) delete this; }
+    int getRefCount() const { return refCount; }
+    bool isShared() const { return refCount > 1; }
+
+    const char *getData() const { return data; }
+    unsigned int getCapacity() const { return capacity; }
+    unsigned int getLength() const { return length; }
+    unsigned int getFreeSpace() const { return capacity - length; }
+
+    /**
+     * Returns a writable pointer to the stored bytes. Only the sole owner
+     * may modify bytes below getLength().
+     */
+    char *getWritableData() { ASSERT(!isShared()); return data; }
+
+    /**
+     * Appends at most getFreeSpace() bytes from the buffer and returns the
+     * number of appended bytes.
+     */
+    unsigned int append(const void *ptr, unsigned int len)
+    {
+        if (len > capacity - length)
+            len = capacity - length;
+        memcpy(data + length, ptr, len);
+        length += len;
+        return len;
+    }
+
+    /** Extends the stored bytes by len zero bytes, which must fit. */
+    void appendZeros(unsigned int len)
+    {
+        ASSERT(len <= capacity - length);
+        memset(data + length, 0, len);
+        length += len;
+    }
+
+    /** Empties the chunk so that it can be reused; the chunk must not be shared. */
+    void reset() { ASSERT(!isShared()); length = 0; }
+};
+
+/**
+ * View of a contiguous range of the bytes of a ByteArrayChunk. Slices hold
+ * a reference to their chunk, so copying a slice never copies the bytes.
+ */
+class INET_API ByteArraySlice
+{
+  protected:
+    ByteArrayChunk *chunk;
+    unsigned int offset;
+    unsigned int length;
+
+  public:
+    ByteArraySlice(ByteArrayChunk *chunk, unsigned int offset, unsigned int length) :
+        chunk(chunk), offset(offset), length(length)
+    {
+        ASSERT(offset + length <= chunk->getLength());
+        chunk->ref();
+    }
+
+    ByteArraySlice(const ByteArraySlice& other) :
+        chunk(other.chunk), offset(other.offset), length(other.length)
+    {
+        chunk->ref();
+    }
+
+    ByteArraySlice& operator=(const ByteArraySlice& other)
+    {
+        other.chunk->ref();
+        chunk->unref();
+        chunk = other.chunk;
+        offset = other.offset;
+        length = other.length;
+        return *this;
+    }
+
+    ~ByteArraySlice() { chunk->unref(); }
+
+    ByteArrayChunk *getChunk() const { return chunk; }
+    unsigned int getOffset() const { return offset; }
+    unsigned int getLength() const { return length; }
+    const char *getData() const { return chunk->getData() + offset; }
+
+    /** True if the slice ends at the end of the bytes stored in its chunk. */
+    bool isAtChunkEnd() const { return offset + length == chunk->getLength(); }
+
+    /** Drops bytes from the beginning or from the end of the view. */
+    void trimFront(unsigned int len) { ASSERT(len <= length); offset += len; length -= len; }
+    void trimBack(unsigned int len) { ASSERT(len <= length); length -= len; }
+
+    /** Extends the view over bytes just appended to the chunk. */
+    void extend(unsigned int len) { length += len; ASSERT(offset + length <= chunk->getLength()); }
+};
+
+#endif
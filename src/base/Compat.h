@@ -33,21 +33,47 @@
 #endif  // OMNETPP_VERSION >= 0x500
 
 #if OMNETPP_VERSION < 0x500
-#  define EV_FATAL  EV << "FATAL: "
-#  define EV_ERROR  EV << "ERROR: "
-#  define EV_WARN   EV << "WARN: "
-#  define EV_INFO   EV
-#  define EV_DETAIL EV << "DETAIL: "
-#  define EV_DEBUG  EV << "DEBUG: "
-#  define EV_TRACE  EV << "TRACE: "
-
-#  define EV_FATAL_C(category)  EV << "[" << category << "] FATAL: "
-#  define EV_ERROR_C(category)  EV << "[" << category << "] ERROR: "
-#  define EV_WARN_C(category)   EV << "[" << category << "] WARN: "
-#  define EV_INFO_C(category)   EV << "[" << category << "] "
-#  define EV_DETAIL_C(category) EV << "[" << category << "] DETAIL: "
-#  define EV_DEBUG_C(category)  EV << "[" << category << "] DEBUG: "
-#  define EV_TRACE_C(category)  EV << "[" << category << "] TRACE: "
+// Log levels as in OMNeT++ 5. Log statements below COMPILETIME_LOGLEVEL are
+// removed by the compiler: set it for the whole build with
+// "make COMPILETIME_LOGLEVEL=LOGLEVEL_INFO" (see makefrag), or redefine it in
+// a source file after the includes. Statements that are compiled in are only
+// formatted if the output is enabled (not in Cmdenv express mode).
+#  define LOGLEVEL_TRACE   0
+#  define LOGLEVEL_DEBUG   1
+#  define LOGLEVEL_DETAIL  2
+#  define LOGLEVEL_INFO    3
+#  define LOGLEVEL_WARN    4
+#  define LOGLEVEL_ERROR   5
+#  define LOGLEVEL_FATAL   6
+#  define LOGLEVEL_OFF     7
+
+#  ifndef COMPILETIME_LOGLEVEL
+#    define COMPILETIME_LOGLEVEL  LOGLEVEL_TRACE
+#  endif
+#endif  // OMNETPP_VERSION < 0x500
+
+// true if log statements of the given level are compiled in
+#define INET_LOG_ENABLED(loglevel)  ((loglevel) >= COMPILETIME_LOGLEVEL)
+
+#if OMNETPP_VERSION < 0x500
+// the empty "if" branch keeps the macros safe in unbraced if/else statements
+#  define EV_LOG_IF_ENABLED(loglevel)  if (!INET_LOG_ENABLED(loglevel)) {} else EV
+
+#  define EV_FATAL  EV_LOG_IF_ENABLED(LOGLEVEL_FATAL) << "FATAL: "
+#  define EV_ERROR  EV_LOG_IF_ENABLED(LOGLEVEL_ERROR) << "ERROR: "
+#  define EV_WARN   EV_LOG_IF_ENABLED(LOGLEVEL_WARN) << "WARN: "
+#  define EV_INFO   EV_LOG_IF_ENABLED(LOGLEVEL_INFO)
+#  define EV_DETAIL EV_LOG_IF_ENABLED(LOGLEVEL_DETAIL) << "DETAIL: "
+#  define EV_DEBUG  EV_LOG_IF_ENABLED(LOGLEVEL_DEBUG) << "DEBUG: "
+#  define EV_TRACE  EV_LOG_IF_ENABLED(LOGLEVEL_TRACE) << "TRACE: "
+
+#  define EV_FATAL_C(category)  EV_LOG_IF_ENABLED(LOGLEVEL_FATAL) << "[" << category << "] FATAL: "
+#  define EV_ERROR_C(category)  EV_LOG_IF_ENABLED(LOGLEVEL_ERROR) << "[" << category << "] ERROR: "
+#  define EV_WARN_C(category)   EV_LOG_IF_ENABLED(LOGLEVEL_WARN) << "[" << category << "] WARN: "
+#  define EV_INFO_C(category)   EV_LOG_IF_ENABLED(LOGLEVEL_INFO) << "[" << category << "] "
+#  define EV_DETAIL_C(category) EV_LOG_IF_ENABLED(LOGLEVEL_DETAIL) << "[" << category << "] DETAIL: "
+#  define EV_DEBUG_C(category)  EV_LOG_IF_ENABLED(LOGLEVEL_DEBUG) << "[" << category << "] DEBUG: "
+#  define EV_TRACE_C(category)  EV_LOG_IF_ENABLED(LOGLEVEL_TRACE) << "[" << category << "] TRACE: "
 
 #  define EV_STATICCONTEXT  /* Empty */
 
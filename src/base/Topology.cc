@@ -18,14 +18,16 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
-#include <deque>
-#include <list>
 #include <algorithm>
 #include <sstream>
 #include "Topology.h"
 #include "PatternMatcher.h"
 #include "stlutils.h"
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 
 Register_Class(Topology);
 
@@ -362,107 +364,322 @@ Topology::Node *Topology::getNodeFor(cModule *mod)
     return it==nodes.end() || (*it)->moduleId != mod->getId() ? NULL : *it;
 }
 
-void Topology::calculateUnweightedSingleShortestPathsTo(Node *_target)
+//---
+
+/**
+ * Compact, read-only copy of the enabled part of the graph for the shortest
+ * path algorithms: the usable incoming links of every node are stored
+ * contiguously (in the order of Node::inLinks), nodes are referred to by
+ * their index in the nodes vector.
+ */
+struct Topology::PathGraph
+{
+    std::vector<int> inLinkStart;       // in-links of node i are [inLinkStart[i], inLinkStart[i+1])
+    std::vector<int> inLinkSource;      // index of the source node
+    std::vector<double> inLinkWeight;
+    std::vector<Link*> inLinks;
+    std::vector<double> nodeWeight;
+
+    int getNumNodes() const {return nodeWeight.size();}
+};
+
+/**
+ * Result of one shortest path calculation, plus the working storage of the
+ * algorithm so that it can be reused for the next target.
+ */
+struct Topology::PathResult
+{
+    std::vector<double> dist;
+    std::vector<int> outLink;           // index into the PathGraph in-link arrays, or -1
+
+    // indexed binary heap of nodes ordered by (dist, seq)
+    std::vector<int> heap;
+    std::vector<int> heapPos;           // position of a node in the heap, or -1
+    std::vector<unsigned long> seq;     // insertion order, for FIFO order among equal distances
+
+    bool less(int a, int b) const {return dist[a] < dist[b] || (dist[a] == dist[b] && seq[a] < seq[b]);}
+    void siftUp(int pos);
+    void siftDown(int pos);
+};
+
+void Topology::PathResult::siftUp(int pos)
+{
+    int node = heap[pos];
+    while (pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+        if (!less(node, heap[parent]))
+            break;
+        heap[pos] = heap[parent];
+        heapPos[heap[pos]] = pos;
+        pos = parent;
+    }
+    heap[pos] = node;
+    heapPos[node] = pos;
+}
+
+void Topology::PathResult::siftDown(int pos)
 {
-    // multiple paths not supported :-(
+    int size = heap.size();
+    int node = heap[pos];
+    while (true)
+    {
+        int child = 2 * pos + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && less(heap[child + 1], heap[child]))
+            child++;
+        if (!less(heap[child], node))
+            break;
+        heap[pos] = heap[child];
+        heapPos[heap[pos]] = pos;
+        pos = child;
+    }
+    heap[pos] = node;
+    heapPos[node] = pos;
+}
 
-    if (!_target)
-        throw cRuntimeError(this,"..ShortestPathTo(): target node is NULL");
-    target = _target;
+void Topology::buildPathGraph(PathGraph& graph, bool weighted)
+{
+    int numNodes = nodes.size();
+    for (int i=0; i<numNodes; i++)
+        nodes[i]->index = i;
 
-    for (int i=0; i<(int)nodes.size(); i++)
+    graph.inLinkStart.resize(numNodes + 1);
+    graph.nodeWeight.resize(numNodes);
+    for (int i=0; i<numNodes; i++)
     {
-       nodes[i]->dist = INFINITY;
-       nodes[i]->outPath = NULL;
+        Node *dest = nodes[i];
+        graph.inLinkStart[i] = graph.inLinks.size();
+        graph.nodeWeight[i] = dest->weight;
+        if (weighted)
+            ASSERT(dest->weight >= 0.0);
+        for (int j=0; j<(int)dest->inLinks.size(); j++)
+        {
+            Link *link = dest->inLinks[j];
+            if (!link->enabled || !link->srcNode->enabled)
+                continue;
+            if (weighted)
+                ASSERT(link->weight > 0.0);
+            graph.inLinkSource.push_back(link->srcNode->index);
+            graph.inLinkWeight.push_back(link->weight);
+            graph.inLinks.push_back(link);
+        }
+    }
+    graph.inLinkStart[numNodes] = graph.inLinks.size();
+}
+
+void Topology::calculatePaths(const PathGraph& graph, int targetIndex, bool weighted, PathResult& result)
+{
+    int numNodes = graph.getNumNodes();
+    result.dist.assign(numNodes, INFINITY);
+    result.outLink.assign(numNodes, -1);
+    result.dist[targetIndex] = 0;
+
+    if (!weighted)
+    {
+        // breadth-first search; the heap vector is used as the queue
+        std::vector<int>& q = result.heap;
+        q.clear();
+        q.push_back(targetIndex);
+        for (int head = 0; head < (int)q.size(); head++)
+        {
+            int v = q[head];
+            for (int l = graph.inLinkStart[v]; l < graph.inLinkStart[v + 1]; l++)
+            {
+                int w = graph.inLinkSource[l];
+                if (result.dist[w] == INFINITY)
+                {
+                    result.dist[w] = result.dist[v] + 1;
+                    result.outLink[w] = l;
+                    q.push_back(w);
+                }
+            }
+        }
+        return;
     }
-    target->dist = 0;
 
-    std::deque<Node*> q;
+    // Dijkstra with an indexed binary heap. Nodes with equal distance are
+    // processed in the order they were (re)inserted, which gives the same
+    // paths as the former sorted list implementation.
+    result.heap.clear();
+    result.heapPos.assign(numNodes, -1);
+    result.seq.resize(numNodes);
+    unsigned long seqCounter = 0;
 
-    q.push_back(target);
+    result.seq[targetIndex] = seqCounter++;
+    result.heap.push_back(targetIndex);
+    result.heapPos[targetIndex] = 0;
 
-    while (!q.empty())
+    while (!result.heap.empty())
     {
-       Node *v = q.front();
-       q.pop_front();
-
-       // for each w adjacent to v...
-       for (int i=0; i<(int)v->inLinks.size(); i++)
-       {
-           if (!v->inLinks[i]->enabled)
-               continue;
-
-           Node *w = v->inLinks[i]->srcNode;
-           if (!w->enabled)
-               continue;
-
-           if (w->dist == INFINITY)
-           {
-               w->dist = v->dist + 1;
-               w->outPath = v->inLinks[i];
-               q.push_back(w);
-           }
-       }
+        int dest = result.heap[0];
+        result.heapPos[dest] = -1;
+        int last = result.heap.back();
+        result.heap.pop_back();
+        if (!result.heap.empty())
+        {
+            result.heap[0] = last;
+            result.heapPos[last] = 0;
+            result.siftDown(0);
+        }
+
+        // for each src adjacent to dest...
+        for (int l = graph.inLinkStart[dest]; l < graph.inLinkStart[dest + 1]; l++)
+        {
+            int src = graph.inLinkSource[l];
+            double newdist = result.dist[dest] + graph.inLinkWeight[l];
+            if (dest != targetIndex)
+                newdist += graph.nodeWeight[dest];  // dest is not the target, uses weight of dest node as price of routing (infinity means dest node doesn't route between interfaces)
+            if (newdist != INFINITY && result.dist[src] > newdist)  // it's a valid shorter path from src to target node
+            {
+                result.dist[src] = newdist;
+                result.outLink[src] = l;
+                result.seq[src] = seqCounter++;
+                if (result.heapPos[src] == -1)
+                {
+                    result.heap.push_back(src);
+                    result.heapPos[src] = result.heap.size() - 1;
+                }
+                result.siftUp(result.heapPos[src]);
+            }
+        }
     }
 }
 
-void Topology::calculateWeightedSingleShortestPathsTo(Node *_target)
+void Topology::applyPaths(const PathGraph& graph, const PathResult& result, Node *_target)
 {
-    if (!_target)
-        throw cRuntimeError(this,"..ShortestPathTo(): target node is NULL");
     target = _target;
-
-    // clean path infos
     for (int i=0; i<(int)nodes.size(); i++)
     {
-       nodes[i]->dist = INFINITY;
-       nodes[i]->outPath = NULL;
+        nodes[i]->dist = result.dist[i];
+        nodes[i]->outPath = result.outLink[i] == -1 ? NULL : graph.inLinks[result.outLink[i]];
     }
+}
 
-    target->dist = 0;
+#ifdef HAVE_PTHREAD
+/**
+ * Shared state of the threads calculating the paths of one batch of targets.
+ */
+struct Topology::PathWorkerContext
+{
+    const PathGraph *graph;
+    const int *targetIndices;
+    PathResult *results;
+    bool weighted;
+    int numTargets;
+    int nextTarget;     // next target to be taken by a thread
+    pthread_mutex_t mutex;
+};
+
+void *Topology::pathWorkerMain(void *arg)
+{
+    PathWorkerContext *context = (PathWorkerContext *)arg;
+    const PathGraph& graph = *context->graph;
+    PathResult *results = context->results;
+    while (true)
+    {
+        pthread_mutex_lock(&context->mutex);
+        int i = context->nextTarget++;
+        pthread_mutex_unlock(&context->mutex);
+        if (i >= context->numTargets)
+            break;
+        calculatePaths(graph, context->targetIndices[i], context->weighted, results[i]);
+    }
+    return NULL;
+}
+#endif
 
-    std::list<Node*> q;
+void Topology::calculateSingleShortestPathsTo(const std::vector<Node*>& targets, bool weighted, ShortestPathsListener *listener, int numThreads)
+{
+    for (int i=0; i<(int)targets.size(); i++)
+        if (!targets[i])
+            throw cRuntimeError(this,"..ShortestPathTo(): target node is NULL");
+    if (targets.empty())
+        return;
 
-    q.push_back(target);
+    PathGraph graph;
+    buildPathGraph(graph, weighted);
 
-    while (!q.empty())
+    std::vector<int> targetIndices(targets.size());
+    for (int i=0; i<(int)targets.size(); i++)
     {
-        Node *dest = q.front();
-        q.pop_front();
+        targetIndices[i] = targets[i]->index;
+        if (targetIndices[i] < 0 || targetIndices[i] >= (int)nodes.size() || nodes[targetIndices[i]] != targets[i])
+            throw cRuntimeError(this,"..ShortestPathTo(): target node is not in the topology");
+    }
 
-        ASSERT(dest->getWeight() >= 0.0);
+#ifndef HAVE_PTHREAD
+    numThreads = 1;  // no worker threads without POSIX threads
+#endif
+    if (numThreads <= 1 || targets.size() == 1)
+    {
+        PathResult result;
+        for (int i=0; i<(int)targets.size(); i++)
+        {
+            calculatePaths(graph, targetIndices[i], weighted, result);
+            applyPaths(graph, result, targets[i]);
+            if (listener)
+                listener->shortestPathsCalculated(targets[i]);
+        }
+        return;
+    }
 
-        // for each w adjacent to v...
-        for (int i=0; i < dest->getNumInLinks(); i++)
+#ifdef HAVE_PTHREAD
+    // process the targets in batches: the worker threads calculate the paths
+    // of a batch, then the results are applied and reported in order
+    int batchSize = std::min((int)targets.size(), 4 * numThreads);
+    std::vector<PathResult> results(batchSize);
+    std::vector<pthread_t> threads(numThreads);
+    PathWorkerContext context;
+    context.graph = &graph;
+    context.results = &results[0];
+    context.weighted = weighted;
+    pthread_mutex_init(&context.mutex, NULL);
+    for (int batchStart = 0; batchStart < (int)targets.size(); batchStart += batchSize)
+    {
+        context.targetIndices = &targetIndices[batchStart];
+        context.numTargets = std::min(batchSize, (int)targets.size() - batchStart);
+        context.nextTarget = 0;
+
+        int numStarted = 0;
+        for (; numStarted < std::min(numThreads, context.numTargets); numStarted++)
+            if (pthread_create(&threads[numStarted], NULL, pathWorkerMain, &context) != 0)
+                break;
+        if (numStarted == 0)
+            pathWorkerMain(&context);  // could not start any thread, do it ourselves
+        for (int i = 0; i < numStarted; i++)
+            pthread_join(threads[i], NULL);
+
+        for (int i = 0; i < context.numTargets; i++)
         {
-            if (!(dest->getLinkIn(i)->isEnabled()))
-                continue;
+            Node *target = targets[batchStart + i];
+            applyPaths(graph, results[i], target);
+            if (listener)
+                listener->shortestPathsCalculated(target);
+        }
+    }
+    pthread_mutex_destroy(&context.mutex);
+#endif
+}
 
-            Node *src = dest->getLinkIn(i)->getRemoteNode();
-            if (!src->isEnabled())
-                continue;
+void Topology::calculateUnweightedSingleShortestPathsTo(Node *_target)
+{
+    // multiple paths not supported :-(
+    calculateSingleShortestPathsTo(std::vector<Node*>(1, _target), false, NULL, 1);
+}
 
-            double linkWeight = dest->getLinkIn(i)->getWeight();
-            ASSERT(linkWeight > 0.0);
+void Topology::calculateWeightedSingleShortestPathsTo(Node *_target)
+{
+    calculateSingleShortestPathsTo(std::vector<Node*>(1, _target), true, NULL, 1);
+}
 
-            double newdist = dest->dist + linkWeight;
-            if (dest != target)
-                newdist += dest->getWeight();  // dest is not the target, uses weight of dest node as price of routing (infinity means dest node doesn't route between interfaces)
-            if (newdist != INFINITY && src->dist > newdist)  // it's a valid shorter path from src to target node
-            {
-                if (src->dist != INFINITY)
-                    q.remove(src);   // src is in the queue
-                src->dist = newdist;
-                src->outPath = dest->inLinks[i];
-
-                // insert src node to ordered list
-                std::list<Node*>::iterator it;
-                for (it = q.begin(); it != q.end(); ++it)
-                    if ((*it)->dist > newdist)
-                        break;
-                q.insert(it, src);
-            }
-        }
-    }
+void Topology::calculateUnweightedSingleShortestPathsTo(const std::vector<Node*>& targets, ShortestPathsListener *listener, int numThreads)
+{
+    calculateSingleShortestPathsTo(targets, false, listener, numThreads);
 }
 
+void Topology::calculateWeightedSingleShortestPathsTo(const std::vector<Node*>& targets, ShortestPathsListener *listener, int numThreads)
+{
+    calculateSingleShortestPathsTo(targets, true, listener, numThreads);
+}
@@ -79,12 +79,13 @@ class INET_API Topology : public cOwnedObject
         // variables used by the shortest-path algorithms
         double dist;
         Link *outPath;
+        int index;  // position in the nodes vector
 
       public:
         /**
          * Constructor
          */
-        Node(int moduleId=-1) {this->moduleId=moduleId; weight=0; enabled=true; dist=INFINITY; outPath=NULL;}
+        Node(int moduleId=-1) {this->moduleId=moduleId; weight=0; enabled=true; dist=INFINITY; outPath=NULL; index=-1;}
         virtual ~Node() {}
 
         /** @name Node attributes: weight, enabled state, correspondence to modules. */
@@ -318,6 +319,23 @@ class INET_API Topology : public cOwnedObject
         cGate *getLocalGate() const  {return srcNode->getModule()->gate(srcGateId);}
     };
 
+    /**
+     * Callback interface for the shortest path finder methods of Topology
+     * that process several target nodes in one batch.
+     */
+    class INET_API ShortestPathsListener
+    {
+      public:
+        virtual ~ShortestPathsListener() {}
+
+        /**
+         * Called after the shortest paths to the given target node have been
+         * stored in the nodes, i.e. they can be extracted via Node's methods
+         * until this method returns.
+         */
+        virtual void shortestPathsCalculated(Node *target) = 0;
+    };
+
     /**
      * Base class for selector objects used in extract...() methods of Topology.
      * Redefine the matches() method to return whether the given module
@@ -331,6 +349,10 @@ class INET_API Topology : public cOwnedObject
     };
 
   protected:
+    struct PathGraph;
+    struct PathResult;
+    struct PathWorkerContext;
+
     std::vector<Node*> nodes;
     Node *target;
 
@@ -341,6 +363,12 @@ class INET_API Topology : public cOwnedObject
     void unlinkFromSourceNode(Link *link);
     void unlinkFromDestNode(Link *link);
 
+    void calculateSingleShortestPathsTo(const std::vector<Node*>& targets, bool weighted, ShortestPathsListener *listener, int numThreads);
+    void buildPathGraph(PathGraph& graph, bool weighted);
+    void applyPaths(const PathGraph& graph, const PathResult& result, Node *target);
+    static void calculatePaths(const PathGraph& graph, int targetIndex, bool weighted, PathResult& result);
+    static void *pathWorkerMain(void *arg);
+
   public:
     /** @name Constructors, destructor, assignment */
     //@{
@@ -560,6 +588,25 @@ class INET_API Topology : public cOwnedObject
      */
     void calculateWeightedSingleShortestPathsTo(Node *target);
 
+    /**
+     * Calculates the shortest paths to each of the given target nodes like
+     * calculateUnweightedSingleShortestPathsTo(Node *), and calls the listener
+     * after each target node. The graph is converted into a compact form only
+     * once for all targets, so the graph must not be modified from the listener.
+     *
+     * If numThreads is greater than 1 and INET is built with POSIX threads
+     * (HAVE_PTHREAD), the paths to several targets are calculated in
+     * parallel by that many threads; the results are stored in
+     * the nodes and the listener is called from the calling thread, in the
+     * order of the targets vector.
+     */
+    void calculateUnweightedSingleShortestPathsTo(const std::vector<Node*>& targets, ShortestPathsListener *listener, int numThreads=1);
+
+    /**
+     * The weighted equivalent of calculateUnweightedSingleShortestPathsTo(targets, listener, numThreads).
+     */
+    void calculateWeightedSingleShortestPathsTo(const std::vector<Node*>& targets, ShortestPathsListener *listener, int numThreads=1);
+
     /**
      * Returns the node that was passed to the most recently called
      * shortest path finding function.
@@ -14,7 +14,7 @@
 // along with this program.  If not, see http://www.gnu.org/licenses/.
 // 
 
-#include <map>
+#include <algorithm>
 #include "MACAddressTable.h"
 
 #define MAX_LINE 100
@@ -23,15 +23,14 @@ Define_Module(MACAddressTable);
 
 std::ostream& operator<<(std::ostream& os, const MACAddressTable::AddressEntry& entry)
 {
-    os << "{VID=" << entry.vid << ", port=" << entry.portno << ", insertionTime=" << entry.insertionTime << "}";
+    os << "{VID=" << entry.vid << ", address=" << entry.address << ", port=" << entry.portno << ", insertionTime=" << entry.insertionTime << "}";
     return os;
 }
 
 MACAddressTable::MACAddressTable()
 {
-    addressTable = new AddressTable();
-    // Set addressTable for VLAN ID 0
-    vlanAddressTable[0] = addressTable;
+    agingHead = agingTail = -1;
+    rehash(16);
 }
 
 void MACAddressTable::initialize()
@@ -44,8 +43,7 @@ void MACAddressTable::initialize()
     if (addressTableFile && *addressTableFile)
         readAddressTable(addressTableFile);
 
-    AddressTable& addressTable = *this->addressTable; // magic to hide the '*' from the name of the watch below
-    WATCH_MAP(addressTable);
+    WATCH_VECTOR(entries);
 }
 
 /**
@@ -79,22 +77,150 @@ void MACAddressTable::handleMessage(cMessage *)
     throw cRuntimeError("This module doesn't process messages");
 }
 
-/*
- * getTableForVid
- * Returns a MAC Address Table for a specified VLAN ID
- * or NULL pointer if it is not found
- */
+unsigned int MACAddressTable::slotOf(const MACAddress& address, unsigned int vid) const
+{
+    uint64 hash = (address.getInt() ^ ((uint64)vid << 48)) * 0x9e3779b97f4a7c15ULL;
+    return (unsigned int)(hash >> 32) & (slots.size() - 1);
+}
+
+int MACAddressTable::findEntry(const MACAddress& address, unsigned int vid) const
+{
+    for (unsigned int slot = slotOf(address, vid); slots[slot] != -1; slot = (slot + 1) & (slots.size() - 1))
+    {
+        const AddressEntry& entry = entries[slots[slot]];
+        if (entry.address == address && entry.vid == vid)
+            return slots[slot];
+    }
+    return -1;
+}
+
+void MACAddressTable::rehash(unsigned int numSlots)
+{
+    slots.assign(numSlots, -1);
+    for (unsigned int i = 0; i < entries.size(); i++)
+    {
+        unsigned int slot = slotOf(entries[i].address, entries[i].vid);
+        while (slots[slot] != -1)
+            slot = (slot + 1) & (numSlots - 1);
+        slots[slot] = i;
+    }
+}
 
-MACAddressTable::AddressTable * MACAddressTable::getTableForVid(unsigned int vid)
+void MACAddressTable::linkAging(int index)
 {
-    if (vid == 0)
-        return addressTable;
-
-    MACAddressTable::VlanAddressTable::iterator iter;
-    iter = vlanAddressTable.find(vid);
-    if (iter != vlanAddressTable.end())
-        return iter->second;
-    return NULL;
+    // insertion times never decrease, so appending keeps the list ordered
+    AddressEntry& entry = entries[index];
+    entry.agingPrev = agingTail;
+    entry.agingNext = -1;
+    if (agingTail != -1)
+        entries[agingTail].agingNext = index;
+    else
+        agingHead = index;
+    agingTail = index;
+}
+
+void MACAddressTable::unlinkAging(int index)
+{
+    AddressEntry& entry = entries[index];
+    if (entry.agingPrev != -1)
+        entries[entry.agingPrev].agingNext = entry.agingNext;
+    else
+        agingHead = entry.agingNext;
+    if (entry.agingNext != -1)
+        entries[entry.agingNext].agingPrev = entry.agingPrev;
+    else
+        agingTail = entry.agingPrev;
+}
+
+void MACAddressTable::linkPort(int index)
+{
+    AddressEntry& entry = entries[index];
+    if (entry.portno >= (int)portHeads.size())
+        portHeads.resize(entry.portno + 1, -1);
+    entry.portPrev = -1;
+    entry.portNext = portHeads[entry.portno];
+    if (entry.portNext != -1)
+        entries[entry.portNext].portPrev = index;
+    portHeads[entry.portno] = index;
+}
+
+void MACAddressTable::unlinkPort(int index)
+{
+    AddressEntry& entry = entries[index];
+    if (entry.portPrev != -1)
+        entries[entry.portPrev].portNext = entry.portNext;
+    else
+        portHeads[entry.portno] = entry.portNext;
+    if (entry.portNext != -1)
+        entries[entry.portNext].portPrev = entry.portPrev;
+}
+
+int MACAddressTable::addEntry(const MACAddress& address, unsigned int vid, int portno, simtime_t insertionTime)
+{
+    if (portno < 0)
+        throw cRuntimeError("Invalid port number %d", portno);
+    if (2 * (entries.size() + 1) > slots.size())
+        rehash(2 * slots.size());
+
+    int index = entries.size();
+    entries.push_back(AddressEntry(vid, portno, insertionTime, address));
+    unsigned int slot = slotOf(address, vid);
+    while (slots[slot] != -1)
+        slot = (slot + 1) & (slots.size() - 1);
+    slots[slot] = index;
+    linkAging(index);
+    linkPort(index);
+    return index;
+}
+
+void MACAddressTable::removeEntry(int index)
+{
+    unlinkAging(index);
+    unlinkPort(index);
+
+    // backward shift deletion from the hash table
+    unsigned int mask = slots.size() - 1;
+    unsigned int hole = slotOf(entries[index].address, entries[index].vid);
+    while (slots[hole] != index)
+        hole = (hole + 1) & mask;
+    for (unsigned int slot = (hole + 1) & mask; slots[slot] != -1; slot = (slot + 1) & mask)
+    {
+        const AddressEntry& entry = entries[slots[slot]];
+        unsigned int home = slotOf(entry.address, entry.vid);
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+            slots[hole] = slots[slot];
+            hole = slot;
+        }
+    }
+    slots[hole] = -1;
+
+    // move the last entry into the gap, and redirect the references to it
+    int last = entries.size() - 1;
+    if (index != last)
+    {
+        AddressEntry& moved = entries[index];
+        moved = entries[last];
+        unsigned int slot = slotOf(moved.address, moved.vid);
+        while (slots[slot] != last)
+            slot = (slot + 1) & mask;
+        slots[slot] = index;
+        if (moved.agingPrev != -1)
+            entries[moved.agingPrev].agingNext = index;
+        else
+            agingHead = index;
+        if (moved.agingNext != -1)
+            entries[moved.agingNext].agingPrev = index;
+        else
+            agingTail = index;
+        if (moved.portPrev != -1)
+            entries[moved.portPrev].portNext = index;
+        else
+            portHeads[moved.portno] = index;
+        if (moved.portNext != -1)
+            entries[moved.portNext].portPrev = index;
+    }
+    entries.pop_back();
 }
 
 /*
@@ -107,26 +233,21 @@ int MACAddressTable::getPortForAddress(MACAddress& address, unsigned int vid)
 {
     Enter_Method("MACAddressTable::getPortForAddress()");
 
-    AddressTable * table = getTableForVid(vid);
-    // VLAN ID vid does not exist
-    if (table == NULL)
-        return -1;
-
-    AddressTable::iterator iter = table->find(address);
-
-    if (iter == table->end())
+    int index = findEntry(address, vid);
+    if (index == -1)
     {
         // not found
         return -1;
     }
-    if (iter->second.insertionTime + agingTime <= simTime())
+    AddressEntry& entry = entries[index];
+    if (entry.insertionTime + agingTime <= simTime())
     {
         // don't use (and throw out) aged entries
-        EV<< "Ignoring and deleting aged entry: "<< iter->first << " --> port" << iter->second.portno << "\n";
-        table->erase(iter);
+        EV<< "Ignoring and deleting aged entry: "<< entry.address << " --> port" << entry.portno << "\n";
+        removeEntry(index);
         return -1;
     }
-    return iter->second.portno;
+    return entry.portno;
 }
 
 /*
@@ -140,40 +261,32 @@ bool MACAddressTable::updateTableWithAddress(int portno, MACAddress& address, un
     if (address.isBroadcast())
         return false;
 
-    AddressTable::iterator iter;
-    AddressTable * table = getTableForVid(vid);
-
-    if (table == NULL)
-    {
-        // MAC Address Table does not exist for VLAN ID vid, so we create it
-        table = new AddressTable();
-
-        // set 'the addressTable' to VLAN ID 0
-        if (vid == 0)
-            addressTable = table;
-
-        vlanAddressTable[vid] = table;
-        iter = table->end();
-    }
-    else
-        iter = table->find(address);
-
-    if (iter == table->end())
+    int index = findEntry(address, vid);
+    if (index == -1)
     {
         removeAgedEntriesIfNeeded();
 
         // Add entry to table
         EV<< "Adding entry to Address Table: "<< address << " --> port" << portno << "\n";
-        (*table)[address] = AddressEntry(vid,portno,simTime());
+        addEntry(address, vid, portno, simTime());
         return false;
     }
     else
     {
         // Update existing entry
         EV << "Updating entry in Address Table: "<< address << " --> port" << portno << "\n";
-        AddressEntry& entry = iter->second;
+        AddressEntry& entry = entries[index];
         entry.insertionTime = simTime();
-        entry.portno = portno;
+        unlinkAging(index);
+        linkAging(index);
+        if (entry.portno != portno)
+        {
+            if (portno < 0)
+                throw cRuntimeError("Invalid port number %d", portno);
+            unlinkPort(index);
+            entry.portno = portno;
+            linkPort(index);
+        }
     }
     return true;
 }
@@ -185,83 +298,83 @@ bool MACAddressTable::updateTableWithAddress(int portno, MACAddress& address, un
 void MACAddressTable::flush(int portno)
 {
     Enter_Method("MACAddressTable::flush():  Clearing gate %d cache", portno);
-    for (VlanAddressTable::iterator i = vlanAddressTable.begin(); i != vlanAddressTable.end(); i++)
-    {
-        AddressTable * table = i->second;
-        for (AddressTable::iterator j = table->begin(); j != table->end();)
-        {
-            AddressTable::iterator cur = j++;
-            if (cur->second.portno == portno)
-                table->erase(cur);
-        }
-
-    }
+    if (portno < 0 || portno >= (int)portHeads.size())
+        return;
+    while (portHeads[portno] != -1)
+        removeEntry(portHeads[portno]);
 }
+
 /*
  * Prints verbose information
  */
 
-void MACAddressTable::printState()
+struct MACAddressTable::EntryLess
 {
-    EV<< endl << "MAC Address Table" << endl;
-    EV << "VLAN ID    MAC    Port    Inserted" << endl;
-    for (VlanAddressTable::iterator i = vlanAddressTable.begin(); i != vlanAddressTable.end(); i++)
+    const std::vector<AddressEntry>& entries;
+    EntryLess(const std::vector<AddressEntry>& entries) : entries(entries) {}
+    bool operator()(int a, int b) const
     {
-        AddressTable * table = i->second;
-        for (AddressTable::iterator j = table->begin(); j != table->end(); j++)
-        EV << j->second.vid << "   " << j->first << "   " << j->second.portno << "   " << j->second.insertionTime << endl;
+        if (entries[a].vid != entries[b].vid)
+            return entries[a].vid < entries[b].vid;
+        return entries[a].address.compareTo(entries[b].address) < 0;
     }
+};
 
+void MACAddressTable::printState()
+{
+    EV<< endl << "MAC Address Table" << endl;
+    EV << "VLAN ID    MAC    Port    Inserted" << endl;
+    std::vector<int> indices;
+    for (int i = 0; i < (int)entries.size(); i++)
+        indices.push_back(i);
+    std::sort(indices.begin(), indices.end(), EntryLess(entries));
+    for (std::vector<int>::iterator it = indices.begin(); it != indices.end(); it++)
+        EV << entries[*it].vid << "   " << entries[*it].address << "   " << entries[*it].portno << "   " << entries[*it].insertionTime << endl;
 }
 
 void MACAddressTable::copyTable(int portA, int portB)
 {
-    for (VlanAddressTable::iterator i = vlanAddressTable.begin(); i != vlanAddressTable.end(); i++)
+    if (portA == portB || portA < 0 || portA >= (int)portHeads.size())
+        return;
+    if (portB < 0)
+        throw cRuntimeError("Invalid port number %d", portB);
+    while (portHeads[portA] != -1)
     {
-        AddressTable * table = i->second;
-        for (AddressTable::iterator j = table->begin(); j != table->end(); j++)
-            if (j->second.portno == portA)
-                j->second.portno = portB;
+        int index = portHeads[portA];
+        unlinkPort(index);
+        entries[index].portno = portB;
+        linkPort(index);
     }
 }
 
-void MACAddressTable::removeAgedEntriesFromVlan(unsigned int vid)
+void MACAddressTable::removeAgedEntries(bool allVlans, unsigned int vid)
 {
-    AddressTable * table = getTableForVid(vid);
-    if (table == NULL)
-        return;
-    // TODO: this part could be factored out
-    for (AddressTable::iterator iter = table->begin(); iter != table->end();)
+    // entries are ordered by insertionTime, so the aged ones are at the head
+    int index = agingHead;
+    while (index != -1 && entries[index].insertionTime + agingTime <= simTime())
     {
-        AddressTable::iterator cur = iter++; // iter will get invalidated after erase()
-        AddressEntry& entry = cur->second;
-        if (entry.insertionTime + agingTime <= simTime())
+        int next = entries[index].agingNext;
+        if (allVlans || entries[index].vid == vid)
         {
             EV<< "Removing aged entry from Address Table: " <<
-            cur->first << " --> port" << cur->second.portno << "\n";
-            table->erase(cur);
+            entries[index].address << " --> port" << entries[index].portno << "\n";
+            int last = entries.size() - 1;
+            removeEntry(index);
+            if (next == last)
+                next = index;   // it has been moved into the place of the removed one
         }
+        index = next;
     }
 }
 
+void MACAddressTable::removeAgedEntriesFromVlan(unsigned int vid)
+{
+    removeAgedEntries(false, vid);
+}
+
 void MACAddressTable::removeAgedEntriesFromAllVlans()
 {
-    for (VlanAddressTable::iterator i = vlanAddressTable.begin(); i != vlanAddressTable.end(); i++)
-    {
-        AddressTable * table = i->second;
-        // TODO: this part could be factored out
-        for (AddressTable::iterator j = table->begin(); j != table->end();)
-        {
-            AddressTable::iterator cur = j++; // iter will get invalidated after erase()
-            AddressEntry& entry = cur->second;
-            if (entry.insertionTime + agingTime <= simTime())
-            {
-                EV<< "Removing aged entry from Address Table: " <<
-                cur->first << " --> port" << cur->second.portno << "\n";
-                table->erase(cur);
-            }
-        }
-    }
+    removeAgedEntries(true, 0);
 }
 
 void MACAddressTable::removeAgedEntriesIfNeeded()
@@ -316,16 +429,15 @@ void MACAddressTable::readAddressTable(const char* fileName)
             error("line %d invalid in address table file `%s'", lineno, fileName);
 
         // Create an entry with address and portno and insert into table
-        AddressEntry entry(atoi(vlanID), atoi(portno), 0);
-        AddressTable * table = getTableForVid(entry.vid);
-
-        if(table == NULL)
-        {
-            table = new AddressTable();
-            vlanAddressTable[entry.vid] = table;
-        }
-
-        (*table)[MACAddress(hexaddress)] = entry;
+        MACAddress address(hexaddress);
+        unsigned int vid = atoi(vlanID);
+        int port = atoi(portno);
+        if (port < 0)
+            error("line %d invalid in address table file `%s'", lineno, fileName);
+        int index = findEntry(address, vid);
+        if (index != -1)
+            removeEntry(index);
+        addEntry(address, vid, port, 0);
 
         // Garbage collection before next iteration
         delete [] line;
@@ -335,18 +447,12 @@ void MACAddressTable::readAddressTable(const char* fileName)
 
 void MACAddressTable::clearTable()
 {
-    for (VlanAddressTable::iterator iter = vlanAddressTable.begin(); iter != vlanAddressTable.end(); iter++)
-        delete iter->second;
-
-    vlanAddressTable.clear();
-    addressTable = NULL;
+    entries.clear();
+    slots.assign(slots.size(), -1);
+    agingHead = agingTail = -1;
+    portHeads.clear();
 }
 
-MACAddressTable::~MACAddressTable()
-{
-    for (VlanAddressTable::iterator iter = vlanAddressTable.begin(); iter != vlanAddressTable.end(); iter++)
-        delete iter->second;
-}
 void MACAddressTable::setAgingTime(simtime_t agingTime)
 {
     this->agingTime = agingTime;
@@ -17,6 +17,8 @@
 #ifndef __INET_MACADDRESSTABLE_H_
 #define __INET_MACADDRESSTABLE_H_
 
+#include <vector>
+
 #include "MACAddress.h"
 #include "IMACAddressTable.h"
 
@@ -31,25 +33,31 @@ class MACAddressTable : public cSimpleModule, public IMACAddressTable
                 unsigned int vid;           // VLAN ID
                 int portno;                 // Input port
                 simtime_t insertionTime;    // Arrival time of Lookup Address Table entry
-                AddressEntry() : vid(0) { }
-                AddressEntry(unsigned int vid, int portno, simtime_t insertionTime) :
-                        vid(vid), portno(portno), insertionTime(insertionTime) { }
+                MACAddress address;
+                int agingPrev, agingNext;   // neighbours in the aging list, or -1
+                int portPrev, portNext;     // neighbours in the list of the port, or -1
+                AddressEntry() : vid(0), portno(-1), agingPrev(-1), agingNext(-1), portPrev(-1), portNext(-1) { }
+                AddressEntry(unsigned int vid, int portno, simtime_t insertionTime, const MACAddress& address) :
+                        vid(vid), portno(portno), insertionTime(insertionTime), address(address),
+                        agingPrev(-1), agingNext(-1), portPrev(-1), portNext(-1) { }
         };
         friend std::ostream& operator<<(std::ostream& os, const AddressEntry& entry);
-
-        struct MAC_compare
-        {
-            bool operator()(const MACAddress& u1, const MACAddress& u2) const {return u1.compareTo(u2) < 0;}
-        };
-
-
-        typedef std::map<MACAddress, AddressEntry, MAC_compare> AddressTable;
-        typedef std::map<unsigned int, AddressTable*> VlanAddressTable;
+        struct EntryLess;   // orders entry indices by VLAN ID and address
 
         simtime_t agingTime;                // Max idle time for address table entries
         simtime_t lastPurge;                // Time of the last call of removeAgedEntriesFromAllVlans()
-        AddressTable * addressTable;        // VLAN-unaware address lookup (vid = 0)
-        VlanAddressTable vlanAddressTable;  // VLAN-aware address lookup
+
+        // The entries of all VLANs are stored in one array without gaps, and
+        // are looked up by (VLAN ID, address) in an open addressing hash table
+        // with linear probing. Entries are also chained by index into a list
+        // in the order of their last refresh, which is the order of their
+        // insertionTime, so aged entries are always at its head; and into one
+        // list per port, so that flushing a port visits only its entries.
+        std::vector<AddressEntry> entries;
+        std::vector<int> slots;             // index into entries, or -1; size is a power of 2, at most half full
+        int agingHead;                      // least recently refreshed entry, or -1
+        int agingTail;                      // most recently refreshed entry, or -1
+        std::vector<int> portHeads;         // first entry of each port, or -1
 
     protected:
 
@@ -57,14 +65,35 @@ class MACAddressTable : public cSimpleModule, public IMACAddressTable
         virtual void handleMessage(cMessage *msg);
 
         /**
-         * @brief Returns a MAC Address Table for a specified VLAN ID
+         * @brief Returns the index of the entry for address in VLAN vid, or -1
          */
-        AddressTable * getTableForVid(unsigned int vid);
+        int findEntry(const MACAddress& address, unsigned int vid) const;
+
+        /**
+         * @brief Adds an entry as the most recently refreshed one, and returns its index
+         */
+        int addEntry(const MACAddress& address, unsigned int vid, int portno, simtime_t insertionTime);
+
+        /**
+         * @brief Removes an entry; the last entry of the array is moved into its place
+         */
+        void removeEntry(int index);
+
+        /**
+         * @brief Removes aged entries of VLAN vid, or of all VLANs if allVlans is true
+         */
+        void removeAgedEntries(bool allVlans, unsigned int vid);
+
+        unsigned int slotOf(const MACAddress& address, unsigned int vid) const;
+        void rehash(unsigned int numSlots);
+        void linkAging(int index);
+        void unlinkAging(int index);
+        void linkPort(int index);
+        void unlinkPort(int index);
 
     public:
 
         MACAddressTable();
-        ~MACAddressTable();
 
     public:
         // Table management
@@ -52,7 +52,11 @@ void ExtInterface::initialize(int stage)
             device = par("device");
             //const char *filter = ev.config()->getAsString("Capture", "filter-string", "ip");
             const char *filter = par("filterString");
-            rtScheduler->setInterfaceModule(this, device, filter);
+            const char *replayFile = par("replayFile");
+            if (*replayFile)
+                rtScheduler->setInterfaceModuleFromSavefile(this, replayFile, filter);
+            else
+                rtScheduler->setInterfaceModule(this, device, filter);
             connected = true;
         }
         else
@@ -209,6 +213,20 @@ void ExtInterface::finish()
 {
     std::cout << getFullPath() << ": " << numSent << " packets sent, " <<
             numRcvd << " packets received, " << numDropped <<" packets dropped.\n";
+
+    const cSocketRTScheduler::InterfaceStats *stats = connected ? rtScheduler->getInterfaceStats(this) : NULL;
+    if (stats)
+    {
+        recordScalar("packets captured", stats->numCaptured);
+        recordScalar("frames skipped", stats->numSkipped);
+        recordScalar("capture batches", stats->numBatches);
+        recordScalar("max capture batch size", stats->maxBatchSize);
+        if (stats->numCaptured > 0)
+        {
+            recordScalar("mean capture latency", stats->totalLatency / stats->numCaptured);
+            recordScalar("max capture latency", stats->maxLatency);
+        }
+    }
 }
 
 void ExtInterface::flushQueue()
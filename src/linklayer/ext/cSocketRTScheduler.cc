@@ -29,6 +29,10 @@
 #include <ws2tcpip.h>
 #endif
 
+#ifdef LINUX
+#include <sys/epoll.h>
+#endif
+
 #define PCAP_SNAPLEN 65536 /* capture all data packets with up to pcap_snaplen bytes */
 #define PCAP_TIMEOUT 10    /* Timeout in ms */
 
@@ -37,11 +41,15 @@ std::vector<cModule *>cSocketRTScheduler::modules;
 std::vector<pcap_t *>cSocketRTScheduler::pds;
 std::vector<int32>cSocketRTScheduler::datalinks;
 std::vector<int32>cSocketRTScheduler::headerLengths;
+std::vector<bool>cSocketRTScheduler::savefiles;
+std::vector<cSocketRTScheduler::InterfaceStats>cSocketRTScheduler::stats;
 #endif
 timeval cSocketRTScheduler::baseTime;
 
 Register_Class(cSocketRTScheduler);
 
+Register_GlobalConfigOption(CFGID_SOCKETRTSCHEDULER_BATCH_SIZE, "socketrtscheduler-batch-size", CFG_INT, "32", "When using cSocketRTScheduler: the maximum number of packets read from a capture device at once. Larger batches reduce the per-packet overhead at high packet rates.");
+
 inline std::ostream& operator<<(std::ostream& out, const timeval& tv)
 {
     return out << (uint32)tv.tv_sec << "s" << tv.tv_usec << "us";
@@ -51,6 +59,8 @@ inline std::ostream& operator<<(std::ostream& out, const timeval& tv)
 cSocketRTScheduler::cSocketRTScheduler() : cScheduler()
 {
     fd = INVALID_SOCKET;
+    epollFd = -1;
+    batchSize = 1;
 }
 
 cSocketRTScheduler::~cSocketRTScheduler()
@@ -61,11 +71,20 @@ void cSocketRTScheduler::startRun()
 {
     gettimeofday(&baseTime, NULL);
 
+    batchSize = ev.getConfig()->getAsInt(CFGID_SOCKETRTSCHEDULER_BATCH_SIZE);
+    if (batchSize < 1)
+        throw cRuntimeError("cSocketRTScheduler: socketrtscheduler-batch-size must be positive");
+
 #ifdef HAVE_PCAP
     // Enabling sending makes no sense when we can't receive...
     fd = socket(AF_INET, SOCK_RAW, IPPROTO_RAW);
     if (fd == INVALID_SOCKET)
-        throw cRuntimeError("cSocketRTScheduler: Root privileges needed");
+    {
+        // replaying savefiles works without root privileges; capturing on
+        // a device and sending packets do not (see setInterfaceModule())
+        EV << "cSocketRTScheduler: Cannot open raw socket, only savefiles can be replayed.\n";
+        return;
+    }
     const int32 on = 1;
     if (setsockopt(fd, IPPROTO_IP, IP_HDRINCL, (char *)&on, sizeof(on)) < 0)
         throw cRuntimeError("cSocketRTScheduler: couldn't set sockopt for raw socket");
@@ -75,25 +94,44 @@ void cSocketRTScheduler::startRun()
 
 void cSocketRTScheduler::endRun()
 {
-    close(fd);
+    if (fd != INVALID_SOCKET)
+        close(fd);
     fd = INVALID_SOCKET;
 
 #ifdef HAVE_PCAP
     for (uint16 i=0; i<pds.size(); i++)
     {
-        pcap_stat ps;
-        if (pcap_stats(pds.at(i), &ps) < 0)
-            throw cRuntimeError("cSocketRTScheduler::endRun(): Cannot query pcap statistics: %s", pcap_geterr(pds.at(i)));
-        else
-            EV << modules.at(i)->getFullPath() << ": Received Packets: " << ps.ps_recv << " Dropped Packets: " << ps.ps_drop << ".\n";
+        const InterfaceStats& st = stats.at(i);
+        EV << modules.at(i)->getFullPath() << ": Captured Packets: " << st.numCaptured
+           << " Skipped non-IP Frames: " << st.numSkipped
+           << " Batches: " << st.numBatches << " (max " << st.maxBatchSize << " packets)";
+        if (st.numCaptured > 0 && !savefiles.at(i))
+            EV << " Latency: avg " << st.totalLatency / st.numCaptured << "s max " << st.maxLatency << "s";
+        EV << ".\n";
+        if (!savefiles.at(i))
+        {
+            pcap_stat ps;
+            if (pcap_stats(pds.at(i), &ps) < 0)
+                throw cRuntimeError("cSocketRTScheduler::endRun(): Cannot query pcap statistics: %s", pcap_geterr(pds.at(i)));
+            else
+                EV << modules.at(i)->getFullPath() << ": Received Packets: " << ps.ps_recv << " Dropped Packets: " << ps.ps_drop
+                   << " Dropped by Interface: " << ps.ps_ifdrop << ".\n";
+        }
         pcap_close(pds.at(i));
     }
 
-    pds.clear();
     modules.clear();
     pds.clear();
     datalinks.clear();
     headerLengths.clear();
+    savefiles.clear();
+    stats.clear();
+#endif
+
+#ifdef LINUX
+    if (epollFd != -1)
+        close(epollFd);
+    epollFd = -1;
 #endif
 }
 
@@ -107,14 +145,14 @@ void cSocketRTScheduler::setInterfaceModule(cModule *mod, const char *dev, const
 {
 #ifdef HAVE_PCAP
     char errbuf[PCAP_ERRBUF_SIZE];
-    struct bpf_program fcode;
     pcap_t * pd;
-    int32 datalink;
-    int32 headerLength;
 
     if (!mod || !dev || !filter)
         throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): arguments must be non-NULL");
 
+    if (fd == INVALID_SOCKET)
+        throw cRuntimeError("cSocketRTScheduler: Root privileges needed");
+
     /* get pcap handle */
     memset(&errbuf, 0, sizeof(errbuf));
     if ((pd = pcap_open_live(dev, PCAP_SNAPLEN, 0, PCAP_TIMEOUT, errbuf)) == NULL)
@@ -122,6 +160,42 @@ void cSocketRTScheduler::setInterfaceModule(cModule *mod, const char *dev, const
     else if (strlen(errbuf) > 0)
         EV << "cSocketRTScheduler::setInterfaceModule(): pcap_open_live returned warning: " << errbuf << "\n";
 
+    /* packets are read in batches until the device runs empty */
+    if (pcap_setnonblock(pd, 1, errbuf) < 0)
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Cannot put pcap device into non-blocking mode, error: %s", errbuf);
+
+    addInterface(mod, pd, dev, filter, false);
+#else
+    throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): code was compiled without pcap support");
+#endif
+}
+
+void cSocketRTScheduler::setInterfaceModuleFromSavefile(cModule *mod, const char *fileName, const char *filter)
+{
+#ifdef HAVE_PCAP
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_t * pd;
+
+    if (!mod || !fileName || !filter)
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModuleFromSavefile(): arguments must be non-NULL");
+
+    memset(&errbuf, 0, sizeof(errbuf));
+    if ((pd = pcap_open_offline(fileName, errbuf)) == NULL)
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModuleFromSavefile(): Cannot open pcap savefile, error = %s", errbuf);
+
+    addInterface(mod, pd, fileName, filter, true);
+#else
+    throw cRuntimeError("cSocketRTScheduler::setInterfaceModuleFromSavefile(): code was compiled without pcap support");
+#endif
+}
+
+#ifdef HAVE_PCAP
+void cSocketRTScheduler::addInterface(cModule *mod, pcap_t *pd, const char *name, const char *filter, bool isSavefile)
+{
+    struct bpf_program fcode;
+    int32 datalink;
+    int32 headerLength;
+
     /* compile this command into a filter program */
     if (pcap_compile(pd, &fcode, (char *)filter, 0, 0) < 0)
         throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Cannot compile pcap filter: %s", pcap_geterr(pd));
@@ -129,15 +203,11 @@ void cSocketRTScheduler::setInterfaceModule(cModule *mod, const char *dev, const
     /* apply the compiled filter to the packet capture device */
     if (pcap_setfilter(pd, &fcode) < 0)
         throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Cannot apply compiled pcap filter: %s", pcap_geterr(pd));
+    pcap_freecode(&fcode);
 
     if ((datalink = pcap_datalink(pd)) < 0)
         throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Cannot query pcap link-layer header type: %s", pcap_geterr(pd));
 
-#ifndef LINUX
-    if (pcap_setnonblock(pd, 1, errbuf) < 0)
-        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Cannot put pcap device into non-blocking mode, error: %s", errbuf);
-#endif
-
     switch (datalink) {
     case DLT_NULL:
         headerLength = 4;
@@ -154,15 +224,41 @@ void cSocketRTScheduler::setInterfaceModule(cModule *mod, const char *dev, const
     default:
         throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Unsupported datalink: %d", datalink);
     }
+
+#ifdef LINUX
+    if (!isSavefile)
+    {
+        // savefiles are always readable, they are not waited for
+        if (epollFd == -1 && (epollFd = epoll_create(16)) < 0)
+            throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Cannot create epoll instance: %s", strerror(errno));
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u32 = pds.size();
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, pcap_get_selectable_fd(pd), &event) < 0)
+            throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Cannot add pcap device to epoll: %s", strerror(errno));
+    }
+#endif
+
     modules.push_back(mod);
     pds.push_back(pd);
     datalinks.push_back(datalink);
     headerLengths.push_back(headerLength);
+    savefiles.push_back(isSavefile);
+    stats.push_back(InterfaceStats());
 
-    EV << "Opened pcap device " << dev << " with filter " << filter << " and datalink " << datalink << ".\n";
-#else
-    throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): code was compiled without pcap support");
+    EV << "Opened pcap " << (isSavefile ? "savefile " : "device ") << name << " with filter " << filter << " and datalink " << datalink << ".\n";
+}
+#endif
+
+const cSocketRTScheduler::InterfaceStats *cSocketRTScheduler::getInterfaceStats(cModule *mod) const
+{
+#ifdef HAVE_PCAP
+    for (unsigned int i = 0; i < modules.size(); i++)
+        if (modules[i] == mod)
+            return &stats[i];
 #endif
+    return NULL;
 }
 
 #ifdef HAVE_PCAP
@@ -174,17 +270,21 @@ static void packet_handler(u_char *user, const struct pcap_pkthdr *hdr, const u_
     cModule *module;
     struct ether_header *ethernet_hdr;
 
-    i = *(uint16 *)user;
+    i = *(unsigned int *)user;
     datalink = cSocketRTScheduler::datalinks.at(i);
     headerLength = cSocketRTScheduler::headerLengths.at(i);
     module = cSocketRTScheduler::modules.at(i);
+    cSocketRTScheduler::InterfaceStats& st = cSocketRTScheduler::stats.at(i);
 
     // skip ethernet frames not encapsulating an IP packet.
     if (datalink == DLT_EN10MB)
     {
         ethernet_hdr = (struct ether_header *)bytes;
         if (ntohs(ethernet_hdr->ether_type) != ETHERTYPE_IP)
+        {
+            st.numSkipped++;
             return;
+        }
     }
 
     // put the IP packet from wire into data[] array of ExtFrame
@@ -197,6 +297,16 @@ static void packet_handler(u_char *user, const struct pcap_pkthdr *hdr, const u_
     EV << "Captured " << hdr->caplen - headerLength << " bytes for an IP packet.\n";
     timeval curTime;
     gettimeofday(&curTime, NULL);
+    st.numCaptured++;
+    if (!cSocketRTScheduler::savefiles.at(i))
+    {
+        // delay between the kernel's capture timestamp and the injection of the packet
+        timeval delay = timeval_substract(curTime, hdr->ts);
+        double latency = delay.tv_sec + delay.tv_usec * 1e-6;
+        st.totalLatency += latency;
+        if (latency > st.maxLatency)
+            st.maxLatency = latency;
+    }
     curTime = timeval_substract(curTime, cSocketRTScheduler::baseTime);
     simtime_t t = curTime.tv_sec + curTime.tv_usec*1e-6;
     // TBD assert that it's somehow not smaller than previous event's time
@@ -206,53 +316,71 @@ static void packet_handler(u_char *user, const struct pcap_pkthdr *hdr, const u_
 }
 #endif
 
-bool cSocketRTScheduler::receiveWithTimeout()
-{
-    bool found;
-    struct timeval timeout;
 #ifdef HAVE_PCAP
-    int32 n;
-#ifdef LINUX
-    int32 fd[FD_SETSIZE], maxfd;
-    fd_set rdfds;
-#endif
+bool cSocketRTScheduler::dispatchPackets(unsigned int i)
+{
+    // read at most batchSize packets; the rest is read at the next wakeup
+    int32 n = pcap_dispatch(pds.at(i), batchSize, packet_handler, (u_char *)&i);
+    if (n < 0)
+        throw cRuntimeError("cSocketRTScheduler::pcap_dispatch(): An error occured: %s", pcap_geterr(pds.at(i)));
+    if (n == 0)
+        return false;
+
+    InterfaceStats& st = stats.at(i);
+    st.numBatches++;
+    if ((uint64)n > st.maxBatchSize)
+        st.maxBatchSize = n;
+    return true;
+}
 #endif
 
-    found = false;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = PCAP_TIMEOUT * 1000;
+bool cSocketRTScheduler::receiveWithTimeout()
+{
+    bool found = false;
 #ifdef HAVE_PCAP
+    // savefiles can always be read, so do not sleep while any of them has packets
+    for (unsigned int i = 0; i < pds.size(); i++)
+    {
+        if (savefiles[i] && dispatchPackets(i))
+            found = true;
+    }
+
 #ifdef LINUX
-    FD_ZERO(&rdfds);
-    maxfd = -1;
-    for (uint16 i = 0; i < pds.size(); i++)
+    if (epollFd != -1)
     {
-        fd[i] = pcap_get_selectable_fd(pds.at(i));
-        if (fd[i] > maxfd)
-            maxfd = fd[i];
-        FD_SET(fd[i], &rdfds);
+        struct epoll_event events[16];
+        int32 n = epoll_wait(epollFd, events, 16, found ? 0 : PCAP_TIMEOUT);
+        for (int32 k = 0; k < n; k++)
+        {
+            if (dispatchPackets(events[k].data.u32))
+                found = true;
+        }
     }
-    if (select(maxfd + 1, &rdfds, NULL, NULL, &timeout) < 0)
+    else if (!found)
     {
-        return found;
+        struct timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = PCAP_TIMEOUT * 1000;
+        select(0, NULL, NULL, NULL, &timeout);
     }
-#endif
-    for (uint16 i = 0; i < pds.size(); i++)
+#else
+    for (unsigned int i = 0; i < pds.size(); i++)
     {
-#ifdef LINUX
-        if (!(FD_ISSET(fd[i], &rdfds)))
-            continue;
-#endif
-        if ((n = pcap_dispatch(pds.at(i), 1, packet_handler, (uint8 *)&i)) < 0)
-            throw cRuntimeError("cSocketRTScheduler::pcap_dispatch(): An error occured: %s", pcap_geterr(pds.at(i)));
-        if (n > 0)
+        if (!savefiles[i] && dispatchPackets(i))
             found = true;
     }
-#ifndef LINUX
     if (!found)
+    {
+        struct timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = PCAP_TIMEOUT * 1000;
         select(0, NULL, NULL, NULL, &timeout);
+    }
 #endif
 #else
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = PCAP_TIMEOUT * 1000;
     select(0, NULL, NULL, NULL, &timeout);
 #endif
     return found;
@@ -36,13 +36,46 @@
 #endif
 #include "ExtFrame_m.h"
 
+/**
+ * Real-time scheduler that captures packets from real network interfaces
+ * with pcap, and sends packets through a raw socket.
+ *
+ * Capture devices are waited on with epoll on Linux (select() elsewhere),
+ * and every wakeup reads up to "socketrtscheduler-batch-size" packets from
+ * each ready device. Instead of a live device, an interface can also be fed
+ * from a pcap savefile, whose packets are injected as fast as possible;
+ * this allows testing without root privileges, as long as the simulation
+ * does not send packets.
+ */
 class cSocketRTScheduler : public cScheduler
 {
+    public:
+        /**
+         * Capture statistics of an interface.
+         */
+        struct InterfaceStats
+        {
+            uint64 numCaptured;     // packets passed to the interface module
+            uint64 numSkipped;      // captured non-IP frames
+            uint64 numBatches;      // pcap_dispatch() calls that returned packets
+            uint64 maxBatchSize;
+            double totalLatency;    // sum of capture timestamp to injection delays
+            double maxLatency;
+
+            InterfaceStats() : numCaptured(0), numSkipped(0), numBatches(0), maxBatchSize(0), totalLatency(0), maxLatency(0) {}
+        };
+
     protected:
         int fd;
+        int epollFd;
+        int batchSize;
 
         virtual bool receiveWithTimeout();
         virtual int receiveUntil(const timeval& targetTime);
+#ifdef HAVE_PCAP
+        virtual void addInterface(cModule *mod, pcap_t *pd, const char *name, const char *filter, bool isSavefile);
+        virtual bool dispatchPackets(unsigned int i);
+#endif
     public:
         /**
          * Constructor.
@@ -58,6 +91,8 @@ class cSocketRTScheduler : public cScheduler
         static std::vector<pcap_t *> pds;
         static std::vector<int> datalinks;
         static std::vector<int> headerLengths;
+        static std::vector<bool> savefiles;     // true if the interface replays a savefile
+        static std::vector<InterfaceStats> stats;
 #endif
         static timeval baseTime;
 
@@ -83,6 +118,18 @@ class cSocketRTScheduler : public cScheduler
          */
         void setInterfaceModule(cModule *mod, const char *dev, const char *filter);
 
+        /**
+         * Like setInterfaceModule(), but the packets are read from the given
+         * pcap savefile instead of a live network device.
+         */
+        void setInterfaceModuleFromSavefile(cModule *mod, const char *fileName, const char *filter);
+
+        /**
+         * Returns the capture statistics of the given interface module, or
+         * NULL if the module is not registered.
+         */
+        const InterfaceStats *getInterfaceStats(cModule *mod) const;
+
 #if OMNETPP_VERSION >= 0x0500
         /**
          * Returns the first event in the Future Event Set.
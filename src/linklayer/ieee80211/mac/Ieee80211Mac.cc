@@ -1956,7 +1956,7 @@ Ieee80211DataOrMgmtFrame *Ieee80211Mac::buildMulticastFrame(Ieee80211DataOrMgmtF
     PhyControlInfo *phyControlInfo_old = dynamic_cast<PhyControlInfo *>( frameToSend->getControlInfo() );
     if (phyControlInfo_old)
     {
-        EV<<"Per frame1 params"<<endl;
+        EV_DEBUG << "Per frame1 params" << endl;
         PhyControlInfo *phyControlInfo_new = new PhyControlInfo;
         *phyControlInfo_new = *phyControlInfo_old;
         //EV<<"PhyControlInfo bitrate "<<phyControlInfo->getBitrate()/1e6<<"Mbps txpower "<<phyControlInfo->txpower()<<"mW"<<endl;
@@ -2164,11 +2164,11 @@ double Ieee80211Mac::computeFrameDuration(Ieee80211Frame *msg)
 
     PhyControlInfo *ctrl;
     double duration;
-    EV<<*msg;
+    EV_DEBUG << "frame " << *msg << endl;
     ctrl = dynamic_cast<PhyControlInfo*> ( msg->removeControlInfo() );
     if ( ctrl )
     {
-        EV<<"Per frame2 params bitrate "<<ctrl->getBitrate()/1e6<<endl;
+        EV_DEBUG << "Per frame2 params bitrate " << ctrl->getBitrate()/1e6 << endl;
         duration = computeFrameDuration(msg->getBitLength(), ctrl->getBitrate());
         delete ctrl;
         return duration;
@@ -2181,6 +2181,9 @@ double Ieee80211Mac::computeFrameDuration(Ieee80211Frame *msg)
 double Ieee80211Mac::computeFrameDuration(int bits, double bitrate)
 {
     double duration;
+    if (frameDurations.find(bitrate, bits, duration))
+        return duration;
+
     ModulationType modType;
     modType = WifiModulationType::getModulationType(opMode, bitrate);
     if (PHY_HEADER_LENGTH<0)
@@ -2188,7 +2191,9 @@ double Ieee80211Mac::computeFrameDuration(int bits, double bitrate)
     else
         duration = SIMTIME_DBL(WifiModulationType::getPayloadDuration(bits, modType)) + PHY_HEADER_LENGTH;
 
-    EV<<" duration="<<duration*1e6<<"us("<<bits<<"bits "<<bitrate/1e6<<"Mbps)"<<endl;
+    frameDurations.insert(bitrate, bits, duration);
+
+    EV_DEBUG << "duration=" << duration*1e6 << "us(" << bits << "bits " << bitrate/1e6 << "Mbps)" << endl;
     return duration;
 }
 
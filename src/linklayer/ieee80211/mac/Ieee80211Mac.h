@@ -33,6 +33,7 @@
 #include "NotificationBoard.h"
 #include "RadioState.h"
 #include "FSMA.h"
+#include "FrameDurationCache.h"
 #include "IQoSClassifier.h"
 
 /**
@@ -394,6 +395,13 @@ class INET_API Ieee80211Mac : public WirelessMacBase
     cMessage *mediumStateChange;
     //@}
 
+  protected:
+    /**
+     * Frame durations computed by computeFrameDuration(bits, bitrate). The
+     * operation mode and preamble type are fixed at initialization.
+     */
+    FrameDurationCache frameDurations;
+
   protected:
     /** @name Statistics */
     //@{
@@ -88,6 +88,15 @@ int BerParseFile::getTablePosition(double speed)
     }
 }
 
+unsigned int BerParseFile::findSnr(const SnrBerList& snrlist, double tsnr)
+{
+    // index of the first entry with tsnr <= snr; the list is sorted by snr
+    SnrBer key;
+    key.snr = tsnr;
+    key.ber = 0;
+    return std::lower_bound(snrlist.begin(), snrlist.end(), key) - snrlist.begin();
+}
+
 double BerParseFile::getPer(double speed, double tsnr, int tlen)
 {
     BerList *berlist;
@@ -128,12 +137,8 @@ double BerParseFile::getPer(double speed, double tsnr, int tlen)
     }
     else
     {
-        for (j=0; j<pos->snrlist.size(); j++)
-        {
-            snrdata1 = pos->snrlist[j];
-            if (tsnr<=snrdata1.snr)
-                break;
-        }
+        j = findSnr(pos->snrlist, tsnr);
+        snrdata1 = pos->snrlist[j];
         if (j==0)
         {
             snrdata2.snr = -1;
@@ -157,12 +162,8 @@ double BerParseFile::getPer(double speed, double tsnr, int tlen)
     }
     else
     {
-        for (j=0; j<pre->snrlist.size(); j++)
-        {
-            snrdata3 = pre->snrlist[j];
-            if (tsnr<=snrdata3.snr)
-                break;
-        }
+        j = findSnr(pre->snrlist, tsnr);
+        snrdata3 = pre->snrlist[j];
         if (j!=0)
         {
             if (j==pre->snrlist.size())
@@ -61,6 +61,7 @@ class BerParseFile
     bool fileBer;
 
     int getTablePosition(double speed);
+    static unsigned int findSnr(const SnrBerList& snrlist, double tsnr);
     void clearBerTable();
     double dB2fraction(double dB)
     {
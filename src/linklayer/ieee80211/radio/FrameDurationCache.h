@@ -0,0 +1,68 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_FRAMEDURATIONCACHE_H
+#define __INET_FRAMEDURATIONCACHE_H
+
+#include <map>
+
+#include "INETDefs.h"
+
+
+/**
+ * Frame durations of the 802.11 MAC and radio, indexed by bitrate and
+ * frame length in bits. The owner must fix everything else the duration
+ * depends on (operation mode, preamble type), so that the bitrate
+ * identifies the modulation.
+ *
+ * The cache is emptied when it holds MAX_SIZE durations, so that
+ * simulations with many different frame lengths do not grow it without
+ * bound.
+ */
+class FrameDurationCache
+{
+  public:
+    enum { MAX_SIZE = 1024 };
+
+  protected:
+    typedef std::map<std::pair<double, int64>, double> DurationMap;
+    DurationMap durations;
+
+  public:
+    /**
+     * Stores the cached duration of the given frame into duration and
+     * returns true, or returns false if it is not cached.
+     */
+    bool find(double bitrate, int64 bits, double& duration) const
+    {
+        DurationMap::const_iterator it = durations.find(std::make_pair(bitrate, bits));
+        if (it == durations.end())
+            return false;
+        duration = it->second;
+        return true;
+    }
+
+    /**
+     * Caches the duration of the given frame.
+     */
+    void insert(double bitrate, int64 bits, double duration)
+    {
+        if (durations.size() >= MAX_SIZE)
+            durations.clear();
+        durations[std::make_pair(bitrate, bits)] = duration;
+    }
+};
+
+#endif
@@ -23,6 +23,8 @@
 #include "FWMath.h"
 #include "yans-error-rate-model.h"
 #include "nist-error-rate-model.h"
+#include "TabulatedErrorRateModel.h"
+#include "Ieee80211DataRate.h"
 #define NS3CALMODE
 
 
@@ -72,6 +74,19 @@ void Ieee80211RadioModel::initializeFrom(cModule *radioModule)
 
     useTestFrame = radioModule->par("airtimeLinkComputation").boolValue();
 
+    if (radioModule->par("useErrorRateTable").boolValue())
+    {
+        // tabulate the modulations of the operation mode and their PLCP headers
+        TabulatedErrorRateModel *tabulatedModel = new TabulatedErrorRateModel(errorModel);
+        errorModel = tabulatedModel;
+        for (int idx = Ieee80211Descriptor::getMinIdx(phyOpMode); idx <= Ieee80211Descriptor::getMaxIdx(phyOpMode); idx++)
+        {
+            const ModeInfo& modeInfo = getModeInfo(Ieee80211Descriptor::getDescriptor(idx).bitrate);
+            tabulatedModel->addMode(modeInfo.modeBody);
+            tabulatedModel->addMode(modeInfo.modeHeader);
+        }
+    }
+
     parseTable = NULL;
     PHY_HEADER_LENGTH = 26e-6;
 
@@ -118,11 +133,14 @@ double Ieee80211RadioModel::calculateDuration(AirFrame *airframe)
         // The physical layer header is sent with 1Mbit/s and the rest with the frame's bitrate
         duration = airframe->getBitLength()/airframe->getBitrate() + 192/BITRATE_HEADER;
 #else
-    ModulationType modeBody;
-    modeBody = WifiModulationType::getModulationType(phyOpMode, airframe->getBitrate());
-    // The physical layer header is sent with 1Mbit/s and the rest with the frame's bitrate
-    duration = SIMTIME_DBL(WifiModulationType::calculateTxDuration(airframe->getBitLength(), modeBody, wifiPreamble));
-     airframe->setModulationType(modeBody);
+    const ModulationType& modeBody = getModeInfo(airframe->getBitrate()).modeBody;
+    if (!frameDurations.find(airframe->getBitrate(), airframe->getBitLength(), duration))
+    {
+        // The physical layer header is sent with 1Mbit/s and the rest with the frame's bitrate
+        duration = SIMTIME_DBL(WifiModulationType::calculateTxDuration(airframe->getBitLength(), modeBody, wifiPreamble));
+        frameDurations.insert(airframe->getBitrate(), airframe->getBitLength(), duration);
+    }
+    airframe->setModulationType(modeBody);
 #endif
     EV<<"Radio:frameDuration="<<duration*1e6<<"us("<<airframe->getBitLength()<<"bits)"<<endl;
     return duration;
@@ -167,56 +185,10 @@ PhyIndication Ieee80211RadioModel::isReceivedCorrectly(AirFrame *airframe, const
 
 double Ieee80211RadioModel::getTestFrameError(double snirMin, double bitrate)
 {
-    ModulationType modeBody;
-    ModulationType modeHeader;
-
-    WifiPreamble preambleUsed = wifiPreamble;
-    double headerNoError;
-    uint32_t headerSize;
-    if (phyOpMode == 'b')
-        headerSize = HEADER_WITHOUT_PREAMBLE;
-    else
-        headerSize = 24;
-
-    modeBody = WifiModulationType::getModulationType(phyOpMode, bitrate);
-    modeHeader = WifiModulationType::getPlcpHeaderMode(modeBody, preambleUsed);
-    if (phyOpMode == 'g')
-    {
-        if (autoHeaderSize)
-        {
-            ModulationType modeBodyA = WifiModulationType::getModulationType('a', bitrate);
-            headerSize = ceil(
-                    SIMTIME_DBL(WifiModulationType::getPlcpHeaderDuration (modeBodyA, preambleUsed))
-                            * modeHeader.getDataRate());
-        }
-    }
-    else if (phyOpMode == 'b')
-    {
-        if (autoHeaderSize)
-            headerSize = ceil(
-                    SIMTIME_DBL(WifiModulationType::getPlcpHeaderDuration (modeBody, preambleUsed))
-                            * modeHeader.getDataRate());
-    }
-    else if (phyOpMode == 'a')
-    {
-        if (autoHeaderSize)
-            headerSize = ceil(
-                    SIMTIME_DBL(WifiModulationType::getPlcpHeaderDuration (modeBody, preambleUsed))
-                            * modeHeader.getDataRate());
-    }
-    else if (phyOpMode == 'p')
-    {
-        if (autoHeaderSize)
-            headerSize = ceil(
-                    SIMTIME_DBL(WifiModulationType::getPlcpHeaderDuration (modeBody, preambleUsed))
-                            * modeHeader.getDataRate());
-    }
-    else
-    {
-        opp_error("Radio model not supported yet, must be a,b,g or p");
-    }
+    const ModeInfo& modeInfo = getModeInfo(bitrate);
+    const ModulationType& modeHeader = modeInfo.modeHeader;
 
-    headerNoError = errorModel->GetChunkSuccessRate(modeHeader, snirMin, headerSize);
+    double headerNoError = errorModel->GetChunkSuccessRate(modeHeader, snirMin, modeInfo.headerSize);
     // probability of no bit error in the MPDU
     double MpduNoError;
     if (fileBer)
@@ -230,12 +202,42 @@ double Ieee80211RadioModel::getTestFrameError(double snirMin, double bitrate)
 bool Ieee80211RadioModel::isPacketOK(double snirMin, int lengthMPDU, double bitrate)
 {
     double berHeader, berMPDU;
-    ModulationType modeBody;
-    ModulationType modeHeader;
+    const ModeInfo& modeInfo = getModeInfo(bitrate);
+    const ModulationType& modeBody = modeInfo.modeBody;
+    const ModulationType& modeHeader = modeInfo.modeHeader;
+
+    double headerNoError = errorModel->GetChunkSuccessRate(modeHeader, snirMin, modeInfo.headerSize);
+    // probability of no bit error in the MPDU
+    double MpduNoError;
+    if (fileBer)
+        MpduNoError = 1-parseTable->getPer(bitrate, snirMin, lengthMPDU/8);
+    else
+        MpduNoError = errorModel->GetChunkSuccessRate(modeBody, snirMin, lengthMPDU);
+
+    EV << "berHeader: " << berHeader << " berMPDU: " <<berMPDU <<" lengthMPDU: "<<lengthMPDU<<" PER: "<<1-MpduNoError<<endl;
+    if (MpduNoError>=1 && headerNoError>=1)
+        return true;
+    double rand = dblrand();
+
+    if (rand > headerNoError)
+        return false; // error in header
+    else if (dblrand() > MpduNoError)
+        return false;  // error in MPDU
+    else
+        return true; // no error
+}
+
+const Ieee80211RadioModel::ModeInfo& Ieee80211RadioModel::getModeInfo(double bitrate)
+{
+    ModeInfoMap::iterator it = modeInfos.find(bitrate);
+    if (it != modeInfos.end())
+        return it->second;
 
     WifiPreamble preambleUsed = wifiPreamble;
-    double headerNoError;
-    uint32_t headerSize;
+    ModeInfo modeInfo;
+    ModulationType& modeBody = modeInfo.modeBody;
+    ModulationType& modeHeader = modeInfo.modeHeader;
+    uint32_t& headerSize = modeInfo.headerSize;
     if (phyOpMode=='b')
         headerSize = HEADER_WITHOUT_PREAMBLE;
     else
@@ -260,26 +262,7 @@ bool Ieee80211RadioModel::isPacketOK(double snirMin, int lengthMPDU, double bitr
     {
         opp_error("Radio model not supported yet, must be a,b,g or p");
     }
-
-    headerNoError = errorModel->GetChunkSuccessRate(modeHeader, snirMin, headerSize);
-    // probability of no bit error in the MPDU
-    double MpduNoError;
-    if (fileBer)
-        MpduNoError = 1-parseTable->getPer(bitrate, snirMin, lengthMPDU/8);
-    else
-        MpduNoError = errorModel->GetChunkSuccessRate(modeBody, snirMin, lengthMPDU);
-
-    EV << "berHeader: " << berHeader << " berMPDU: " <<berMPDU <<" lengthMPDU: "<<lengthMPDU<<" PER: "<<1-MpduNoError<<endl;
-    if (MpduNoError>=1 && headerNoError>=1)
-        return true;
-    double rand = dblrand();
-
-    if (rand > headerNoError)
-        return false; // error in header
-    else if (dblrand() > MpduNoError)
-        return false;  // error in MPDU
-    else
-        return true; // no error
+    return modeInfos[bitrate] = modeInfo;
 }
 
 double Ieee80211RadioModel::dB2fraction(double dB)
@@ -20,10 +20,13 @@
 #ifndef IEEE80211RADIOMODEL_H
 #define IEEE80211RADIOMODEL_H
 
+#include <map>
+
 #include "IRadioModel.h"
 #include "BerParseFile.h"
 #include "IErrorModel.h"
 #include "WifiPreambleType.h"
+#include "FrameDurationCache.h"
 
 /**
  * Radio model for IEEE 802.11. The implementation is largely based on the
@@ -53,6 +56,18 @@ class INET_API Ieee80211RadioModel : public IRadioModel
     unsigned int btSize; //
     bool useTestFrame;
 
+    /** Modulations and PLCP header size used at a bitrate */
+    struct ModeInfo
+    {
+        ModulationType modeBody;
+        ModulationType modeHeader;
+        uint32_t headerSize;
+    };
+    typedef std::map<double, ModeInfo> ModeInfoMap;
+    ModeInfoMap modeInfos;
+
+    FrameDurationCache frameDurations;
+
   public:
     virtual void initializeFrom(cModule *radioModule);
 
@@ -73,6 +88,8 @@ class INET_API Ieee80211RadioModel : public IRadioModel
   protected:
     // utility
     virtual bool isPacketOK(double snirMin, int lengthMPDU, double bitrate);
+    // utility: modulations and header size of a bitrate, computed on first use
+    virtual const ModeInfo& getModeInfo(double bitrate);
     // utility
     virtual double dB2fraction(double dB);
 
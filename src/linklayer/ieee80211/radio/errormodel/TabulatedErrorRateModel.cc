@@ -0,0 +1,100 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <stdio.h>
+#include <typeinfo>
+
+#include "TabulatedErrorRateModel.h"
+
+// -ln() of the smallest positive double: a success rate of 0
+#define MAX_TABLE_VALUE  745.0
+
+TabulatedErrorRateModel::TableMap TabulatedErrorRateModel::tables;
+int TabulatedErrorRateModel::numInstances = 0;
+
+TabulatedErrorRateModel::TabulatedErrorRateModel(IErrorModel *model) : model(model)
+{
+    numInstances++;
+}
+
+TabulatedErrorRateModel::~TabulatedErrorRateModel()
+{
+    delete model;
+    if (--numInstances == 0)
+        tables.clear();
+}
+
+void TabulatedErrorRateModel::addMode(const ModulationType& mode)
+{
+    if (findTable(mode))
+        return;
+
+#ifndef ENABLE_GSL
+    // without GSL, DsssErrorRateModel uses Matlab fits for CCK that jump at
+    // SINR 0.1 and 10; they are cheap, and interpolation would smear the steps
+    if (mode.getModulationClass() == MOD_CLASS_DSSS && (mode.getDataRate() == 5500000 || mode.getDataRate() == 11000000))
+        return;
+#endif
+
+    char buf[100];
+    sprintf(buf, "/%d/%u/%u", (int)mode.getModulationClass(), (unsigned int)mode.getDataRate(), (unsigned int)mode.getBandwidth());
+    std::string key = std::string(typeid(*model).name()) + buf;
+
+    TableMap::iterator it = tables.find(key);
+    if (it == tables.end())
+    {
+        Table& table = tables[key];
+        table.resize((MAX_EXPONENT - MIN_EXPONENT) * POINTS_PER_OCTAVE + 1);
+        for (unsigned int i = 0; i < table.size(); i++)
+        {
+            double successRate = model->GetChunkSuccessRate(mode, getSnr(i), 1);
+            table[i] = successRate > 0 ? std::min(-log(successRate), MAX_TABLE_VALUE) : MAX_TABLE_VALUE;
+        }
+        it = tables.find(key);
+    }
+
+    ModeTable modeTable;
+    modeTable.modulationClass = mode.getModulationClass();
+    modeTable.dataRate = mode.getDataRate();
+    modeTable.bandwidth = mode.getBandwidth();
+    modeTable.table = &it->second;
+    modeTables.push_back(modeTable);
+}
+
+const TabulatedErrorRateModel::Table *TabulatedErrorRateModel::findTable(const ModulationType& mode) const
+{
+    for (std::vector<ModeTable>::const_iterator it = modeTables.begin(); it != modeTables.end(); ++it)
+        if (it->dataRate == mode.getDataRate() && it->modulationClass == mode.getModulationClass() && it->bandwidth == mode.getBandwidth())
+            return it->table;
+    return NULL;
+}
+
+double TabulatedErrorRateModel::GetChunkSuccessRate(ModulationType mode, double snr, uint32_t nbits) const
+{
+    const Table *table = findTable(mode);
+    if (!table || !(snr >= ldexp(1.0, MIN_EXPONENT) && snr < ldexp(1.0, MAX_EXPONENT)))
+        return model->GetChunkSuccessRate(mode, snr, nbits);
+
+    int exponent;
+    double mantissa = frexp(snr, &exponent);   // snr = mantissa * 2^exponent, mantissa in [0.5, 1)
+    double x = (2 * mantissa - 1) * POINTS_PER_OCTAVE;
+    int j = (int)x;
+    int i = (exponent - 1 - MIN_EXPONENT) * POINTS_PER_OCTAVE + j;
+    const Table& values = *table;
+    double value = values[i] + (x - j) * (values[i + 1] - values[i]);
+    return exp(-(double)nbits * value);
+}
+
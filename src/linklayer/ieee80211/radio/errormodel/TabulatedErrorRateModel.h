@@ -0,0 +1,99 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_TABULATEDERRORRATEMODEL_H
+#define __INET_TABULATEDERRORRATEMODEL_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <math.h>
+
+#include "INETDefs.h"
+
+#include "ModulationType.h"
+#include "IErrorModel.h"
+
+/**
+ * Chunk success rates of another error model, precomputed per modulation
+ * and linearly interpolated. The error models of the 802.11 radio give the
+ * success rate of n bits as (1 - p)^n, where p depends on the modulation
+ * and the SNR only, so a single table of -ln(1 - p) versus SNR per
+ * modulation serves every chunk length: the success rate is
+ * exp(-n * value).
+ *
+ * The SNR is sampled at POINTS_PER_OCTAVE points per octave (a factor of
+ * two, about 3dB) from 2^MIN_EXPONENT to 2^MAX_EXPONENT (-21dB to 51dB);
+ * as in PathLossTable, the segment of an SNR is found from its binary
+ * exponent instead of a logarithm. SNRs outside this range and modulations
+ * without a table are passed to the underlying model.
+ *
+ * The tables only depend on the type of the underlying model and the
+ * modulation, so they are shared by all instances and released with the
+ * last one.
+ */
+class INET_API TabulatedErrorRateModel : public IErrorModel
+{
+  public:
+    enum { POINTS_PER_OCTAVE = 128, MIN_EXPONENT = -7, MAX_EXPONENT = 17 };
+
+  protected:
+    typedef std::vector<double> Table;
+    typedef std::map<std::string, Table> TableMap;
+
+    struct ModeTable
+    {
+        ModulationClass modulationClass;
+        uint32_t dataRate;
+        uint32_t bandwidth;
+        const Table *table;
+    };
+
+    IErrorModel *model;
+    std::vector<ModeTable> modeTables;
+
+    static TableMap tables;
+    static int numInstances;
+
+  protected:
+    const Table *findTable(const ModulationType& mode) const;
+
+    static double getSnr(int i)
+    {
+        return ldexp(1.0 + (double)(i % POINTS_PER_OCTAVE) / POINTS_PER_OCTAVE, MIN_EXPONENT + i / POINTS_PER_OCTAVE);
+    }
+
+  private:
+    TabulatedErrorRateModel(const TabulatedErrorRateModel&);
+    TabulatedErrorRateModel& operator=(const TabulatedErrorRateModel&);
+
+  public:
+    /**
+     * Wraps the given model, which will be deleted with this object.
+     */
+    TabulatedErrorRateModel(IErrorModel *model);
+    virtual ~TabulatedErrorRateModel();
+
+    /**
+     * Makes the chunk success rates of the given modulation come from a
+     * table, computing the table unless another instance already did.
+     */
+    virtual void addMode(const ModulationType& mode);
+
+    virtual double GetChunkSuccessRate(ModulationType mode, double snr, uint32_t nbits) const;
+};
+
+#endif
+
@@ -223,7 +223,7 @@ Radio::~Radio()
         cancelAndDelete(updateString);
     // delete messages being received
     for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
-        delete it->first;
+        delete it->airframe;
 }
 
 bool Radio::handleOperationStage(LifecycleOperation *operation, int stage, IDoneCallback *doneCallback)
@@ -623,7 +623,10 @@ void Radio::handleLowerMsgStart(AirFrame* airframe)
         rcvdPower = obstacles->calculateReceivedPower(rcvdPower, carrierFrequency, framePos, 0, getRadioPosition(), 0);
     airframe->setPowRec(rcvdPower);
     // store the receive power in the recvBuff
-    recvBuff[airframe] = rcvdPower;
+    RecvBuffEntry entry;
+    entry.airframe = airframe;
+    entry.rcvdPower = rcvdPower;
+    recvBuff.push_back(entry);
     updateSensitivity(airframe->getBitrate());
 
     // if receive power is bigger than sensitivity and if not sending
@@ -633,13 +636,12 @@ void Radio::handleLowerMsgStart(AirFrame* airframe)
     // processing ongoing transmissions during a channel change
     if (airframe->getArrivalTime() == simTime() && rcvdPower >= sensitivity && rs.getState() != RadioState::TRANSMIT && snrInfo.ptr == NULL)
     {
-        EV << "receiving frame " << airframe->getName() << endl;
+        EV_INFO << "receiving frame " << airframe->getName() << endl;
 
         // Put frame and related SnrList in receive buffer
-        SnrList snrList;
         snrInfo.ptr = airframe;
         snrInfo.rcvdPower = rcvdPower;
-        snrInfo.sList = snrList;
+        snrInfo.sList.clear();
 
         // add initial snr value
         addNewSnr();
@@ -647,14 +649,14 @@ void Radio::handleLowerMsgStart(AirFrame* airframe)
         if (rs.getState() != RadioState::RECV)
         {
             // publish new RadioState
-            EV << "publish new RadioState:RECV\n";
+            EV_DEBUG << "publish new RadioState:RECV\n";
             setRadioState(RadioState::RECV);
         }
     }
     // receive power is too low or another message is being sent or received
     else
     {
-        EV << "frame " << airframe->getName() << " is just noise\n";
+        EV_DETAIL << "frame " << airframe->getName() << " is just noise\n";
         //add receive power to the noise level
         noiseLevel += rcvdPower;
 
@@ -662,7 +664,7 @@ void Radio::handleLowerMsgStart(AirFrame* airframe)
         if (snrInfo.ptr != NULL)
         {
             // update snr info for currently being received message
-            EV << "adding new snr value to snr list of message being received\n";
+            EV_DEBUG << "adding new snr value to snr list of message being received\n";
             addNewSnr();
         }
 
@@ -670,7 +672,7 @@ void Radio::handleLowerMsgStart(AirFrame* airframe)
         // and the radio is currently not in receive or in send mode
         if (BASE_NOISE_LEVEL >= receptionThreshold && rs.getState() == RadioState::IDLE)
         {
-            EV << "setting radio state to RECV\n";
+            EV_DEBUG << "setting radio state to RECV\n";
             setRadioState(RadioState::RECV);
         }
     }
@@ -693,15 +695,16 @@ void Radio::handleLowerMsgEnd(AirFrame * airframe)
     if (snrInfo.ptr == airframe)
     {
         EV << "reception of frame over, preparing to send packet to upper layer\n";
-        // get Packet and list out of the receive buffer:
-        SnrList list;
-        list = snrInfo.sList;
+        // get Packet and list out of the receive buffer (swapping keeps
+        // the storage of both lists for the next frames):
+        SnrList& list = receivedSnrList;
+        list.swap(snrInfo.sList);
 
         // delete the pointer to indicate that no message is currently
         // being received and clear the list
 
-        double snirMin = snrInfo.sList.begin()->snr;
-        for (SnrList::const_iterator iter = snrInfo.sList.begin(); iter != snrInfo.sList.end(); iter++)
+        double snirMin = list.begin()->snr;
+        for (SnrList::const_iterator iter = list.begin(); iter != list.end(); iter++)
             if (iter->snr < snirMin)
                 snirMin = iter->snr;
         snrInfo.ptr = NULL;
@@ -709,7 +712,7 @@ void Radio::handleLowerMsgEnd(AirFrame * airframe)
         airframe->setSnr(10*log10(snirMin)); //ahmed
         airframe->setLossRate(lossRate);
         // delete the frame from the recvBuff
-        recvBuff.erase(airframe);
+        removeFromRecvBuff(airframe);
 
         //XXX send up the frame:
         //if (radioModel->isReceivedCorrectly(airframe, list))
@@ -740,11 +743,9 @@ void Radio::handleLowerMsgEnd(AirFrame * airframe)
     else
     {
         EV << "reception of noise message over, removing recvdPower from noiseLevel....\n";
-        // get the rcvdPower and subtract it from the noiseLevel
-        noiseLevel -= recvBuff[airframe];
-
-        // delete message from the recvBuff
-        recvBuff.erase(airframe);
+        // delete message from the recvBuff, and subtract its rcvdPower
+        // from the noiseLevel
+        noiseLevel -= removeFromRecvBuff(airframe);
 
         // update snr info for message currently being received if any
         if (snrInfo.ptr != NULL)
@@ -777,6 +778,21 @@ void Radio::addNewSnr()
     snrInfo.sList.push_back(listEntry);
 }
 
+double Radio::removeFromRecvBuff(AirFrame *airframe)
+{
+    // the frames end in about the order they started, search from the front
+    for (RecvBuff::iterator it = recvBuff.begin(); it != recvBuff.end(); ++it)
+    {
+        if (it->airframe == airframe)
+        {
+            double rcvdPower = it->rcvdPower;
+            recvBuff.erase(it);
+            return rcvdPower;
+        }
+    }
+    throw cRuntimeError("AirFrame %s not found in the receive buffer", airframe->getName());
+}
+
 void Radio::changeChannel(int channel)
 {
     if (channel == rs.getChannelNumber())
@@ -787,7 +803,7 @@ void Radio::changeChannel(int channel)
    // Clear the recvBuff
    for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
    {
-        AirFrame *airframe = it->first;
+        AirFrame *airframe = it->airframe;
         cMessage *endRxTimer = (cMessage *)airframe->getContextPointer();
         delete airframe;
         delete cancelEvent(endRxTimer);
@@ -1072,7 +1088,7 @@ void Radio::disconnectReceiver()
    // Clear the recvBuff
    for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
    {
-        AirFrame *airframe = it->first;
+        AirFrame *airframe = it->airframe;
         cMessage *endRxTimer = (cMessage *)airframe->getContextPointer();
         delete airframe;
         delete cancelEvent(endRxTimer);
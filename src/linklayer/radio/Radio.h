@@ -108,6 +108,9 @@ class INET_API Radio : public ChannelAccess, public ILifecycle
     /** Updates the SNR information of the relevant AirFrame */
     virtual void addNewSnr();
 
+    /** Removes the frame from recvBuff and returns its receive power */
+    virtual double removeFromRecvBuff(AirFrame *airframe);
+
     /** Create a new AirFrame */
     virtual AirFrame *createAirFrame() {return new AirFrame();}
 
@@ -195,23 +198,30 @@ class INET_API Radio : public ChannelAccess, public ILifecycle
     SnrStruct snrInfo;
 
     /**
-     * Typedef used to store received messages together with
+     * A message being received (as signal or as noise) together with its
      * receive power.
      */
-    struct Compare {
-        bool operator() (AirFrame* const &lhs, AirFrame* const &rhs) const {
-            ASSERT(lhs && rhs);
-            return lhs->getId() < rhs->getId();
-        }
+    struct RecvBuffEntry
+    {
+        AirFrame *airframe;
+        double rcvdPower;
     };
-    typedef std::map<AirFrame*, double, Compare> RecvBuff;
+    typedef std::vector<RecvBuffEntry> RecvBuff;
 
     /**
      * State: A buffer to store a pointer to a message and the related
-     * receive power.
+     * receive power. Only a few messages overlap at a time, so it is an
+     * unordered array that is searched linearly.
      */
     RecvBuff recvBuff;
 
+    /**
+     * The SnrList passed to the radio model. It is swapped with the list of
+     * snrInfo at the end of each reception, so that the memory of both lists
+     * is reused instead of being allocated for every frame.
+     */
+    SnrList receivedSnrList;
+
     /** State: the current RadioState of the NIC; includes channel number */
     RadioState rs;
 
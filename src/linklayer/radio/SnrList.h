@@ -20,7 +20,7 @@
 #ifndef SNRLIST_H
 #define SNRLIST_H
 
-#include <list>
+#include <vector>
 
 /**
  * @brief struct for SNR information
@@ -45,12 +45,12 @@ struct SnrListEntry{
  *
  * used to store SNR information of a message and pass it to the
  * Decider. Each SnrListEntry in this list corresponds to one SNR
- * value at a specific time.
+ * value at a specific time, in increasing time order.
  *
  * @ingroup utils
  * @ingroup basicUtils
  * @author Marc Lbbers
  */
-typedef std::list<SnrListEntry> SnrList;
+typedef std::vector<SnrListEntry> SnrList;
 
 #endif
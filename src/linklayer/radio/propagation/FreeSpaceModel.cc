@@ -33,6 +33,17 @@ using namespace std;
 
 Register_Class(FreeSpaceModel);
 
+#define FADING_BATCH_SIZE  256
+
+FreeSpaceModel::FreeSpaceModel()
+{
+    usePathLossTable = false;
+    lastCarrierFrequency = 0;
+    lastPathLossTable = NULL;
+    fadingSamples.resize(FADING_BATCH_SIZE);
+    numFadingSamplesUsed = fadingSamples.size();
+}
+
 void FreeSpaceModel::initializeFreeSpace(cModule *radioModule)
 {
     pathLossAlpha = radioModule->par("pathLossAlpha");
@@ -42,6 +53,7 @@ void FreeSpaceModel::initializeFreeSpace(cModule *radioModule)
     Gt = pow(10, radioModule->par("TransmissionAntennaGainIndB").doubleValue()/10);
     Gr = pow(10, radioModule->par("ReceiveAntennaGainIndB").doubleValue()/10);
     L = pow(10, radioModule->par("SystemLossFactor").doubleValue()/10);
+    usePathLossTable = radioModule->par("usePathLossTable");
 }
 
 void FreeSpaceModel::initializeFrom(cModule *radioModule)
@@ -52,6 +64,9 @@ void FreeSpaceModel::initializeFrom(cModule *radioModule)
 
 double FreeSpaceModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
 {
+    if (usePathLossTable)
+        return std::min(pSend * getPathGain(carrierFrequency, distance), pSend);
+
     double waveLength = SPEED_OF_LIGHT / carrierFrequency;
     double prec = freeSpace(Gt, Gr, L, pSend, waveLength, distance, pathLossAlpha);
     if (prec > pSend)
@@ -81,6 +96,40 @@ double FreeSpaceModel::freeSpace(double Gt, double Gr, double L, double Pt, doub
   return pr;
 }
 
+double FreeSpaceModel::calculatePathGain(double carrierFrequency, double distance)
+{
+    double waveLength = SPEED_OF_LIGHT / carrierFrequency;
+    return freeSpace(Gt, Gr, L, 1.0, waveLength, distance, pathLossAlpha);
+}
+
+double FreeSpaceModel::getPathGain(double carrierFrequency, double distance)
+{
+    if (carrierFrequency != lastCarrierFrequency || !lastPathLossTable)
+    {
+        std::map<double, PathLossTable>::iterator it = pathLossTables.find(carrierFrequency);
+        if (it == pathLossTables.end())
+        {
+            PathLossTable& table = pathLossTables[carrierFrequency];
+            for (int i = 0; i < table.getNumPoints(); i++)
+                table.setValue(i, calculatePathGain(carrierFrequency, table.getDistance(i)));
+            lastPathLossTable = &table;
+        }
+        else
+            lastPathLossTable = &it->second;
+        lastCarrierFrequency = carrierFrequency;
+    }
+
+    if (!lastPathLossTable->contains(distance))
+        return calculatePathGain(carrierFrequency, distance);
+    return lastPathLossTable->lookup(distance);
+}
+
+void FreeSpaceModel::generateFadingSamples(double *samples, int n)
+{
+    for (int i = 0; i < n; i++)
+        samples[i] = 1.0;
+}
+
 double FreeSpaceModel::calculateDistance(double pSend, double pRec, double carrierFrequency)
 {
   /** @brief
@@ -26,14 +26,18 @@
 #ifndef __FREE_SPACE_MODEL_H__
 #define __FREE_SPACE_MODEL_H__
 
+#include <algorithm>
 #include <list>
+#include <map>
 #include <string>
+#include <vector>
 #include <math.h>
 
 #include "INETDefs.h"
 
 #include "FWMath.h"
 #include "IReceptionModel.h"
+#include "PathLossTable.h"
 
 using namespace std;
 
@@ -43,6 +47,14 @@ using namespace std;
  * This Class implements the FreeSpace PropagationModel
  * This is a deterministic Propagation Model
  *
+ * It is also the base class of the models that add fading to the free space
+ * path loss. If the usePathLossTable parameter of the radio is set, the
+ * deterministic path gain is looked up in a table precomputed for each
+ * carrier frequency (see PathLossTable), and the fading of the subclasses
+ * is drawn in batches (see generateFadingSamples()). The received power then
+ * differs from the analytic calculation by the interpolation error of the
+ * table, and never exceeds the transmitted power.
+ *
  * @author Oliver Graute
  *
  * @ingroup snrEvalwithPropagation */
@@ -52,6 +64,7 @@ using namespace std;
 class INET_API FreeSpaceModel : public IReceptionModel {
 
 public:
+    FreeSpaceModel();
     virtual void initializeFrom(cModule *radioModule);
     /**
      * To be redefined to calculate the received power of a transmission.
@@ -65,6 +78,36 @@ public:
         double pathLossAlpha;
         virtual void initializeFreeSpace(cModule *);
         virtual double freeSpace(double Gt, double Gr, double L, double Pt, double lambda, double distance, double pathLossAlpha);
+
+        /** @name Tabulated mode */
+        //@{
+        bool usePathLossTable;
+        std::map<double, PathLossTable> pathLossTables;  // indexed by carrier frequency
+        double lastCarrierFrequency;
+        const PathLossTable *lastPathLossTable;
+        std::vector<double> fadingSamples;
+        unsigned int numFadingSamplesUsed;
+
+        /** Returns the deterministic ratio of received and transmitted power, used to fill the tables */
+        virtual double calculatePathGain(double carrierFrequency, double distance);
+
+        /** Returns calculatePathGain(), interpolated from the table of the carrier frequency */
+        double getPathGain(double carrierFrequency, double distance);
+
+        /** Fills samples with random factors of unit mean that model the fading; the default is 1 */
+        virtual void generateFadingSamples(double *samples, int n);
+
+        /** Returns the next fading factor, generating a new batch when needed */
+        double getFadingSample()
+        {
+            if (numFadingSamplesUsed == fadingSamples.size())
+            {
+                generateFadingSamples(&fadingSamples[0], fadingSamples.size());
+                numFadingSamplesUsed = 0;
+            }
+            return fadingSamples[numFadingSamplesUsed++];
+        }
+        //@}
 };
 
 
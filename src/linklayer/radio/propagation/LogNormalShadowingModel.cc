@@ -35,6 +35,9 @@ void LogNormalShadowingModel::initializeFrom(cModule *radioModule)
 
 double LogNormalShadowingModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
 {
+    if (usePathLossTable)
+        return std::min(pSend * getPathGain(carrierFrequency, distance) * getFadingSample(), pSend);
+
     double waveLength = SPEED_OF_LIGHT / carrierFrequency;
     double d0 = 1.0;
 
@@ -59,3 +62,9 @@ double LogNormalShadowingModel::calculateReceivedPower(double pSend, double carr
     return prec;
 }
 
+void LogNormalShadowingModel::generateFadingSamples(double *samples, int n)
+{
+    // the shadowing is a normally distributed path loss in dB
+    for (int i = 0; i < n; i++)
+        samples[i] = pow(10, -normal(0.0, sigma) / 10.0);
+}
@@ -37,6 +37,9 @@ class INET_API LogNormalShadowingModel : public FreeSpaceModel {
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
 
+    protected:
+    virtual void generateFadingSamples(double *samples, int n);
+
     private:
     double sigma;
 
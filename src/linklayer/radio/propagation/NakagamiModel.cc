@@ -35,6 +35,9 @@ void NakagamiModel::initializeFrom(cModule *radioModule)
 
 double NakagamiModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
 {
+    if (usePathLossTable)
+        return std::min(pSend * getPathGain(carrierFrequency, distance) * getFadingSample(), pSend);
+
     const int rng = 0;
     double waveLength = SPEED_OF_LIGHT / carrierFrequency;
 
@@ -45,3 +48,10 @@ double NakagamiModel::calculateReceivedPower(double pSend, double carrierFrequen
         prec = pSend;
      return prec;
 }
+
+void NakagamiModel::generateFadingSamples(double *samples, int n)
+{
+    const int rng = 0;
+    for (int i = 0; i < n; i++)
+        samples[i] = gamma_d(m, 1.0 / m, rng);
+}
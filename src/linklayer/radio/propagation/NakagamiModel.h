@@ -39,6 +39,8 @@ class INET_API NakagamiModel : public FreeSpaceModel {
 
     protected:
     double m;
+
+    virtual void generateFadingSamples(double *samples, int n);
     private:
 
 };
@@ -0,0 +1,36 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "PathLossTable.h"
+
+
+PathLossTable::PathLossTable(double minDistance, double maxDistance, int pointsPerOctave)
+{
+    if (minDistance <= 0 || maxDistance <= minDistance)
+        throw cRuntimeError("PathLossTable: invalid distance range [%g, %g]", minDistance, maxDistance);
+    if (pointsPerOctave <= 0 || (pointsPerOctave & (pointsPerOctave - 1)) != 0)
+        throw cRuntimeError("PathLossTable: pointsPerOctave must be a power of two, got %d", pointsPerOctave);
+
+    int maxExponent;
+    frexp(minDistance, &minExponent);
+    frexp(maxDistance, &maxExponent);
+    if (ldexp(1.0, maxExponent - 1) == maxDistance)
+        maxExponent--;
+
+    this->pointsPerOctave = pointsPerOctave;
+    this->minDistance = ldexp(1.0, minExponent - 1);
+    this->maxDistance = ldexp(1.0, maxExponent);
+    values.resize((maxExponent - minExponent + 1) * pointsPerOctave + 1);
+}
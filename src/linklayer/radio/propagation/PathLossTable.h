@@ -0,0 +1,89 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_PATHLOSSTABLE_H
+#define __INET_PATHLOSSTABLE_H
+
+#include <math.h>
+#include <vector>
+
+#include "INETDefs.h"
+
+/**
+ * Path gain (received power / transmitted power) versus distance, sampled
+ * at a fixed number of points per octave of distance and linearly
+ * interpolated between them. Within an octave the points are equally
+ * spaced, so finding the segment of a distance only needs its binary
+ * exponent (frexp) instead of a logarithm.
+ *
+ * With N points per octave the spacing is at most distance/N, so for a
+ * power law gain ~ d^-alpha the relative interpolation error is below
+ * alpha*(alpha+1)/(8*N^2): 0.0008 dB for alpha=2 and N=64.
+ *
+ * The owner fills the table: setValue(i, gain(getDistance(i))) for every
+ * point. Distances outside the covered range are not handled by the table,
+ * see contains().
+ */
+class INET_API PathLossTable
+{
+  protected:
+    int pointsPerOctave;
+    int minExponent;    // the table starts at 2^(minExponent-1)
+    double minDistance;
+    double maxDistance;
+    std::vector<double> values;
+
+  public:
+    /**
+     * Creates a table covering [minDistance, maxDistance], both rounded
+     * outwards to powers of two. pointsPerOctave must be a power of two.
+     */
+    PathLossTable(double minDistance = 1.0 / 16, double maxDistance = 1048576, int pointsPerOctave = 64);
+
+    int getNumPoints() const { return values.size(); }
+    double getMinDistance() const { return minDistance; }
+    double getMaxDistance() const { return maxDistance; }
+
+    double getDistance(int i) const
+    {
+        return ldexp(1.0 + (double)(i % pointsPerOctave) / pointsPerOctave, minExponent - 1 + i / pointsPerOctave);
+    }
+
+    void setValue(int i, double value) { values[i] = value; }
+
+    /**
+     * Returns whether the distance falls into the range of the table.
+     */
+    bool contains(double distance) const
+    {
+        return distance >= minDistance && distance < maxDistance;
+    }
+
+    /**
+     * Returns the interpolated value at the given distance, which must be
+     * within the range of the table.
+     */
+    double lookup(double distance) const
+    {
+        int exponent;
+        double mantissa = frexp(distance, &exponent);   // in [0.5, 1)
+        double x = (2 * mantissa - 1) * pointsPerOctave;
+        int j = (int)x;
+        int i = (exponent - minExponent) * pointsPerOctave + j;
+        return values[i] + (x - j) * (values[i + 1] - values[i]);
+    }
+};
+
+#endif
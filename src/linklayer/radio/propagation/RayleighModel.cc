@@ -39,6 +39,9 @@ RayleighModel::~RayleighModel() {
 
 double RayleighModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
 {
+    if (usePathLossTable)
+        return std::min(pSend * getPathGain(carrierFrequency, distance) * getFadingSample(), pSend);
+
     double waveLength = SPEED_OF_LIGHT / carrierFrequency;
     double avg_rx_power = freeSpace(Gt, Gr, L, pSend, waveLength, distance, pathLossAlpha);
 
@@ -51,3 +54,10 @@ double RayleighModel::calculateReceivedPower(double pSend, double carrierFrequen
 
 }
 
+void RayleighModel::generateFadingSamples(double *samples, int n)
+{
+    // 0.5*(x^2+y^2) with standard normal x and y is exponentially distributed
+    // with unit mean, which needs a single random number
+    for (int i = 0; i < n; i++)
+        samples[i] = exponential(1.0);
+}
@@ -53,6 +53,9 @@ public:
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
 
+    protected:
+    virtual void generateFadingSamples(double *samples, int n);
+
 };
 
 #endif /* __RAYLEIGH_H__ */
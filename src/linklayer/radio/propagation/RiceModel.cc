@@ -36,6 +36,9 @@ void RiceModel::initializeFrom(cModule *radioModule)
 
 double RiceModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
 {
+    if (usePathLossTable)
+        return std::min(pSend * getPathGain(carrierFrequency, distance) * getFadingSample(), pSend);
+
     double waveLength = SPEED_OF_LIGHT / carrierFrequency;
     double c = 1.0/(2.0*(K+1));
     double x = normal(0, 1);
@@ -49,5 +52,14 @@ double RiceModel::calculateReceivedPower(double pSend, double carrierFrequency,
 
 }
 
-
-
+void RiceModel::generateFadingSamples(double *samples, int n)
+{
+    double c = 1.0/(2.0*(K+1));
+    double s = sqrt(2*K);
+    for (int i = 0; i < n; i++)
+    {
+        double x = normal(0, 1);
+        double y = normal(0, 1);
+        samples[i] = c*((x + s)*(x + s) + y*y);
+    }
+}
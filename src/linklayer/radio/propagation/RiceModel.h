@@ -51,6 +51,9 @@ class INET_API RiceModel : public FreeSpaceModel {
      * To be redefined to calculate the received power of a transmission.
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
+
+    protected:
+    virtual void generateFadingSamples(double *samples, int n);
     private:
     /** @brief  Ricean K Factor */
     double K;
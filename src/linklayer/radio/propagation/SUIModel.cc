@@ -39,6 +39,31 @@ void SUIModel::initializeFrom(cModule *radioModule)
 }
 
 double SUIModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
+{
+    if (usePathLossTable)
+        return std::min(pSend * getPathGain(carrierFrequency, distance), pSend);
+
+    double Pr = 0.0;        // [dBm]
+    double Pt = 10*log10(pSend/1);  // [dBm]
+    double prec = 0.0;     // [mW]
+
+    Pr = Pt + Gt + Gr - calculatePathLoss(carrierFrequency, distance);
+
+    prec = pow(10, Pr/10.0); // [dBm]->[mW]
+
+
+    if (prec > pSend)
+        prec = pSend;
+    return prec;
+
+}
+
+double SUIModel::calculatePathGain(double carrierFrequency, double distance)
+{
+    return pow(10, (Gt + Gr - calculatePathLoss(carrierFrequency, distance))/10.0);
+}
+
+double SUIModel::calculatePathLoss(double carrierFrequency, double distance)
 {
     /*
      * Terrain A - Highest path loss. Dense populated urban area.
@@ -54,9 +79,6 @@ double SUIModel::calculateReceivedPower(double pSend, double carrierFrequency, d
     double R = distance;    // [m]
     double R0 = 100.0;      // [m]
     double lambda = SPEED_OF_LIGHT / carrierFrequency;
-    double Pr = 0.0;        // [dBm]
-    double Pt = 10*log10(pSend/1);  // [dBm]
-    double prec = 0.0;     // [mW]
     double L = 0.0;        // [dBm]
     double f = carrierFrequency / 1000000000.0; // [GHz]
 
@@ -78,16 +100,5 @@ double SUIModel::calculateReceivedPower(double pSend, double carrierFrequency, d
         L = 20 * log10( (4*M_PI*R) / lambda ) + s;
     }
 
-    Pr = Pt + Gt + Gr - L;
-
-    prec = pow(10, Pr/10.0); // [dBm]->[mW]
-
-
-    if (prec > pSend)
-        prec = pSend;
-    return prec;
-
+    return L;
 }
-
-
-
@@ -50,6 +50,10 @@ public:
      * To be redefined to calculate the received power of a transmission.
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
+protected:
+    virtual double calculatePathGain(double carrierFrequency, double distance);
+    /** @brief  Returns the path loss in dB */
+    virtual double calculatePathLoss(double carrierFrequency, double distance);
 private:
     /** @brief  Terrain type */
     string terrain;
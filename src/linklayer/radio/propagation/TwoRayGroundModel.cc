@@ -39,6 +39,9 @@ TwoRayGroundModel::~TwoRayGroundModel()
 
 double TwoRayGroundModel::calculateReceivedPower(double pSend, double carrierFrequency, double distance)
 {
+    if (usePathLossTable)
+        return std::min(pSend * getPathGain(carrierFrequency, distance), pSend);
+
     double waveLength = SPEED_OF_LIGHT / carrierFrequency;
 
     if (distance == 0)
@@ -84,3 +87,15 @@ double TwoRayGroundModel::calculateReceivedPower(double pSend, double carrierFre
         return prec;
     }
 }
+
+double TwoRayGroundModel::calculatePathGain(double carrierFrequency, double distance)
+{
+    double waveLength = SPEED_OF_LIGHT / carrierFrequency;
+    if (distance == 0)
+        return 1.0;
+    double dc = (4 * M_PI * ht * hr ) / waveLength;
+    if (distance < dc)
+        return freeSpace(Gt, Gr, L, 1.0, waveLength, distance, pathLossAlpha);
+    else
+        return (Gt * Gr * (ht * ht * hr * hr)) / (distance * distance * distance * distance * L);
+}
@@ -35,8 +35,10 @@ class INET_API TwoRayGroundModel : public FreeSpaceModel {
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
 
-    private:
+    protected:
     double ht, hr;
+
+    virtual double calculatePathGain(double carrierFrequency, double distance);
 };
 
 #endif /* __TWO_RAY_GROUND_H__ */
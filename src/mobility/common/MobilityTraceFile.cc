@@ -0,0 +1,207 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "MobilityTraceFile.h"
+
+static const char MAGIC[8] = { 'I', 'N', 'E', 'T', 'M', 'T', 'R', 'C' };
+static const uint32 VERSION = 1;
+static const uint32 BYTE_ORDER_MARK = 0x01020304;
+
+MobilityTraceFile::FileMap MobilityTraceFile::openFiles;
+
+MobilityTraceFile::MobilityTraceFile(const char *filename) : filename(filename)
+{
+    refCount = 0;
+    data = NULL;
+    length = 0;
+    mappingHandle = NULL;
+    header = NULL;
+    nodeStart = NULL;
+    initialPositions = columnData = NULL;
+    mapFile();
+    try {
+        checkContents();
+    }
+    catch (...) {
+        unmapFile();
+        throw;
+    }
+}
+
+MobilityTraceFile::~MobilityTraceFile()
+{
+    unmapFile();
+}
+
+#if defined(_WIN32)
+
+void MobilityTraceFile::mapFile()
+{
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throw cRuntimeError("Cannot open file '%s'", filename.c_str());
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        throw cRuntimeError("Cannot map file '%s': empty or unreadable", filename.c_str());
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping)
+        throw cRuntimeError("Cannot map file '%s'", filename.c_str());
+    data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        throw cRuntimeError("Cannot map file '%s'", filename.c_str());
+    }
+    mappingHandle = mapping;
+    length = (size_t)size.QuadPart;
+}
+
+void MobilityTraceFile::unmapFile()
+{
+    if (data) {
+        UnmapViewOfFile(data);
+        CloseHandle((HANDLE)mappingHandle);
+        data = NULL;
+        mappingHandle = NULL;
+    }
+}
+
+#else
+
+void MobilityTraceFile::mapFile()
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw cRuntimeError("Cannot open file '%s'", filename.c_str());
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw cRuntimeError("Cannot map file '%s': empty or unreadable", filename.c_str());
+    }
+    // the mapping stays valid after the descriptor is closed
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        throw cRuntimeError("Cannot map file '%s'", filename.c_str());
+    data = (const char *)p;
+    length = st.st_size;
+}
+
+void MobilityTraceFile::unmapFile()
+{
+    if (data) {
+        munmap((void *)data, length);
+        data = NULL;
+    }
+}
+
+#endif
+
+void MobilityTraceFile::checkContents()
+{
+    const char *fname = filename.c_str();
+    if (length < sizeof(Header) || memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+        throw cRuntimeError("'%s' is not a binary mobility trace file", fname);
+    header = (const Header *)data;
+    if (header->byteOrderMark != BYTE_ORDER_MARK)
+        throw cRuntimeError("Mobility trace file '%s' was created on a machine with different byte order, please convert it again", fname);
+    if (header->version != VERSION)
+        throw cRuntimeError("Mobility trace file '%s' has unsupported version %u", fname, (unsigned int)header->version);
+    if (header->type != BONNMOTION && header->type != NS2)
+        throw cRuntimeError("Mobility trace file '%s' has unknown trace type %u", fname, (unsigned int)header->type);
+    if (header->numColumns < 1 || header->numColumns > MAX_COLUMNS)
+        throw cRuntimeError("Mobility trace file '%s' has invalid number of columns %u", fname, (unsigned int)header->numColumns);
+
+    // compare in doubles, so that corrupt counts cannot overflow the calculation
+    double numNodes = header->numNodes;
+    double numRecords = (double)header->numRecords;
+    double expectedLength = sizeof(Header) + 8 * (numNodes + 1) + 8 * 3 * numNodes + 8 * numRecords * header->numColumns;
+    if (expectedLength != (double)length)
+        throw cRuntimeError("Mobility trace file '%s' is truncated or corrupt: size is %lu bytes instead of %.0f", fname, (unsigned long)length, expectedLength);
+
+    nodeStart = (const uint64 *)(data + sizeof(Header));
+    initialPositions = (const double *)(nodeStart + header->numNodes + 1);
+    columnData = initialPositions + 3 * header->numNodes;
+
+    if (nodeStart[0] != 0 || nodeStart[header->numNodes] != header->numRecords)
+        throw cRuntimeError("Mobility trace file '%s' is corrupt: invalid node index", fname);
+    for (uint32 i = 0; i < header->numNodes; i++)
+        if (nodeStart[i] > nodeStart[i + 1] || nodeStart[i + 1] - nodeStart[i] > 0x7fffffff)
+            throw cRuntimeError("Mobility trace file '%s' is corrupt: invalid node index", fname);
+}
+
+bool MobilityTraceFile::isMobilityTraceFile(const char *filename)
+{
+    FILE *f = fopen(filename, "rb");
+    if (!f)
+        return false;
+    char magic[sizeof(MAGIC)];
+    bool result = fread(magic, 1, sizeof(magic), f) == sizeof(magic) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+    fclose(f);
+    return result;
+}
+
+const MobilityTraceFile *MobilityTraceFile::open(const char *filename)
+{
+    FileMap::iterator it = openFiles.find(filename);
+    MobilityTraceFile *file;
+    if (it != openFiles.end())
+        file = it->second;
+    else {
+        file = new MobilityTraceFile(filename);
+        openFiles[filename] = file;
+    }
+    file->refCount++;
+    return file;
+}
+
+void MobilityTraceFile::close(const MobilityTraceFile *file)
+{
+    FileMap::iterator it = openFiles.find(file->filename);
+    ASSERT(it != openFiles.end() && it->second == file);
+    if (--it->second->refCount == 0) {
+        delete it->second;
+        openFiles.erase(it);
+    }
+}
+
+MobilityTraceFile::Records MobilityTraceFile::getRecords(int nodeId) const
+{
+    if (nodeId < 0 || nodeId >= (int)header->numNodes)
+        throw cRuntimeError("Invalid nodeId %d -- no such node in mobility trace file '%s'", nodeId, filename.c_str());
+    Records records;
+    uint64 start = nodeStart[nodeId];
+    for (uint32 i = 0; i < header->numColumns; i++)
+        records.columns[i] = columnData + i * header->numRecords + start;
+    records.size = (int)(nodeStart[nodeId + 1] - start);
+    return records;
+}
+
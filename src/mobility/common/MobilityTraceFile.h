@@ -0,0 +1,145 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_MOBILITYTRACEFILE_H
+#define __INET_MOBILITYTRACEFILE_H
+
+#include <map>
+#include <string>
+
+#include "INETDefs.h"
+
+
+/**
+ * A mobility trace in binary columnar format, mapped into memory read-only
+ * and shared by all mobility modules that use the same file. Such files are
+ * created from BonnMotion and ns-2 traces with etc/convert-mobility-trace.py,
+ * and are recognized by BonnMotionMobility and Ns2MotionMobility by their
+ * magic number.
+ *
+ * The trace is a table of records (BonnMotion waypoints: time, x, y[, z];
+ * ns-2 setdest commands: time, x, y, speed) grouped by node. Every column
+ * of the table is stored contiguously, so the records of a node occupy the
+ * same index range in every column. Layout, in native byte order:
+ *
+ *   char magic[8]                      "INETMTRC"
+ *   uint32 version                     1
+ *   uint32 byteOrderMark               0x01020304
+ *   uint32 type                        1: BonnMotion, 2: ns-2
+ *   uint32 numColumns                  1..4
+ *   uint32 numNodes
+ *   uint32 reserved                    0
+ *   uint64 numRecords
+ *   uint64 nodeStart[numNodes + 1]     index of the first record of each node
+ *   double initialPosition[numNodes][3]  ns-2 "set X_/Y_/Z_" values, -1 if missing
+ *   double column[numColumns][numRecords]
+ *
+ * @ingroup mobility
+ */
+class INET_API MobilityTraceFile
+{
+  public:
+    enum Type { BONNMOTION = 1, NS2 = 2 };
+    enum { MAX_COLUMNS = 4 };
+
+    /**
+     * The records of one node; get(i, c) returns column c of the i-th record.
+     * Also used for traces parsed from text, where the values of a record
+     * are adjacent (stride = number of columns).
+     */
+    struct Records
+    {
+        const double *columns[MAX_COLUMNS];
+        int stride;
+        int size;
+
+        Records() : stride(1), size(0) { for (int i = 0; i < MAX_COLUMNS; i++) columns[i] = NULL; }
+        double get(int i, int column) const { return columns[column][i * stride]; }
+    };
+
+  protected:
+    struct Header
+    {
+        char magic[8];
+        uint32 version;
+        uint32 byteOrderMark;
+        uint32 type;
+        uint32 numColumns;
+        uint32 numNodes;
+        uint32 reserved;
+        uint64 numRecords;
+    };
+
+    std::string filename;
+    int refCount;
+    const char *data;
+    size_t length;
+    void *mappingHandle;  // Windows only
+    const Header *header;
+    const uint64 *nodeStart;
+    const double *initialPositions;
+    const double *columnData;
+
+    typedef std::map<std::string, MobilityTraceFile *> FileMap;
+    static FileMap openFiles;
+
+  protected:
+    MobilityTraceFile(const char *filename);
+    virtual ~MobilityTraceFile();
+    virtual void mapFile();
+    virtual void unmapFile();
+    virtual void checkContents();
+
+  private:
+    MobilityTraceFile(const MobilityTraceFile&);
+    MobilityTraceFile& operator=(const MobilityTraceFile&);
+
+  public:
+    /**
+     * Returns true if the file exists and starts with the magic number
+     * of the binary trace format.
+     */
+    static bool isMobilityTraceFile(const char *filename);
+
+    /**
+     * Returns the mapped trace file, mapping it on the first call. Every call
+     * must be paired with a close().
+     */
+    static const MobilityTraceFile *open(const char *filename);
+
+    /**
+     * Releases the file; it is unmapped when the last user closes it.
+     */
+    static void close(const MobilityTraceFile *file);
+
+    const char *getFileName() const { return filename.c_str(); }
+    Type getType() const { return (Type)header->type; }
+    int getNumColumns() const { return header->numColumns; }
+    int getNumNodes() const { return header->numNodes; }
+
+    /**
+     * Returns the records of the given node; nodeId must be in 0..getNumNodes()-1.
+     */
+    Records getRecords(int nodeId) const;
+
+    /**
+     * Returns the x, y, z initial position of the given node (ns-2 traces);
+     * missing coordinates are -1.
+     */
+    const double *getInitialPosition(int nodeId) const { return initialPositions + 3 * nodeId; }
+};
+
+#endif
+
@@ -0,0 +1,87 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "MobilityUpdateScheduler.h"
+
+#include "MovingMobilityBase.h"
+
+#ifdef WITH_RADIO
+#include "IChannelControl.h"
+#endif
+
+
+Define_Module(MobilityUpdateScheduler);
+
+MobilityUpdateScheduler::MobilityUpdateScheduler()
+{
+    updateTimer = NULL;
+    channelControl = NULL;
+}
+
+MobilityUpdateScheduler::~MobilityUpdateScheduler()
+{
+    cancelAndDelete(updateTimer);
+}
+
+void MobilityUpdateScheduler::initialize()
+{
+    updateInterval = par("updateInterval");
+    if (updateInterval <= 0)
+        error("updateInterval must be positive");
+#ifdef WITH_RADIO
+    channelControl = dynamic_cast<IChannelControl *>(simulation.getModuleByPath("channelControl"));
+#endif
+    WATCH(updateInterval);
+
+    // the mobility modules start moving at initialization, like with their own timers
+    updateTimer = new cMessage("update");
+    scheduleAt(simTime() + updateInterval, updateTimer);
+}
+
+void MobilityUpdateScheduler::registerMobility(MovingMobilityBase *mobility)
+{
+    Enter_Method_Silent();
+    mobilityIds.push_back(mobility->getId());
+}
+
+void MobilityUpdateScheduler::handleMessage(cMessage *msg)
+{
+    if (msg != updateTimer)
+        error("Unexpected message '%s'", msg->getName());
+
+#ifdef WITH_RADIO
+    if (channelControl)
+        channelControl->beginPositionUpdates();
+#endif
+
+    // move all modules, dropping the ones that have been deleted meanwhile
+    unsigned int numLive = 0;
+    for (unsigned int i = 0; i < mobilityIds.size(); i++)
+    {
+        MovingMobilityBase *mobility = static_cast<MovingMobilityBase *>(simulation.getModule(mobilityIds[i]));
+        if (!mobility)
+            continue;
+        mobilityIds[numLive++] = mobilityIds[i];
+        mobility->handleScheduledUpdate();
+    }
+    mobilityIds.resize(numLive);
+
+#ifdef WITH_RADIO
+    if (channelControl)
+        channelControl->endPositionUpdates();
+#endif
+
+    scheduleAt(simTime() + updateInterval, updateTimer);
+}
@@ -0,0 +1,65 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_MOBILITYUPDATESCHEDULER_H
+#define __INET_MOBILITYUPDATESCHEDULER_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+class MovingMobilityBase;
+class IChannelControl;
+
+/**
+ * Performs the periodic updates of all moving mobility modules in a single
+ * event per update interval, and passes the new positions to ChannelControl
+ * as one batch. See the NED file for more info.
+ */
+class INET_API MobilityUpdateScheduler : public cSimpleModule
+{
+  protected:
+    simtime_t updateInterval;
+    cMessage *updateTimer;
+    std::vector<int> mobilityIds;       // module ids of the registered mobility modules, in registration order
+    IChannelControl *channelControl;    // NULL if there is none
+
+  public:
+    MobilityUpdateScheduler();
+    virtual ~MobilityUpdateScheduler();
+
+    /**
+     * Lets the scheduler perform the periodic updates of the given mobility
+     * module. Deleted modules are dropped automatically.
+     */
+    virtual void registerMobility(MovingMobilityBase *mobility);
+
+  protected:
+    virtual void initialize();
+    virtual void handleMessage(cMessage *msg);
+};
+
+class MobilityUpdateSchedulerAccess
+{
+    public:
+        MobilityUpdateSchedulerAccess() {
+        }
+
+        MobilityUpdateScheduler* getIfExists() {
+            return dynamic_cast<MobilityUpdateScheduler*>(simulation.getModuleByPath("mobilityUpdateScheduler"));
+        }
+};
+
+#endif
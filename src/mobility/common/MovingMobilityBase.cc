@@ -23,11 +23,14 @@
 
 #include "MovingMobilityBase.h"
 
+#include "MobilityUpdateScheduler.h"
+
 
 MovingMobilityBase::MovingMobilityBase()
 {
     moveTimer = NULL;
     updateInterval = 0;
+    useUpdateScheduler = false;
     stationary = false;
     lastSpeed = Coord::ZERO;
     lastUpdate = 0;
@@ -47,6 +50,11 @@ void MovingMobilityBase::initialize(int stage)
     if (stage == 0) {
         moveTimer = new cMessage("move");
         updateInterval = par("updateInterval");
+        MobilityUpdateScheduler *scheduler = MobilityUpdateSchedulerAccess().getIfExists();
+        if (scheduler && updateInterval != 0) {
+            scheduler->registerMobility(this);
+            useUpdateScheduler = true;
+        }
     }
 }
 
@@ -73,8 +81,28 @@ void MovingMobilityBase::handleSelfMessage(cMessage *message)
     scheduleUpdate();
 }
 
+void MovingMobilityBase::handleScheduledUpdate()
+{
+    Enter_Method_Silent();
+    if (!stationary) {
+        moveAndUpdate();
+        scheduleUpdate();
+    }
+}
+
 void MovingMobilityBase::scheduleUpdate()
 {
+    if (useUpdateScheduler) {
+        // only the next change needs a timer; it is left alone if it has not
+        // changed, to spare the event queue an operation on every update
+        if (nextChange == -1)
+            cancelEvent(moveTimer);
+        else if (!moveTimer->isScheduled() || moveTimer->getArrivalTime() != nextChange) {
+            cancelEvent(moveTimer);
+            scheduleAt(nextChange, moveTimer);
+        }
+        return;
+    }
     cancelEvent(moveTimer);
     if (!stationary && updateInterval != 0) {
         // periodic update is needed
@@ -45,6 +45,11 @@ class INET_API MovingMobilityBase : public MobilityBase
      * The 0 value turns off the signal. */
     simtime_t updateInterval;
 
+    /** @brief The periodic updates are performed by the MobilityUpdateScheduler module.
+     *
+     * The move timer is then only used for the mobility state changes. */
+    bool useUpdateScheduler;
+
     /** @brief A mobility model may decide to become stationary at any time.
      *
      * The true value disables sending self messages. */
@@ -86,6 +91,9 @@ class INET_API MovingMobilityBase : public MobilityBase
     virtual void move() = 0;
 
   public:
+    /** @brief Called by MobilityUpdateScheduler to perform a periodic update. */
+    virtual void handleScheduledUpdate();
+
     /** @brief Returns the current position at the current simulation time. */
     virtual Coord getCurrentPosition();
 
@@ -24,9 +24,7 @@
 
 const BonnMotionFile::Line *BonnMotionFile::getLine(int nodeId) const
 {
-    LineList::const_iterator it = lines.begin();
-    for (int i=0; i<nodeId && it!=lines.end(); i++) it++;
-    return (it==lines.end()) ? NULL : &(*it);
+    return (nodeId < 0 || nodeId >= (int)lines.size()) ? NULL : &lines[nodeId];
 }
 
 
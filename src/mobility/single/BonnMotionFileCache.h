@@ -19,7 +19,7 @@
 #ifndef BONN_MOTION_FILE_CACHE_H
 #define BONN_MOTION_FILE_CACHE_H
 
-#include <list>
+#include <deque>
 #include <vector>
 
 #include "INETDefs.h"
@@ -37,7 +37,7 @@ class INET_API BonnMotionFile
     typedef std::vector<double> Line;
   protected:
     friend class BonnMotionFileCache;
-    typedef std::list<Line> LineList;
+    typedef std::deque<Line> LineList;  // random access, and lines are not copied when it grows
     LineList lines;
   public:
     const Line *getLine(int nodeId) const;
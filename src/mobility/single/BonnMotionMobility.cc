@@ -27,12 +27,14 @@ Define_Module(BonnMotionMobility);
 BonnMotionMobility::BonnMotionMobility()
 {
     is3D = false;
-    lines = NULL;
-    currentLine = -1;
+    traceFile = NULL;
+    currentRecord = -1;
 }
 
 BonnMotionMobility::~BonnMotionMobility()
 {
+    if (traceFile)
+        MobilityTraceFile::close(traceFile);
     BonnMotionFileCache::deleteInstance();
 }
 
@@ -48,39 +50,55 @@ void BonnMotionMobility::initialize(int stage)
         if (nodeId == -1)
             nodeId = getContainingNode(this)->getIndex();
         const char *fname = par("traceFile");
-        const BonnMotionFile *bmFile = BonnMotionFileCache::getInstance()->getFile(fname);
-        lines = bmFile->getLine(nodeId);
-        if (!lines)
-            throw cRuntimeError("Invalid nodeId %d -- no such line in file '%s'", nodeId, fname);
-        currentLine = 0;
+        int numColumns = is3D ? 4 : 3;
+        if (MobilityTraceFile::isMobilityTraceFile(fname))
+        {
+            // shared memory-mapped trace, converted with etc/convert-mobility-trace.py
+            traceFile = MobilityTraceFile::open(fname);
+            if (traceFile->getType() != MobilityTraceFile::BONNMOTION || traceFile->getNumColumns() != numColumns)
+                throw cRuntimeError("Mobility trace file '%s' does not contain a %s BonnMotion trace", fname, is3D ? "3D" : "2D");
+            records = traceFile->getRecords(nodeId);
+        }
+        else
+        {
+            const BonnMotionFile *bmFile = BonnMotionFileCache::getInstance()->getFile(fname);
+            const BonnMotionFile::Line *line = bmFile->getLine(nodeId);
+            if (!line)
+                throw cRuntimeError("Invalid nodeId %d -- no such line in file '%s'", nodeId, fname);
+            // an incomplete waypoint at the end of the line is ignored
+            records.size = line->size() / numColumns;
+            records.stride = numColumns;
+            if (records.size > 0)
+                for (int i = 0; i < numColumns; i++)
+                    records.columns[i] = &(*line)[i];
+        }
+        currentRecord = 0;
     }
 }
 
 void BonnMotionMobility::setInitialPosition()
 {
-    const BonnMotionFile::Line& vec = *lines;
-    if (lines->size() >= 3)
+    if (records.size > 0)
     {
-        lastPosition.x = vec[1];
-        lastPosition.y = vec[2];
+        lastPosition.x = records.get(0, 1);
+        lastPosition.y = records.get(0, 2);
     }
 }
 
 void BonnMotionMobility::setTargetPosition()
 {
-    const BonnMotionFile::Line& vec = *lines;
-    if (currentLine + (is3D ? 3 : 2) >= (int)vec.size())
+    if (currentRecord >= records.size)
     {
         nextChange = -1;
         stationary = true;
         targetPosition = lastPosition;
         return;
     }
-    nextChange = vec[currentLine];
-    targetPosition.x = vec[currentLine+1];
-    targetPosition.y = vec[currentLine+2];
-    targetPosition.z = is3D ? vec[currentLine+3] : 0;
-    currentLine += (is3D ? 4 : 3);
+    nextChange = records.get(currentRecord, 0);
+    targetPosition.x = records.get(currentRecord, 1);
+    targetPosition.y = records.get(currentRecord, 2);
+    targetPosition.z = is3D ? records.get(currentRecord, 3) : 0;
+    currentRecord++;
 }
 
 void BonnMotionMobility::move()
@@ -22,6 +22,7 @@
 
 #include "LineSegmentsMobilityBase.h"
 #include "BonnMotionFileCache.h"
+#include "MobilityTraceFile.h"
 
 
 /**
@@ -35,8 +36,9 @@ class INET_API BonnMotionMobility : public LineSegmentsMobilityBase
   protected:
     // state
     bool is3D;
-    const BonnMotionFile::Line *lines;
-    int currentLine;
+    const MobilityTraceFile *traceFile;  // if the trace file is in binary format
+    MobilityTraceFile::Records records;  // waypoints: time, x, y[, z]
+    int currentRecord;
 
   protected:
     virtual int numInitStages() const { return 3; }
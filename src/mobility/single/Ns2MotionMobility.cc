@@ -37,6 +37,7 @@ Ns2MotionMobility::Ns2MotionMobility()
 {
     vecpos = 0;
     ns2File = NULL;
+    traceFile = NULL;
     nodeId = 0;
     scrollX = 0;
     scrollY = 0;
@@ -46,6 +47,8 @@ Ns2MotionMobility::~Ns2MotionMobility()
 {
     if (ns2File)
         delete ns2File;
+    if (traceFile)
+        MobilityTraceFile::close(traceFile);
 }
 
 void Ns2MotionMobility::parseFile(const char *filename)
@@ -105,18 +108,20 @@ void Ns2MotionMobility::parseFile(const char *filename)
         found = subline.find("setdest");
         if (found!=std::string::npos)
         {
-            ns2File->lines.push_back(Ns2MotionFile::Line());
-            Ns2MotionFile::Line& vec = ns2File->lines.back();
             // initial time
             found = subline.find("at");
-            vec.push_back(std::atof(subline.substr(found+3).c_str()));
+            double time = std::atof(subline.substr(found+3).c_str());
 
             std::string parameters = subline.substr(subline.find("setdest ")+8, std::string::npos);
 
             std::stringstream linestream(parameters);
-            double d;
-            while (linestream >> d)
-                vec.push_back(d);
+            double x, y, speed;
+            if (!(linestream >> x >> y >> speed))
+                throw cRuntimeError("node '%d' Error ns2 motion file '%s': invalid setdest command", nodeId, filename);
+            ns2File->values.push_back(time);
+            ns2File->values.push_back(x);
+            ns2File->values.push_back(y);
+            ns2File->values.push_back(speed);
         }
     }
     in.close();
@@ -139,8 +144,31 @@ void Ns2MotionMobility::initialize(int stage)
         if (nodeId == -1)
             nodeId = getContainingNode(this)->getIndex();
         const char *fname = par("traceFile");
-        ns2File = new Ns2MotionFile;
-        parseFile(fname);
+        if (MobilityTraceFile::isMobilityTraceFile(fname))
+        {
+            // shared memory-mapped trace, converted with etc/convert-mobility-trace.py
+            traceFile = MobilityTraceFile::open(fname);
+            if (traceFile->getType() != MobilityTraceFile::NS2 || traceFile->getNumColumns() != 4)
+                throw cRuntimeError("Mobility trace file '%s' does not contain an ns2 motion trace", fname);
+            records = traceFile->getRecords(nodeId);
+            const double *position = traceFile->getInitialPosition(nodeId);
+            if (position[0]==-1 || position[1]==-1 || position[2]==-1)
+                throw cRuntimeError("node '%d' Error ns2 motion file '%s'", nodeId, fname);
+            for (int i = 0; i < 3; i++)
+                initial[i] = position[i];
+        }
+        else
+        {
+            ns2File = new Ns2MotionFile;
+            parseFile(fname);
+            records.size = ns2File->values.size() / 4;
+            records.stride = 4;
+            if (records.size > 0)
+                for (int i = 0; i < 4; i++)
+                    records.columns[i] = &ns2File->values[i];
+            for (int i = 0; i < 3; i++)
+                initial[i] = ns2File->initial[i];
+        }
         vecpos = 0;
         WATCH(nodeId);
     }
@@ -148,34 +176,20 @@ void Ns2MotionMobility::initialize(int stage)
 
 void Ns2MotionMobility::setInitialPosition()
 {
-    lastPosition.x = ns2File->initial[0]+scrollX;
-    lastPosition.y = ns2File->initial[1]+scrollY;
+    lastPosition.x = initial[0]+scrollX;
+    lastPosition.y = initial[1]+scrollY;
 }
 
 void Ns2MotionMobility::setTargetPosition()
 {
 
-    if (ns2File->lines.size()==0)
-    {
-        stationary = true;
-        return;
-    }
-
-    if (vecpos >= ns2File->lines.size())
+    if (vecpos >= records.size)
     {
         stationary = true;
         return;
     }
 
-
-    if (ns2File->lines.begin()+vecpos == ns2File->lines.end())
-    {
-        stationary = true;
-        return;
-    }
-
-    const Ns2MotionFile::Line& vec = ns2File->lines[vecpos];
-    double time = vec[0];
+    double time = records.get(vecpos, 0);
     simtime_t now = simTime();
     // TODO: this code is dubious at best
     if (now < time)
@@ -183,19 +197,23 @@ void Ns2MotionMobility::setTargetPosition()
         nextChange = time;
         targetPosition = lastPosition;
     }
-    else if (vec[3] == 0) // the node is stopped
+    else if (records.get(vecpos, 3) == 0) // the node is stopped
     {
-        const Ns2MotionFile::Line& vec = ns2File->lines[vecpos+1];
-        double time = vec[0];
+        if (vecpos + 1 >= records.size)
+        {
+            stationary = true;
+            return;
+        }
+        double time = records.get(vecpos+1, 0);
         nextChange = time;
         targetPosition = lastPosition;
         vecpos++;
     }
     else
     {
-        targetPosition.x = vec[1]+scrollX;
-        targetPosition.y = vec[2]+scrollY;
-        double speed = vec[3];
+        targetPosition.x = records.get(vecpos, 1)+scrollX;
+        targetPosition.y = records.get(vecpos, 2)+scrollY;
+        double speed = records.get(vecpos, 3);
         double distance = lastPosition.distance(targetPosition);
         double travelTime = distance / speed;
         nextChange = now + travelTime;
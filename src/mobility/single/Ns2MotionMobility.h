@@ -24,6 +24,7 @@
 #include "INETDefs.h"
 
 #include "LineSegmentsMobilityBase.h"
+#include "MobilityTraceFile.h"
 
 
 /**
@@ -41,20 +42,21 @@ class Ns2MotionMobility;
 class INET_API Ns2MotionFile
 {
   public:
-    typedef std::vector<double> Line;
     double initial[3];
   protected:
     friend class Ns2MotionMobility;
-    typedef std::vector<Line> LineList;
-    LineList lines;
+    std::vector<double> values;  // time, x, y, speed of the node's setdest commands
 };
 
 class INET_API Ns2MotionMobility : public LineSegmentsMobilityBase
 {
   protected:
     // state
-    unsigned int vecpos;
+    int vecpos;
     Ns2MotionFile *ns2File;
+    const MobilityTraceFile *traceFile;  // if the trace file is in binary format
+    MobilityTraceFile::Records records;  // setdest commands: time, x, y, speed
+    double initial[3];
     int nodeId;
     double scrollX;
     double scrollY;
@@ -19,6 +19,8 @@
 //
 
 #include <set>
+#include <stdio.h>
+#include <string.h>
 #include "stlutils.h"
 #include "IRoutingTable.h"
 #include "IInterfaceTable.h"
@@ -87,6 +89,8 @@ void IPv4NetworkConfigurator::initialize(int stage)
         addSubnetRoutesParameter = par("addSubnetRoutes");
         addDefaultRoutesParameter = par("addDefaultRoutes");
         optimizeRoutesParameter = par("optimizeRoutes");
+        shortestPathThreadsParameter = par("shortestPathThreads");
+        cacheDirectoryParameter = par("cacheDirectory").stdstringValue();
         configuration = par("config");
     }
     else if (stage == 2)
@@ -101,6 +105,19 @@ void IPv4NetworkConfigurator::computeConfiguration()
     topology.clear();
     // extract topology into the IPv4Topology object, then fill in a LinkInfo[] vector
     T(extractTopology(topology));
+    // reuse the result of an earlier run if the network and the configuration are the same
+    uint64 hash = 0;
+    std::string cacheFileName;
+    if (!cacheDirectoryParameter.empty()) {
+        bool loaded;
+        T(hash = computeConfigurationHash(topology));
+        cacheFileName = getConfigurationCacheFileName(hash);
+        T(loaded = loadConfigurationCache(topology, cacheFileName.c_str(), hash));
+        if (loaded) {
+            printElapsedTime("initialize", initializeStartTime);
+            return;
+        }
+    }
     // read the configuration from XML; it will serve as input for address assignment
     T(readInterfaceConfiguration(topology));
     // assign addresses to IPv4 nodes
@@ -115,6 +132,9 @@ void IPv4NetworkConfigurator::computeConfiguration()
     // calculate shortest paths, and add corresponding static routes
     if (addStaticRoutesParameter)
         T(addStaticRoutes(topology));
+    // store the result for subsequent runs
+    if (!cacheFileName.empty())
+        T(saveConfigurationCache(topology, cacheFileName.c_str(), hash));
     printElapsedTime("initialize", initializeStartTime);
 }
 
@@ -124,6 +144,458 @@ void IPv4NetworkConfigurator::ensureConfigurationComputed(IPv4Topology& topology
         computeConfiguration();
 }
 
+// identifies configuration cache files, also detects files written on a machine with different byte order
+#define CACHE_FILE_MAGIC    0x49503443  // "IP4C"
+#define CACHE_FILE_VERSION  1
+
+namespace {
+
+/**
+ * Incremental 64-bit FNV-1a hash of the inputs of the configuration.
+ */
+class ConfigurationHash
+{
+    protected:
+        uint64 hash;
+
+    public:
+        ConfigurationHash() { hash = 14695981039346656037ULL; }
+        uint64 getHash() const { return hash; }
+
+        void add(const void *data, size_t length) {
+            const unsigned char *bytes = (const unsigned char *)data;
+            for (size_t i = 0; i < length; i++) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ULL;
+            }
+        }
+        void add(int64 value) { add(&value, sizeof(value)); }
+        void add(double value) { add(&value, sizeof(value)); }
+        void add(const char *s) {
+            // the length separates consecutive strings
+            int64 length = s ? strlen(s) : -1;
+            add(length);
+            if (s) add(s, length);
+        }
+        void add(const std::string& s) { add(s.c_str()); }
+};
+
+/**
+ * Collects binary data to be written into a configuration cache file.
+ */
+class CacheWriter
+{
+    protected:
+        std::vector<char> data;
+
+    public:
+        const std::vector<char>& getData() const { return data; }
+        template<typename T> void write(const T& value) {
+            const char *bytes = (const char *)&value;
+            data.insert(data.end(), bytes, bytes + sizeof(T));
+        }
+};
+
+/**
+ * Reads binary data from the contents of a configuration cache file.
+ * Reading past the end returns zeroes and clears the ok flag.
+ */
+class CacheReader
+{
+    protected:
+        const char *ptr;
+        const char *end;
+        bool ok;
+
+    public:
+        CacheReader(const std::vector<char>& data) { ptr = data.empty() ? NULL : &data[0]; end = ptr + data.size(); ok = true; }
+        bool isOk() const { return ok; }
+        bool isAtEnd() const { return ptr == end; }
+        template<typename T> T read() {
+            T value = T();
+            if ((size_t)(end - ptr) < sizeof(T)) {
+                ok = false;
+                ptr = end;
+            }
+            else {
+                memcpy(&value, ptr, sizeof(T));
+                ptr += sizeof(T);
+            }
+            return value;
+        }
+};
+
+struct CacheFileHeader
+{
+    uint32 magic;
+    uint32 version;
+    uint64 hash;            // the hash of the configuration inputs
+    uint64 length;          // length of the contents following the header
+    uint64 checksum;        // FNV-1a hash of the contents
+};
+
+// state restored from a cache file, applied only after the whole file has been read successfully
+struct CachedInterfaceInfo
+{
+    uint32 address;
+    uint32 addressSpecifiedBits;
+    uint32 netmask;
+    uint32 netmaskSpecifiedBits;
+    int mtu;
+    double metric;
+    uint8 flags;            // configure, addStaticRoute, addDefaultRoute, addSubnetRoute
+    std::vector<IPv4Address> multicastGroups;
+};
+
+struct CachedRoute
+{
+    uint32 destination;
+    uint32 netmask;
+    uint32 gateway;
+    InterfaceEntry *interfaceEntry;
+    int sourceType;
+    int metric;
+};
+
+struct CachedMulticastRoute
+{
+    uint32 origin;
+    uint32 originNetmask;
+    uint32 multicastGroup;
+    InterfaceEntry *inInterface;
+    std::vector<std::pair<InterfaceEntry *, bool> > outInterfaces;
+    int sourceType;
+    int metric;
+};
+
+}
+
+static void hashXMLElement(ConfigurationHash& hash, cXMLElement *element)
+{
+    if (!element) {
+        hash.add((int64)-1);
+        return;
+    }
+    hash.add(element->getTagName());
+    hash.add(element->getNodeValue());
+    cXMLAttributeMap attributes = element->getAttributes();
+    hash.add((int64)attributes.size());
+    for (cXMLAttributeMap::iterator it = attributes.begin(); it != attributes.end(); it++) {
+        hash.add(it->first);
+        hash.add(it->second);
+    }
+    for (cXMLElement *child = element->getFirstChild(); child; child = child->getNextSibling())
+        hashXMLElement(hash, child);
+    // end of children
+    hash.add((int64)-2);
+}
+
+uint64 IPv4NetworkConfigurator::computeConfigurationHash(IPv4Topology& topology)
+{
+    ConfigurationHash hash;
+    hash.add((int64)CACHE_FILE_VERSION);
+    hash.add((int64)assignAddressesParameter);
+    hash.add((int64)assignDisjunctSubnetAddressesParameter);
+    hash.add((int64)addStaticRoutesParameter);
+    hash.add((int64)addSubnetRoutesParameter);
+    hash.add((int64)addDefaultRoutesParameter);
+    hash.add((int64)optimizeRoutesParameter);
+    hashXMLElement(hash, configuration);
+
+    // nodes with their interfaces, and the links of the graph
+    std::map<Topology::Node *, int> nodeIndices;
+    for (int i = 0; i < topology.getNumNodes(); i++)
+        nodeIndices[topology.getNode(i)] = i;
+    hash.add((int64)topology.getNumNodes());
+    for (int i = 0; i < topology.getNumNodes(); i++) {
+        Node *node = (Node *)topology.getNode(i);
+        hash.add(node->module->getFullPath());
+        hash.add(node->getWeight());
+        hash.add((int64)(node->routingTable != NULL));
+        IInterfaceTable *interfaceTable = node->interfaceTable;
+        hash.add((int64)(interfaceTable ? interfaceTable->getNumInterfaces() : -1));
+        for (int j = 0; interfaceTable && j < interfaceTable->getNumInterfaces(); j++) {
+            InterfaceEntry *interfaceEntry = interfaceTable->getInterface(j);
+            hash.add(interfaceEntry->getName());
+            hash.add((int64)interfaceEntry->getInterfaceId());
+            hash.add((int64)interfaceEntry->isLoopback());
+            hash.add((int64)interfaceEntry->isMulticast());
+            hash.add((int64)interfaceEntry->getMTU());
+            IPv4InterfaceData *interfaceData = interfaceEntry->ipv4Data();
+            hash.add((int64)(interfaceData != NULL));
+            if (interfaceData) {
+                hash.add((int64)interfaceData->getIPAddress().getInt());
+                hash.add((int64)interfaceData->getNetmask().getInt());
+            }
+        }
+        hash.add((int64)node->getNumOutLinks());
+        for (int j = 0; j < node->getNumOutLinks(); j++) {
+            Topology::LinkOut *linkOut = node->getLinkOut(j);
+            hash.add((int64)nodeIndices[linkOut->getRemoteNode()]);
+            hash.add((int64)linkOut->getLocalGateId());
+            hash.add((int64)linkOut->getRemoteGateId());
+            hash.add(linkOut->getWeight());
+        }
+    }
+
+    // network links, their interfaces and gateways
+    hash.add((int64)topology.linkInfos.size());
+    for (int i = 0; i < (int)topology.linkInfos.size(); i++) {
+        LinkInfo *linkInfo = topology.linkInfos[i];
+        hash.add((int64)linkInfo->interfaceInfos.size());
+        for (int j = 0; j < (int)linkInfo->interfaceInfos.size(); j++) {
+            InterfaceInfo *interfaceInfo = linkInfo->interfaceInfos[j];
+            hash.add((int64)nodeIndices[interfaceInfo->node]);
+            hash.add((int64)interfaceInfo->interfaceEntry->getInterfaceId());
+        }
+        hash.add((int64)(linkInfo->gatewayInterfaceInfo ? linkInfo->gatewayInterfaceInfo->interfaceEntry->getInterfaceId() : -1));
+    }
+    return hash.getHash();
+}
+
+std::string IPv4NetworkConfigurator::getConfigurationCacheFileName(uint64 hash)
+{
+    char name[32];
+    sprintf(name, "%08x%08x.ipv4config", (unsigned int)(hash >> 32), (unsigned int)hash);
+    std::string fileName = cacheDirectoryParameter;
+    if (fileName[fileName.length() - 1] != '/')
+        fileName += "/";
+    return fileName + name;
+}
+
+bool IPv4NetworkConfigurator::loadConfigurationCache(IPv4Topology& topology, const char *fileName, uint64 hash)
+{
+    FILE *f = fopen(fileName, "rb");
+    if (!f)
+        return false;
+    CacheFileHeader header;
+    std::vector<char> data;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+              header.magic == CACHE_FILE_MAGIC && header.version == CACHE_FILE_VERSION && header.hash == hash;
+    if (ok) {
+        data.resize(header.length);
+        ok = header.length == 0 || fread(&data[0], header.length, 1, f) == 1;
+    }
+    fclose(f);
+    if (ok) {
+        // protects against truncated files and files written concurrently by another process
+        ConfigurationHash checksum;
+        if (!data.empty()) checksum.add(&data[0], data.size());
+        ok = checksum.getHash() == header.checksum;
+    }
+    if (!ok) {
+        EV_WARN << "Ignoring invalid or outdated configuration cache file " << fileName << endl;
+        return false;
+    }
+
+    CacheReader reader(data);
+    int numInterfaceInfos = 0;
+    for (int i = 0; i < (int)topology.linkInfos.size(); i++)
+        numInterfaceInfos += topology.linkInfos[i]->interfaceInfos.size();
+    if (reader.read<uint32>() != (uint32)topology.getNumNodes() || reader.read<uint32>() != (uint32)numInterfaceInfos)
+        return false;
+
+    // interfaces in the order of the links
+    std::vector<CachedInterfaceInfo> interfaceInfos(numInterfaceInfos);
+    for (int i = 0; i < numInterfaceInfos && reader.isOk(); i++) {
+        CachedInterfaceInfo& interfaceInfo = interfaceInfos[i];
+        interfaceInfo.address = reader.read<uint32>();
+        interfaceInfo.addressSpecifiedBits = reader.read<uint32>();
+        interfaceInfo.netmask = reader.read<uint32>();
+        interfaceInfo.netmaskSpecifiedBits = reader.read<uint32>();
+        interfaceInfo.mtu = reader.read<int32>();
+        interfaceInfo.metric = reader.read<double>();
+        interfaceInfo.flags = reader.read<uint8>();
+        uint32 numMulticastGroups = reader.read<uint32>();
+        for (uint32 j = 0; j < numMulticastGroups && reader.isOk(); j++)
+            interfaceInfo.multicastGroups.push_back(IPv4Address(reader.read<uint32>()));
+    }
+
+    // routes of each node, interfaces are stored by id
+    std::vector<std::vector<CachedRoute> > routes(topology.getNumNodes());
+    std::vector<std::vector<CachedMulticastRoute> > multicastRoutes(topology.getNumNodes());
+    for (int i = 0; i < topology.getNumNodes() && reader.isOk(); i++) {
+        Node *node = (Node *)topology.getNode(i);
+        uint32 numRoutes = reader.read<uint32>();
+        for (uint32 j = 0; j < numRoutes && reader.isOk(); j++) {
+            CachedRoute route;
+            route.destination = reader.read<uint32>();
+            route.netmask = reader.read<uint32>();
+            route.gateway = reader.read<uint32>();
+            int interfaceId = reader.read<int32>();
+            route.interfaceEntry = interfaceId == -1 || !node->interfaceTable ? NULL : node->interfaceTable->getInterfaceById(interfaceId);
+            route.sourceType = reader.read<int32>();
+            route.metric = reader.read<int32>();
+            if (interfaceId != -1 && !route.interfaceEntry)
+                return false;
+            routes[i].push_back(route);
+        }
+        uint32 numMulticastRoutes = reader.read<uint32>();
+        for (uint32 j = 0; j < numMulticastRoutes && reader.isOk(); j++) {
+            CachedMulticastRoute route;
+            route.origin = reader.read<uint32>();
+            route.originNetmask = reader.read<uint32>();
+            route.multicastGroup = reader.read<uint32>();
+            int inInterfaceId = reader.read<int32>();
+            route.inInterface = inInterfaceId == -1 || !node->interfaceTable ? NULL : node->interfaceTable->getInterfaceById(inInterfaceId);
+            if (inInterfaceId != -1 && !route.inInterface)
+                return false;
+            uint32 numOutInterfaces = reader.read<uint32>();
+            for (uint32 k = 0; k < numOutInterfaces && reader.isOk(); k++) {
+                int outInterfaceId = reader.read<int32>();
+                bool isLeaf = reader.read<uint8>();
+                InterfaceEntry *outInterface = node->interfaceTable ? node->interfaceTable->getInterfaceById(outInterfaceId) : NULL;
+                if (!outInterface)
+                    return false;
+                route.outInterfaces.push_back(std::make_pair(outInterface, isLeaf));
+            }
+            route.sourceType = reader.read<int32>();
+            route.metric = reader.read<int32>();
+            multicastRoutes[i].push_back(route);
+        }
+    }
+    if (!reader.isOk() || !reader.isAtEnd())
+        return false;
+
+    // everything has been read, update the configuration
+    int interfaceIndex = 0;
+    for (int i = 0; i < (int)topology.linkInfos.size(); i++) {
+        LinkInfo *linkInfo = topology.linkInfos[i];
+        for (int j = 0; j < (int)linkInfo->interfaceInfos.size(); j++) {
+            InterfaceInfo *interfaceInfo = linkInfo->interfaceInfos[j];
+            const CachedInterfaceInfo& cached = interfaceInfos[interfaceIndex++];
+            interfaceInfo->address = cached.address;
+            interfaceInfo->addressSpecifiedBits = cached.addressSpecifiedBits;
+            interfaceInfo->netmask = cached.netmask;
+            interfaceInfo->netmaskSpecifiedBits = cached.netmaskSpecifiedBits;
+            interfaceInfo->mtu = cached.mtu;
+            interfaceInfo->metric = cached.metric;
+            interfaceInfo->configure = cached.flags & 1;
+            interfaceInfo->addStaticRoute = cached.flags & 2;
+            interfaceInfo->addDefaultRoute = cached.flags & 4;
+            interfaceInfo->addSubnetRoute = cached.flags & 8;
+            interfaceInfo->multicastGroups = cached.multicastGroups;
+        }
+    }
+    for (int i = 0; i < topology.getNumNodes(); i++) {
+        Node *node = (Node *)topology.getNode(i);
+        for (int j = 0; j < (int)routes[i].size(); j++) {
+            const CachedRoute& cached = routes[i][j];
+            IPv4Route *route = new IPv4Route();
+            route->setDestination(IPv4Address(cached.destination));
+            route->setNetmask(IPv4Address(cached.netmask));
+            route->setGateway(IPv4Address(cached.gateway));
+            route->setInterface(cached.interfaceEntry);
+            route->setSourceType((IPv4Route::SourceType)cached.sourceType);
+            route->setMetric(cached.metric);
+            node->staticRoutes.push_back(route);
+        }
+        for (int j = 0; j < (int)multicastRoutes[i].size(); j++) {
+            const CachedMulticastRoute& cached = multicastRoutes[i][j];
+            IPv4MulticastRoute *route = new IPv4MulticastRoute();
+            route->setSourceType((IPv4MulticastRoute::SourceType)cached.sourceType);
+            route->setOrigin(IPv4Address(cached.origin));
+            route->setOriginNetmask(IPv4Address(cached.originNetmask));
+            route->setMulticastGroup(IPv4Address(cached.multicastGroup));
+            route->setInInterface(cached.inInterface ? new IPv4MulticastRoute::InInterface(cached.inInterface) : NULL);
+            route->setMetric(cached.metric);
+            for (int k = 0; k < (int)cached.outInterfaces.size(); k++)
+                route->addOutInterface(new IPv4MulticastRoute::OutInterface(cached.outInterfaces[k].first, cached.outInterfaces[k].second));
+            node->staticMulticastRoutes.push_back(route);
+        }
+    }
+    EV_INFO << "Loaded network configuration from cache file " << fileName << endl;
+    return true;
+}
+
+void IPv4NetworkConfigurator::saveConfigurationCache(IPv4Topology& topology, const char *fileName, uint64 hash)
+{
+    CacheWriter writer;
+    int numInterfaceInfos = 0;
+    for (int i = 0; i < (int)topology.linkInfos.size(); i++)
+        numInterfaceInfos += topology.linkInfos[i]->interfaceInfos.size();
+    writer.write<uint32>(topology.getNumNodes());
+    writer.write<uint32>(numInterfaceInfos);
+    for (int i = 0; i < (int)topology.linkInfos.size(); i++) {
+        LinkInfo *linkInfo = topology.linkInfos[i];
+        for (int j = 0; j < (int)linkInfo->interfaceInfos.size(); j++) {
+            InterfaceInfo *interfaceInfo = linkInfo->interfaceInfos[j];
+            writer.write<uint32>(interfaceInfo->address);
+            writer.write<uint32>(interfaceInfo->addressSpecifiedBits);
+            writer.write<uint32>(interfaceInfo->netmask);
+            writer.write<uint32>(interfaceInfo->netmaskSpecifiedBits);
+            writer.write<int32>(interfaceInfo->mtu);
+            writer.write<double>(interfaceInfo->metric);
+            writer.write<uint8>((interfaceInfo->configure ? 1 : 0) | (interfaceInfo->addStaticRoute ? 2 : 0) |
+                                (interfaceInfo->addDefaultRoute ? 4 : 0) | (interfaceInfo->addSubnetRoute ? 8 : 0));
+            writer.write<uint32>(interfaceInfo->multicastGroups.size());
+            for (int k = 0; k < (int)interfaceInfo->multicastGroups.size(); k++)
+                writer.write<uint32>(interfaceInfo->multicastGroups[k].getInt());
+        }
+    }
+    for (int i = 0; i < topology.getNumNodes(); i++) {
+        Node *node = (Node *)topology.getNode(i);
+        writer.write<uint32>(node->staticRoutes.size());
+        for (int j = 0; j < (int)node->staticRoutes.size(); j++) {
+            IPv4Route *route = node->staticRoutes[j];
+            writer.write<uint32>(route->getDestination().getInt());
+            writer.write<uint32>(route->getNetmask().getInt());
+            writer.write<uint32>(route->getGateway().getInt());
+            writer.write<int32>(route->getInterface() ? route->getInterface()->getInterfaceId() : -1);
+            writer.write<int32>(route->getSourceType());
+            writer.write<int32>(route->getMetric());
+        }
+        writer.write<uint32>(node->staticMulticastRoutes.size());
+        for (int j = 0; j < (int)node->staticMulticastRoutes.size(); j++) {
+            IPv4MulticastRoute *route = node->staticMulticastRoutes[j];
+            writer.write<uint32>(route->getOrigin().getInt());
+            writer.write<uint32>(route->getOriginNetmask().getInt());
+            writer.write<uint32>(route->getMulticastGroup().getInt());
+            writer.write<int32>(route->getInInterface() ? route->getInInterface()->getInterface()->getInterfaceId() : -1);
+            writer.write<uint32>(route->getNumOutInterfaces());
+            for (int k = 0; k < (int)route->getNumOutInterfaces(); k++) {
+                IPv4MulticastRoute::OutInterface *outInterface = route->getOutInterface(k);
+                writer.write<int32>(outInterface->getInterface()->getInterfaceId());
+                writer.write<uint8>(outInterface->isLeaf() ? 1 : 0);
+            }
+            writer.write<int32>(route->getSourceType());
+            writer.write<int32>(route->getMetric());
+        }
+    }
+
+    const std::vector<char>& data = writer.getData();
+    CacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CACHE_FILE_MAGIC;
+    header.version = CACHE_FILE_VERSION;
+    header.hash = hash;
+    header.length = data.size();
+    ConfigurationHash checksum;
+    if (!data.empty()) checksum.add(&data[0], data.size());
+    header.checksum = checksum.getHash();
+
+    // write into a temporary file and rename it, so that other processes never see a partially written file
+    // (the run number keeps parallel runs of a parameter study from writing the same temporary file)
+    std::string tempFileName = std::string(fileName) + ".tmp" + ev.getConfigEx()->getVariable(CFGVAR_RUNNUMBER);
+    FILE *f = fopen(tempFileName.c_str(), "wb");
+    bool ok = f != NULL;
+    if (ok) {
+        ok = fwrite(&header, sizeof(header), 1, f) == 1 && (data.empty() || fwrite(&data[0], data.size(), 1, f) == 1);
+        ok = fclose(f) == 0 && ok;
+    }
+    if (ok) {
+        // rename() does not replace existing files on Windows
+        remove(fileName);
+        ok = rename(tempFileName.c_str(), fileName) == 0;
+    }
+    if (!ok) {
+        remove(tempFileName.c_str());
+        EV_WARN << "Cannot write configuration cache file " << fileName << endl;
+    }
+    else
+        EV_INFO << "Saved network configuration to cache file " << fileName << endl;
+}
+
 void IPv4NetworkConfigurator::dumpConfiguration()
 {
     // print topology to module output
@@ -1727,132 +2199,155 @@ IPv4NetworkConfigurator::LinkInfo *IPv4NetworkConfigurator::findLinkOfInterface(
     return NULL;
 }
 
-bool IPv4NetworkConfigurator::containsRoute(const std::vector<IPv4Route *>& routes, IPv4Route *route)
+/**
+ * Orders routes by all fields compared by IPv4Route::equals().
+ */
+bool IPv4NetworkConfigurator::routeLessThan(const IPv4Route *a, const IPv4Route *b)
 {
-    for (int i = 0; i < (int)routes.size(); i++)
-        if (*routes.at(i) == *route)
-            return true;
-    return false;
+    if (a->getDestination() != b->getDestination())
+        return a->getDestination() < b->getDestination();
+    if (a->getNetmask() != b->getNetmask())
+        return a->getNetmask() < b->getNetmask();
+    if (a->getGateway() != b->getGateway())
+        return a->getGateway() < b->getGateway();
+    if (a->getInterface() != b->getInterface())
+        return a->getInterface() < b->getInterface();
+    if (a->getSourceType() != b->getSourceType())
+        return a->getSourceType() < b->getSourceType();
+    if (a->getMetric() != b->getMetric())
+        return a->getMetric() < b->getMetric();
+    return a->getRoutingTable() < b->getRoutingTable();
+}
+
+void IPv4NetworkConfigurator::StaticRoutesBuilder::shortestPathsCalculated(Topology::Node *target)
+{
+    configurator->addStaticRoutes(topology, (Node *)target);
 }
 
 void IPv4NetworkConfigurator::addStaticRoutes(IPv4Topology& topology)
 {
     // TODO: it should be configurable (via xml?) which nodes need static routes filled in automatically
     // add static routes for all routing tables
-    for (int i = 0; i < topology.getNumNodes(); i++) {
-        Node *sourceNode = (Node *)topology.getNode(i);
-        if (!sourceNode->interfaceTable)
-            continue;
+    std::vector<Topology::Node *> sourceNodes;
+    for (int i = 0; i < topology.getNumNodes(); i++)
+        if (((Node *)topology.getNode(i))->interfaceTable)
+            sourceNodes.push_back(topology.getNode(i));
 
-        // calculate shortest paths from everywhere to sourceNode
-        // we are going to use the paths in reverse direction (assuming all links are bidirectional)
-        topology.calculateUnweightedSingleShortestPathsTo(sourceNode);
+    // calculate shortest paths from everywhere to each source node in one batch
+    // we are going to use the paths in reverse direction (assuming all links are bidirectional)
+    StaticRoutesBuilder builder(this, topology);
+    topology.calculateUnweightedSingleShortestPathsTo(sourceNodes, &builder, shortestPathThreadsParameter);
+}
 
-        // check if adding the default routes would be ok (this is an optimization)
-        if (addDefaultRoutesParameter && sourceNode->interfaceInfos.size() == 1 && sourceNode->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo)
-        {
-          if (sourceNode->interfaceInfos[0]->addDefaultRoute)
-          {
-            InterfaceInfo *sourceInterfaceInfo = sourceNode->interfaceInfos[0];
-            InterfaceEntry *sourceInterfaceEntry = sourceInterfaceInfo->interfaceEntry;
-            InterfaceInfo *gatewayInterfaceInfo = sourceInterfaceInfo->linkInfo->gatewayInterfaceInfo;
+void IPv4NetworkConfigurator::addStaticRoutes(IPv4Topology& topology, Node *sourceNode)
+{
+    // check if adding the default routes would be ok (this is an optimization)
+    if (addDefaultRoutesParameter && sourceNode->interfaceInfos.size() == 1 && sourceNode->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo)
+    {
+      if (sourceNode->interfaceInfos[0]->addDefaultRoute)
+      {
+        InterfaceInfo *sourceInterfaceInfo = sourceNode->interfaceInfos[0];
+        InterfaceEntry *sourceInterfaceEntry = sourceInterfaceInfo->interfaceEntry;
+        InterfaceInfo *gatewayInterfaceInfo = sourceInterfaceInfo->linkInfo->gatewayInterfaceInfo;
+
+        // add a network route for the local network using ARP
+        IPv4Route *route = new IPv4Route();
+        route->setDestination(sourceInterfaceInfo->getAddress().doAnd(sourceInterfaceInfo->getNetmask()));
+        route->setGateway(IPv4Address::UNSPECIFIED_ADDRESS);
+        route->setNetmask(sourceInterfaceInfo->getNetmask());
+        route->setInterface(sourceInterfaceEntry);
+        route->setSourceType(IPv4Route::MANUAL);
+        sourceNode->staticRoutes.push_back(route);
+
+        // add a default route towards the only one gateway
+        route = new IPv4Route();
+        IPv4Address gateway = gatewayInterfaceInfo->getAddress();
+        route->setDestination(IPv4Address::UNSPECIFIED_ADDRESS);
+        route->setNetmask(IPv4Address::UNSPECIFIED_ADDRESS);
+        route->setGateway(gateway);
+        route->setInterface(sourceInterfaceEntry);
+        route->setSourceType(IPv4Route::MANUAL);
+        sourceNode->staticRoutes.push_back(route);
+
+        // skip building and optimizing the whole routing table
+        EV_DEBUG << "Adding default routes to " << sourceNode->getModule()->getFullPath() << ", node has only one (non-loopback) interface\n";
+      }
+    }
+    else
+    {
+        // routes of the node so far, for detecting duplicates
+        std::set<IPv4Route *, bool (*)(const IPv4Route *, const IPv4Route *)> addedRoutes(sourceNode->staticRoutes.begin(), sourceNode->staticRoutes.end(), routeLessThan);
 
-            // add a network route for the local network using ARP
-            IPv4Route *route = new IPv4Route();
-            route->setDestination(sourceInterfaceInfo->getAddress().doAnd(sourceInterfaceInfo->getNetmask()));
-            route->setGateway(IPv4Address::UNSPECIFIED_ADDRESS);
-            route->setNetmask(sourceInterfaceInfo->getNetmask());
-            route->setInterface(sourceInterfaceEntry);
-            route->setSourceType(IPv4Route::MANUAL);
-            sourceNode->staticRoutes.push_back(route);
-
-            // add a default route towards the only one gateway
-            route = new IPv4Route();
-            IPv4Address gateway = gatewayInterfaceInfo->getAddress();
-            route->setDestination(IPv4Address::UNSPECIFIED_ADDRESS);
-            route->setNetmask(IPv4Address::UNSPECIFIED_ADDRESS);
-            route->setGateway(gateway);
-            route->setInterface(sourceInterfaceEntry);
-            route->setSourceType(IPv4Route::MANUAL);
-            sourceNode->staticRoutes.push_back(route);
-
-            // skip building and optimizing the whole routing table
-            EV_DEBUG << "Adding default routes to " << sourceNode->getModule()->getFullPath() << ", node has only one (non-loopback) interface\n";
-          }
-        }
-        else
+        // add a route to all destinations in the network
+        for (int j = 0; j < topology.getNumNodes(); j++)
         {
-            // add a route to all destinations in the network
-            for (int j = 0; j < topology.getNumNodes(); j++)
+            // extract destination
+            Node *destinationNode = (Node *)topology.getNode(j);
+            if (sourceNode == destinationNode)
+                continue;
+            if (destinationNode->getNumPaths() == 0)
+                continue;
+            if (!destinationNode->interfaceTable)
+                continue;
+
+            // determine next hop interface
+            // find next hop interface (the last IP interface on the path that is not in the source node)
+            Node *node = destinationNode;
+            Link *link = NULL;
+            InterfaceInfo *nextHopInterfaceInfo = NULL;
+            while (node != sourceNode)
             {
-                // extract destination
-                Node *destinationNode = (Node *)topology.getNode(j);
-                if (sourceNode == destinationNode)
-                    continue;
-                if (destinationNode->getNumPaths() == 0)
-                    continue;
-                if (!destinationNode->interfaceTable)
-                    continue;
-
-                // determine next hop interface
-                // find next hop interface (the last IP interface on the path that is not in the source node)
-                Node *node = destinationNode;
-                Link *link = NULL;
-                InterfaceInfo *nextHopInterfaceInfo = NULL;
-                while (node != sourceNode)
-                {
-                    link = (Link *)node->getPath(0);
-                    if (node->interfaceTable && node != sourceNode && link->sourceInterfaceInfo)
-                        nextHopInterfaceInfo = link->sourceInterfaceInfo;
-                    node = (Node *)node->getPath(0)->getRemoteNode();
-                }
+                link = (Link *)node->getPath(0);
+                if (node->interfaceTable && node != sourceNode && link->sourceInterfaceInfo)
+                    nextHopInterfaceInfo = link->sourceInterfaceInfo;
+                node = (Node *)node->getPath(0)->getRemoteNode();
+            }
 
-                // determine source interface
-                if (link->destinationInterfaceInfo && link->destinationInterfaceInfo->addStaticRoute)
-                {
-                    InterfaceEntry *sourceInterfaceEntry = link->destinationInterfaceInfo->interfaceEntry;
+            // determine source interface
+            if (link->destinationInterfaceInfo && link->destinationInterfaceInfo->addStaticRoute)
+            {
+                InterfaceEntry *sourceInterfaceEntry = link->destinationInterfaceInfo->interfaceEntry;
 
-                    // add the same routes for all destination interfaces (IP packets are accepted from any interface at the destination)
-                    for (int j = 0; j < (int)destinationNode->interfaceInfos.size(); j++)
+                // add the same routes for all destination interfaces (IP packets are accepted from any interface at the destination)
+                for (int j = 0; j < (int)destinationNode->interfaceInfos.size(); j++)
+                {
+                    InterfaceInfo *destinationInterfaceInfo = destinationNode->interfaceInfos[j];
+                    InterfaceEntry *destinationInterfaceEntry = destinationInterfaceInfo->interfaceEntry;
+                    IPv4Address destinationAddress = destinationInterfaceInfo->getAddress();
+                    IPv4Address destinationNetmask = destinationInterfaceInfo->getNetmask();
+                    if (!destinationInterfaceEntry->isLoopback() && !destinationAddress.isUnspecified())
                     {
-                        InterfaceInfo *destinationInterfaceInfo = destinationNode->interfaceInfos[j];
-                        InterfaceEntry *destinationInterfaceEntry = destinationInterfaceInfo->interfaceEntry;
-                        IPv4Address destinationAddress = destinationInterfaceInfo->getAddress();
-                        IPv4Address destinationNetmask = destinationInterfaceInfo->getNetmask();
-                        if (!destinationInterfaceEntry->isLoopback() && !destinationAddress.isUnspecified())
+                        IPv4Route *route = new IPv4Route();
+                        IPv4Address gatewayAddress = nextHopInterfaceInfo->getAddress();
+                        if (addSubnetRoutesParameter && destinationNode->interfaceInfos.size() == 1 && destinationNode->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo
+                                && destinationNode->interfaceInfos[0]->addSubnetRoute)
                         {
-                            IPv4Route *route = new IPv4Route();
-                            IPv4Address gatewayAddress = nextHopInterfaceInfo->getAddress();
-                            if (addSubnetRoutesParameter && destinationNode->interfaceInfos.size() == 1 && destinationNode->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo
-                                    && destinationNode->interfaceInfos[0]->addSubnetRoute)
-                            {
-                                route->setDestination(destinationAddress.doAnd(destinationNetmask));
-                                route->setNetmask(destinationNetmask);
-                            }
-                            else
-                            {
-                                route->setDestination(destinationAddress);
-                                route->setNetmask(IPv4Address::ALLONES_ADDRESS);
-                            }
-                            route->setInterface(sourceInterfaceEntry);
-                            if (gatewayAddress != destinationAddress)
-                                route->setGateway(gatewayAddress);
-                            route->setSourceType(IPv4Route::MANUAL);
-                            if (containsRoute(sourceNode->staticRoutes, route))
-                                delete route;
-                            else {
-                                sourceNode->staticRoutes.push_back(route);
-                                EV_DEBUG << "Adding route " << sourceInterfaceEntry->getFullPath() << " -> " << destinationInterfaceEntry->getFullPath() << " as " << route->info() << endl;
-                            }
+                            route->setDestination(destinationAddress.doAnd(destinationNetmask));
+                            route->setNetmask(destinationNetmask);
+                        }
+                        else
+                        {
+                            route->setDestination(destinationAddress);
+                            route->setNetmask(IPv4Address::ALLONES_ADDRESS);
+                        }
+                        route->setInterface(sourceInterfaceEntry);
+                        if (gatewayAddress != destinationAddress)
+                            route->setGateway(gatewayAddress);
+                        route->setSourceType(IPv4Route::MANUAL);
+                        if (!addedRoutes.insert(route).second)
+                            delete route;
+                        else {
+                            sourceNode->staticRoutes.push_back(route);
+                            EV_DEBUG << "Adding route " << sourceInterfaceEntry->getFullPath() << " -> " << destinationInterfaceEntry->getFullPath() << " as " << route->info() << endl;
                         }
                     }
                 }
             }
-
-            // optimize routing table to save memory and increase lookup performance
-            if (optimizeRoutesParameter)
-                optimizeRoutes(sourceNode->staticRoutes);
         }
+
+        // optimize routing table to save memory and increase lookup performance
+        if (optimizeRoutesParameter)
+            optimizeRoutes(sourceNode->staticRoutes);
     }
 }
 
@@ -132,6 +132,20 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule, public IPvXAddres
                 virtual Link *createLink() { return new IPv4NetworkConfigurator::Link(); }
         };
 
+        /**
+         * Adds the static routes of each node as soon as the shortest paths
+         * towards it are calculated.
+         */
+        class StaticRoutesBuilder : public Topology::ShortestPathsListener {
+            protected:
+                IPv4NetworkConfigurator *configurator;
+                IPv4Topology& topology;
+
+            public:
+                StaticRoutesBuilder(IPv4NetworkConfigurator *configurator, IPv4Topology& topology) : configurator(configurator), topology(topology) {}
+                virtual void shortestPathsCalculated(Topology::Node *target);
+        };
+
         /**
          * Simplified route representation used by the optimizer.
          * This class makes the optimization faster by introducing route coloring.
@@ -200,6 +214,8 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule, public IPvXAddres
         bool addSubnetRoutesParameter;
         bool addDefaultRoutesParameter;
         bool optimizeRoutesParameter;
+        int shortestPathThreadsParameter;
+        std::string cacheDirectoryParameter;
         cXMLElement *configuration;
 
         // internal state
@@ -277,6 +293,12 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule, public IPvXAddres
          */
         virtual void addStaticRoutes(IPv4Topology& topology);
 
+        /**
+         * Adds the static routes of the given node. Called from addStaticRoutes()
+         * when the shortest paths from all nodes to sourceNode are available.
+         */
+        virtual void addStaticRoutes(IPv4Topology& topology, Node *sourceNode);
+
         /**
          * Destructively optimizes the given IPv4 routes by merging some of them.
          * The resulting routes might be different in that they will route packets
@@ -286,6 +308,26 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule, public IPvXAddres
          */
         virtual void optimizeRoutes(std::vector<IPv4Route *> &routes);
 
+        /**
+         * Returns a hash of everything the computed configuration depends on:
+         * the parameters, the XML configuration and the extracted topology.
+         */
+        virtual uint64 computeConfigurationHash(IPv4Topology& topology);
+        virtual std::string getConfigurationCacheFileName(uint64 hash);
+
+        /**
+         * Restores the interface configuration and the static routes from the
+         * given cache file. Returns false and leaves the configuration untouched
+         * if the file does not exist or it was not written for the given hash.
+         */
+        virtual bool loadConfigurationCache(IPv4Topology& topology, const char *fileName, uint64 hash);
+
+        /**
+         * Writes the interface configuration and the static routes into the given
+         * cache file. Failing to write the file is not an error.
+         */
+        virtual void saveConfigurationCache(IPv4Topology& topology, const char *fileName, uint64 hash);
+
         void ensureConfigurationComputed(IPv4Topology& topology);
         void configureInterface(InterfaceInfo *interfaceInfo);
         void configureRoutingTable(Node *node);
@@ -328,7 +370,7 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule, public IPvXAddres
                 uint32& mergedNetmask, uint32& mergedNetmaskSpecifiedBits, uint32& mergedNetmaskIncompatibleBits);
 
         // helpers for routing table optimization
-        bool containsRoute(const std::vector<IPv4Route *>& routes, IPv4Route *route);
+        static bool routeLessThan(const IPv4Route *a, const IPv4Route *b);
         bool routesHaveSameColor(IPv4Route *route1, IPv4Route *route2);
         int findRouteIndexWithSameColor(const std::vector<IPv4Route *>& routes, IPv4Route *route);
         bool routesCanBeSwapped(RouteInfo *routeInfo1, RouteInfo *routeInfo2);
@@ -44,6 +44,7 @@ const unsigned char NEW_ROUTE_ADDED             = 91;
 const unsigned char NEW_SESSION_ESTABLISHED     = 92;
 const unsigned char ASLOOP_NO_DETECTED          = 93;
 const unsigned char ASLOOP_DETECTED             = 94;
+const unsigned char ROUTE_WITHDRAWN             = 95;
 
 enum type {
         IGP         = 0,
@@ -383,6 +383,7 @@ void Established::entry()
     const IPv4Route*          rtEntry;
     BGP::RoutingTableEntry* BGPEntry;
     IRoutingTable*          IPRoutingTable = session.getIPRoutingTable();
+    std::vector<BGP::RoutingTableEntry*> localEntries;
 
     for (int i=1; i<IPRoutingTable->getNumRoutes(); i++)
     {
@@ -402,17 +403,18 @@ void Established::entry()
                 continue;
             }
             BGPEntry = new BGP::RoutingTableEntry(rtEntry);
-            std::string entryh = rtEntry->getDestination().str();
-            std::string entryn = rtEntry->getNetmask().str();
             BGPEntry->addAS(session._info.ASValue);
-            session.updateSendProcess(BGPEntry);
+            localEntries.push_back(BGPEntry);
         }
     }
 
+    std::vector<BGP::RoutingTableEntry*> entries = localEntries;
     std::vector<BGP::RoutingTableEntry*> BGPRoutingTable = session.getBGPRoutingTable();
-    for (std::vector<BGP::RoutingTableEntry*>::iterator it = BGPRoutingTable.begin(); it != BGPRoutingTable.end(); it++)
+    entries.insert(entries.end(), BGPRoutingTable.begin(), BGPRoutingTable.end());
+    session.updateSendProcess(entries);
+    for (std::vector<BGP::RoutingTableEntry*>::iterator it = localEntries.begin(); it != localEntries.end(); it++)
     {
-        session.updateSendProcess((*it));
+        delete (*it);
     }
 
     //when all EGP Session is in established state, start IGP Session(s)
@@ -21,8 +21,8 @@ Register_Class(BGPUpdateMessage)
 
 void BGPUpdateMessage::setWithdrawnRoutesArraySize(unsigned int size)
 {
-    unsigned short delta_size = size - getWithdrawnRoutesArraySize();
-    unsigned short delta_bytes = delta_size * 5; // 5 = Withdrawn Route length
+    int delta_bytes = ((int)size - (int)getWithdrawnRoutesArraySize()) * 5; // 5 = Withdrawn Route length
+    BGPUpdateMessage_Base::setWithdrawnRoutesArraySize(size);
     setByteLength(getByteLength() + delta_bytes);
 }
 
@@ -57,9 +57,10 @@ void BGPUpdateMessage::setPathAttributeList(const BGPUpdatePathAttributeList& pa
     setByteLength(getByteLength() + delta_bytes);
 }
 
-void BGPUpdateMessage::setNLRI(const BGPUpdateNLRI& NLRI_var)
+void BGPUpdateMessage::setNLRIArraySize(unsigned int size)
 {
-    setByteLength(getByteLength() + 5); //5 = NLRI (length (1) + IPv4Address (4))
-    BGPUpdateMessage_Base::NLRI_var = NLRI_var;
+    int delta_bytes = ((int)size - (int)getNLRIArraySize()) * 5; //5 = NLRI (length (1) + IPv4Address (4))
+    BGPUpdateMessage_Base::setNLRIArraySize(size);
+    setByteLength(getByteLength() + delta_bytes);
 }
 
@@ -15,6 +15,8 @@
 // along with this program; if not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <algorithm>
+
 #include "BGPRouting.h"
 
 #include "ModuleAccess.h"
@@ -32,7 +34,22 @@ BGPRouting::~BGPRouting(void)
     {
         (*sessionIterator).second->~BGPSession();
     }
-    _BGPRoutingTable.erase(_BGPRoutingTable.begin(), _BGPRoutingTable.end());
+    // routes installed in the IP routing table are copies owned by it
+    if (!_useAdjRIBIn)
+    {
+        std::vector<LocRIBEntry*> locEntries;
+        _BGPRoutingTable.getValues(locEntries);
+        for (std::vector<LocRIBEntry*>::iterator it = locEntries.begin(); it != locEntries.end(); it++)
+            delete (*it)->route;
+    }
+    for (std::map<BGP::SessionID, AdjRIBIn*>::iterator it = _adjRIBIn.begin(); it != _adjRIBIn.end(); it++)
+    {
+        std::vector<BGP::RoutingTableEntry**> entries;
+        it->second->getValues(entries);
+        for (std::vector<BGP::RoutingTableEntry**>::iterator entryIt = entries.begin(); entryIt != entries.end(); entryIt++)
+            delete **entryIt;
+        delete it->second;
+    }
     _prefixListIN.erase(_prefixListIN.begin(), _prefixListIN.end());
     _prefixListOUT.erase(_prefixListOUT.begin(), _prefixListOUT.end());
 }
@@ -53,11 +70,15 @@ void BGPRouting::initialize(int stage)
         _rt = RoutingTableAccess().get();
         _inft = InterfaceTableAccess().get();
 
+        _maxPrefixesPerUpdate = par("maxPrefixesPerUpdate");
+        if (_maxPrefixesPerUpdate < 1)
+            throw cRuntimeError("maxPrefixesPerUpdate must be at least 1");
+        _useAdjRIBIn = par("useAdjRIBIn");
+
         // read BGP configuration
         cXMLElement *bgpConfig = par("bgpConfig").xmlValue();
         loadConfigFromXML(bgpConfig);
         createWatch("myAutonomousSystem", _myAS);
-        WATCH_PTRVECTOR(_BGPRoutingTable);
     }
 }
 
@@ -269,109 +290,318 @@ void BGPRouting::processMessage(const BGPUpdateMessage& msg)
     EV << "Processing BGP Update message" << std::endl;
     _BGPSessions[_currSessionId]->getFSM()->UpdateMsgEvent();
 
-    unsigned char               decisionProcessResult;
-    IPv4Address                 netMask(IPv4Address::ALLONES_ADDRESS);
-    BGP::RoutingTableEntry*     entry = new BGP::RoutingTableEntry();
-    const unsigned char         length = msg.getNLRI().length;
-    unsigned int                ASValueCount = msg.getPathAttributeList(0).getAsPath(0).getValue(0).getAsValueArraySize();
+    if (!_useAdjRIBIn)
+    {
+        // the original Decision Process: received routes are compared with the Loc-RIB
+        // one at a time, and withdrawals are ignored
+        for (unsigned int i = 0; msg.getPathAttributeListArraySize() > 0 && i < msg.getNLRIArraySize(); i++)
+        {
+            BGP::RoutingTableEntry* entry = createRoutingTableEntry(msg, i);
+            // RFC 4271, 9.1.  Decision Process
+            unsigned char decisionProcessResult = isAcceptedRoute(entry, _currSessionId) ? decisionProcess(entry, _currSessionId) : 0;
+            //RFC 4271, 9.2.  Update-Send Process
+            if (decisionProcessResult != 0)
+            {
+                updateSendProcess(decisionProcessResult, _currSessionId, entry);
+            }
+            else
+            {
+                delete entry;
+            }
+        }
+        return;
+    }
+
+    // update the Adj-RIB-In of the peer with all prefixes of the message first,
+    // then run the Decision Process once per prefix; replaced routes are deleted
+    // only at the end, as the Loc-RIB may still refer to them until then
+    AdjRIBIn*                               adjRIBIn = _adjRIBIn[_currSessionId];
+    std::vector<BGPUpdateNLRI>              prefixes;
+    std::vector<BGP::RoutingTableEntry*>    replacedEntries;
 
-    entry->setDestination(msg.getNLRI().prefix);
-    netMask = IPv4Address::makeNetmask(length);
-    entry->setNetmask(netMask);
-    for (unsigned int j=0; j < ASValueCount; j++)
+    for (unsigned int i = 0; i < msg.getWithdrawnRoutesArraySize(); i++)
     {
-        entry->addAS(msg.getPathAttributeList(0).getAsPath(0).getValue(0).getAsValue(j));
+        BGPUpdateNLRI prefix;
+        prefix.prefix = msg.getWithdrawnRoutes(i).prefix;
+        prefix.length = msg.getWithdrawnRoutes(i).length;
+        prefixes.push_back(prefix);
+
+        BGP::RoutingTableEntry** oldEntry = adjRIBIn->find(prefix.prefix, prefix.length);
+        if (oldEntry)
+        {
+            replacedEntries.push_back(*oldEntry);
+            adjRIBIn->erase(prefix.prefix, prefix.length);
+        }
     }
 
-    decisionProcessResult = asLoopDetection(entry, _myAS);
+    if (msg.getPathAttributeListArraySize() > 0)
+    {
+        for (unsigned int i = 0; i < msg.getNLRIArraySize(); i++)
+        {
+            const BGPUpdateNLRI&    NLRI = msg.getNLRI(i);
+            BGP::RoutingTableEntry* entry = createRoutingTableEntry(msg, i);
+            prefixes.push_back(NLRI);
+
+            // the new route replaces the previous route of the peer (implicit withdrawal),
+            // even if it is not accepted itself
+            BGP::RoutingTableEntry** oldEntry = adjRIBIn->find(NLRI.prefix, NLRI.length);
+            if (oldEntry)
+            {
+                replacedEntries.push_back(*oldEntry);
+                adjRIBIn->erase(NLRI.prefix, NLRI.length);
+            }
+            if (isAcceptedRoute(entry, _currSessionId))
+            {
+                adjRIBIn->insert(NLRI.prefix, NLRI.length) = entry;
+            }
+            else
+            {
+                delete entry;
+            }
+        }
+    }
 
-    if (decisionProcessResult == BGP::ASLOOP_NO_DETECTED)
+    for (std::vector<BGPUpdateNLRI>::iterator it = prefixes.begin(); it != prefixes.end(); it++)
     {
         // RFC 4271, 9.1.  Decision Process
-        decisionProcessResult = decisionProcess(msg, entry, _currSessionId);
+        BGP::SessionID          sessionIndex;
+        BGP::RoutingTableEntry* entry;
+        unsigned char decisionProcessResult = decisionProcess(it->prefix, it->length, sessionIndex, entry);
         //RFC 4271, 9.2.  Update-Send Process
         if (decisionProcessResult != 0)
         {
-            updateSendProcess(decisionProcessResult, _currSessionId, entry);
+            updateSendProcess(decisionProcessResult, sessionIndex, entry);
         }
     }
+
+    for (std::vector<BGP::RoutingTableEntry*>::iterator it = replacedEntries.begin(); it != replacedEntries.end(); it++)
+    {
+        delete *it;
+    }
 }
 
-unsigned char BGPRouting::decisionProcess(const BGPUpdateMessage& msg, BGP::RoutingTableEntry* entry, BGP::SessionID sessionIndex)
+BGP::RoutingTableEntry* BGPRouting::createRoutingTableEntry(const BGPUpdateMessage& msg, unsigned int NLRIIndex)
 {
+    const BGPUpdatePathAttributeList& pathAttributes = msg.getPathAttributeList(0);
+    const BGPASPathSegment&           ASPath = pathAttributes.getAsPath(0).getValue(0);
+    const BGPUpdateNLRI&              NLRI = msg.getNLRI(NLRIIndex);
+    BGP::RoutingTableEntry*           entry = new BGP::RoutingTableEntry();
+
+    entry->setDestination(NLRI.prefix);
+    entry->setNetmask(IPv4Address::makeNetmask(NLRI.length));
+    for (unsigned int j = 0; j < ASPath.getAsValueArraySize(); j++)
+    {
+        entry->addAS(ASPath.getAsValue(j));
+    }
+    entry->setPathType(pathAttributes.getOrigin().getValue());
+    entry->setGateway(pathAttributes.getNextHop().getValue());
+    entry->setInterface(_BGPSessions[_currSessionId]->getLinkIntf());
+    return entry;
+}
+
+bool BGPRouting::isAcceptedRoute(BGP::RoutingTableEntry* entry, BGP::SessionID sessionIndex)
+{
+    /*If the AS_PATH attribute of a BGP route contains an AS loop, the BGP
+    route should be excluded from the decision process. */
+    if (asLoopDetection(entry, _myAS) == BGP::ASLOOP_DETECTED)
+    {
+        return false;
+    }
+
     //Don't add the route if it exists in PrefixListINTable or in ASListINTable
     if (isInTable(_prefixListIN, entry) != (unsigned long)-1 || isInASList(_ASListIN, entry))
+    {
+        return false;
+    }
+
+    // without useAdjRIBIn, the routing table is checked by decisionProcess(), for new prefixes only
+    int length = entry->getNetmask().getNetmaskLength();
+    if (_useAdjRIBIn && _BGPRoutingTable.find(entry->getDestination(), length) == NULL)
+    {
+        return isAcceptedOverRoute(_rt->findBestMatchingRoute(entry->getDestination()), sessionIndex);
+    }
+    return true;
+}
+
+bool BGPRouting::isAcceptedOverRoute(IPv4Route* route, BGP::SessionID sessionIndex)
+{
+    //Don't add the route if it exists in IPv4 routing table except if the msg come from IGP session
+    if (route && route->getSourceType() != IPv4Route::BGP)
+    {
+        if (_BGPSessions[sessionIndex]->getType() != BGP::IGP)
+        {
+            return false;
+        }
+        IPv4Route* newEntry = new IPv4Route;
+        newEntry->setDestination(route->getDestination());
+        newEntry->setNetmask(route->getNetmask());
+        newEntry->setGateway(route->getGateway());
+        newEntry->setInterface(route->getInterface());
+        newEntry->setSourceType(IPv4Route::BGP);
+        _rt->deleteRoute(route);
+        _rt->addRoute(newEntry);
+    }
+    return true;
+}
+
+unsigned char BGPRouting::decisionProcess(const IPv4Address& prefix, int length, BGP::SessionID& outSessionIndex, BGP::RoutingTableEntry*& outEntry)
+{
+    LocRIBEntry* locEntry = _BGPRoutingTable.find(prefix, length);
+
+    // select the most preferred route of all Adj-RIB-Ins, starting with the current
+    // one if it is still there, so that it is kept on ties
+    BGP::RoutingTableEntry* bestEntry = NULL;
+    BGP::SessionID          bestSessionIndex = 0;
+    if (locEntry)
+    {
+        BGP::RoutingTableEntry** current = _adjRIBIn[locEntry->sessionID]->find(prefix, length);
+        if (current && *current == locEntry->route)
+        {
+            bestEntry = locEntry->route;
+            bestSessionIndex = locEntry->sessionID;
+        }
+    }
+    for (std::map<BGP::SessionID, AdjRIBIn*>::iterator it = _adjRIBIn.begin(); it != _adjRIBIn.end(); it++)
+    {
+        BGP::RoutingTableEntry** candidate = it->second->find(prefix, length);
+        if (candidate && *candidate != bestEntry && (!bestEntry || !tieBreakingProcess(bestEntry, *candidate)))
+        {
+            bestEntry = *candidate;
+            bestSessionIndex = it->first;
+        }
+    }
+
+    if (!bestEntry)
+    {
+        if (!locEntry)
+        {
+            return 0;
+        }
+        // no route left for the prefix
+        outSessionIndex = locEntry->sessionID;
+        outEntry = locEntry->route;
+        uninstallRoute(*locEntry);
+        _BGPRoutingTable.erase(prefix, length);
+        return BGP::ROUTE_WITHDRAWN;
+    }
+
+    if (locEntry && locEntry->route == bestEntry)
     {
         return 0;
     }
 
-    /*If the AS_PATH attribute of a BGP route contains an AS loop, the BGP
-    route should be excluded from the decision process. */
-    entry->setPathType(msg.getPathAttributeList(0).getOrigin().getValue());
-    entry->setGateway(msg.getPathAttributeList(0).getNextHop().getValue());
+    unsigned char result;
+    if (locEntry)
+    {
+        uninstallRoute(*locEntry);
+        result = BGP::ROUTE_DESTINATION_CHANGED;
+    }
+    else
+    {
+        locEntry = &_BGPRoutingTable.insert(prefix, length);
+        result = BGP::NEW_ROUTE_ADDED;
+    }
+    locEntry->route = bestEntry;
+    locEntry->sessionID = bestSessionIndex;
+    locEntry->sequenceNumber = _locRIBSequenceNumber++;
+    installRoute(*locEntry, result == BGP::NEW_ROUTE_ADDED);
+
+    outSessionIndex = bestSessionIndex;
+    outEntry = bestEntry;
+    return result;
+}
+
+unsigned char BGPRouting::decisionProcess(BGP::RoutingTableEntry* entry, BGP::SessionID sessionIndex)
+{
+    int             oldLength;
+    LocRIBEntry*    locEntry = findFirstLocRIBEntry(entry, oldLength);
+    unsigned char   result;
 
     //if the route already exist in BGP routing table, tieBreakingProcess();
     //(RFC 4271: 9.1.2.2 Breaking Ties)
-    unsigned long BGPindex = isInTable(_BGPRoutingTable, entry);
-    if (BGPindex != (unsigned long)-1)
+    if (locEntry)
     {
-        if (tieBreakingProcess(_BGPRoutingTable[BGPindex], entry))
+        if (tieBreakingProcess(locEntry->route, entry))
         {
             return 0;
         }
-        else
+        BGP::RoutingTableEntry* oldEntry = locEntry->route;
+        uninstallRoute(*locEntry);
+        _BGPRoutingTable.erase(oldEntry->getDestination(), oldLength);
+        delete oldEntry;
+        result = BGP::ROUTE_DESTINATION_CHANGED;
+    }
+    else
+    {
+        int indexIP = isInRoutingTable(_rt, entry->getDestination());
+        if (!isAcceptedOverRoute(indexIP != -1 ? _rt->getRoute(indexIP) : NULL, sessionIndex))
         {
-            entry->setInterface(_BGPSessions[sessionIndex]->getLinkIntf());
-            _BGPRoutingTable.push_back(entry);
-            _rt->addRoute(entry);
-            return BGP::ROUTE_DESTINATION_CHANGED;
+            return 0;
         }
+        result = BGP::NEW_ROUTE_ADDED;
     }
+    locEntry = &_BGPRoutingTable.insert(entry->getDestination(), entry->getNetmask().getNetmaskLength());
+    locEntry->route = entry;
+    locEntry->sessionID = sessionIndex;
+    locEntry->sequenceNumber = _locRIBSequenceNumber++;
+    installRoute(*locEntry, result == BGP::NEW_ROUTE_ADDED);
+    return result;
+}
 
-    //Don't add the route if it exists in IPv4 routing table except if the msg come from IGP session
-    int indexIP = isInRoutingTable(_rt, entry->getDestination());
-    if (indexIP != -1 && _rt->getRoute(indexIP)->getSourceType() != IPv4Route::BGP )
+BGPRouting::LocRIBEntry* BGPRouting::findFirstLocRIBEntry(BGP::RoutingTableEntry* entry, int& outLength)
+{
+    // like isInTable(): the route with the same network address, whatever its prefix length;
+    // if there are several, the oldest one, which came first in the original routing table vector
+    uint32          address = entry->getDestination().getInt() & entry->getNetmask().getInt();
+    LocRIBEntry*    firstEntry = NULL;
+    for (int length = 0; length <= 32; length++)
     {
-        if (_BGPSessions[sessionIndex]->getType() != BGP::IGP )
+        if ((address & IPv4Address::makeNetmask(length).getInt()) != address)
         {
-            return 0;
+            continue;
         }
-        else
+        LocRIBEntry* locEntry = _BGPRoutingTable.find(IPv4Address(address), length);
+        if (locEntry && (!firstEntry || locEntry->sequenceNumber < firstEntry->sequenceNumber))
         {
-            IPv4Route* newEntry = new IPv4Route;
-            newEntry->setDestination(_rt->getRoute(indexIP)->getDestination());
-            newEntry->setNetmask(_rt->getRoute(indexIP)->getNetmask());
-            newEntry->setGateway(_rt->getRoute(indexIP)->getGateway());
-            newEntry->setInterface(_rt->getRoute(indexIP)->getInterface());
-            newEntry->setSourceType(IPv4Route::BGP);
-            _rt->deleteRoute(_rt->getRoute(indexIP));
-            _rt->addRoute(newEntry);
+            firstEntry = locEntry;
+            outLength = length;
         }
     }
+    return firstEntry;
+}
 
-    entry->setInterface(_BGPSessions[sessionIndex]->getLinkIntf());
-    _BGPRoutingTable.push_back(entry);
+void BGPRouting::installRoute(LocRIBEntry& locEntry, bool isNewPrefix)
+{
+    // routes learned from EGP sessions and replacement routes go to the IP routing table
+    bool isEGPRoute = _BGPSessions[locEntry.sessionID]->getType() == BGP::EGP;
+    if (isEGPRoute || !isNewPrefix)
+    {
+        locEntry.installedRoute = new BGP::RoutingTableEntry(locEntry.route);
+        _rt->addRoute(locEntry.installedRoute);
+    }
 
-    if (_BGPSessions[sessionIndex]->getType() == BGP::EGP)
+    //insertExternalRoute on OSPF ExternalRoutingTable if OSPF exist on this BGP router
+    if (isEGPRoute && isNewPrefix && ospfExist(_rt))
     {
-        std::string entryh = entry->getDestination().str();
-        std::string entryn = entry->getNetmask().str();
-        _rt->addRoute(entry);
-        //insertExternalRoute on OSPF ExternalRoutingTable if OSPF exist on this BGP router
-        if (ospfExist(_rt))
-        {
-            OSPF::IPv4AddressRange  OSPFnetAddr;
-            OSPFnetAddr.address = entry->getDestination();
-            OSPFnetAddr.mask = entry->getNetmask();
-            OSPFRouting* ospf = OSPFRoutingAccess().getIfExists();
-            InterfaceEntry *ie = entry->getInterface();
-            if (!ie)
-                throw cRuntimeError("Model error: interface entry is NULL");
-            ospf->insertExternalRoute(ie->getInterfaceId(), OSPFnetAddr);
-            simulation.setContext(this);
-        }
+        OSPF::IPv4AddressRange  OSPFnetAddr;
+        OSPFnetAddr.address = locEntry.route->getDestination();
+        OSPFnetAddr.mask = locEntry.route->getNetmask();
+        OSPFRouting* ospf = OSPFRoutingAccess().getIfExists();
+        InterfaceEntry *ie = locEntry.route->getInterface();
+        if (!ie)
+            throw cRuntimeError("Model error: interface entry is NULL");
+        ospf->insertExternalRoute(ie->getInterfaceId(), OSPFnetAddr);
+        simulation.setContext(this);
+    }
+}
+
+void BGPRouting::uninstallRoute(LocRIBEntry& locEntry)
+{
+    if (locEntry.installedRoute)
+    {
+        _rt->deleteRoute(locEntry.installedRoute);
+        locEntry.installedRoute = NULL;
     }
-    return BGP::NEW_ROUTE_ADDED;
 }
 
 bool BGPRouting::tieBreakingProcess(BGP::RoutingTableEntry* oldEntry, BGP::RoutingTableEntry* entry)
@@ -381,20 +611,38 @@ bool BGPRouting::tieBreakingProcess(BGP::RoutingTableEntry* oldEntry, BGP::Routi
          AS_PATH attributes.*/
     if (entry->getASCount() < oldEntry->getASCount())
     {
-        deleteBGPRoutingEntry(oldEntry);
         return false;
     }
+    // without useAdjRIBIn, a route with a longer AS_PATH but a lower Origin is still preferred, as it always was
+    if (entry->getASCount() > oldEntry->getASCount() && _useAdjRIBIn)
+    {
+        return true;
+    }
 
     /* b) Remove from consideration all routes that are not tied for
          having the lowest Origin number in their Origin attribute.*/
     if (entry->getPathType() < oldEntry->getPathType())
     {
-        deleteBGPRoutingEntry(oldEntry);
         return false;
     }
     return true;
 }
 
+std::vector<BGP::RoutingTableEntry*> BGPRouting::getBGPRoutingTable()
+{
+    std::vector<LocRIBEntry*> locEntries;
+    _BGPRoutingTable.getValues(locEntries);
+    std::sort(locEntries.begin(), locEntries.end(), sequenceNumberLess);
+
+    std::vector<BGP::RoutingTableEntry*> routes;
+    routes.reserve(locEntries.size());
+    for (std::vector<LocRIBEntry*>::iterator it = locEntries.begin(); it != locEntries.end(); it++)
+    {
+        routes.push_back((*it)->route);
+    }
+    return routes;
+}
+
 void BGPRouting::updateSendProcess(const unsigned char type, BGP::SessionID sessionIndex, BGP::RoutingTableEntry* entry)
 {
     //Don't send the update Message if the route exists in listOUTTable
@@ -402,6 +650,7 @@ void BGPRouting::updateSendProcess(const unsigned char type, BGP::SessionID sess
     //if it is not the currentSession and if the session is already established
     //SESSION = IGP : send an update message to External BGP Peer (EGP) only
     //if it is not the currentSession and if the session is already established
+    //withdrawals are sent to the peers that may have received the route
     for (std::map<BGP::SessionID, BGPSession*>::iterator sessionIt = _BGPSessions.begin();
         sessionIt != _BGPSessions.end(); sessionIt ++)
     {
@@ -415,52 +664,141 @@ void BGPRouting::updateSendProcess(const unsigned char type, BGP::SessionID sess
         if ((_BGPSessions[sessionIndex]->getType()==BGP::IGP && (*sessionIt).second->getType()==BGP::EGP ) ||
             _BGPSessions[sessionIndex]->getType() == BGP::EGP ||
             type == BGP::ROUTE_DESTINATION_CHANGED ||
+            type == BGP::ROUTE_WITHDRAWN ||
             type == BGP::NEW_SESSION_ESTABLISHED )
         {
-            BGPUpdateNLRI                   NLRI;
-            BGPUpdatePathAttributeList  content;
-
-            unsigned int nbAS = entry->getASCount();
-            content.setAsPathArraySize(1);
-            content.getAsPath(0).setValueArraySize(1);
-            content.getAsPath(0).getValue(0).setType(BGP::AS_SEQUENCE);
-            //RFC 4271 : set My AS in first position if it is not already
-            if (entry->getAS(0) != _myAS)
+            BGPUpdateMessage* updateMsg;
+            if (type == BGP::ROUTE_WITHDRAWN)
             {
-                content.getAsPath(0).getValue(0).setAsValueArraySize(nbAS+1);
-                content.getAsPath(0).getValue(0).setLength(1);
-                content.getAsPath(0).getValue(0).setAsValue(0, _myAS);
-                for (unsigned int j = 1; j < nbAS+1; j++)
-                {
-                    content.getAsPath(0).getValue(0).setAsValue(j, entry->getAS(j-1));
-                }
+                BGPUpdateWithdrawnRoutes withdrawnRoute;
+                IPv4Address netMask = entry->getNetmask();
+                withdrawnRoute.prefix = entry->getDestination().doAnd(netMask);
+                withdrawnRoute.length = (unsigned char) netMask.getNetmaskLength();
+                updateMsg = new BGPUpdateMessage("BGPUpdate");
+                updateMsg->setWithdrawnRoutesArraySize(1);
+                updateMsg->setWithdrawnRoutes(0, withdrawnRoute);
             }
             else
             {
-                content.getAsPath(0).getValue(0).setAsValueArraySize(nbAS);
-                content.getAsPath(0).getValue(0).setLength(1);
-                for (unsigned int j = 0; j < nbAS; j++)
-                {
-                    content.getAsPath(0).getValue(0).setAsValue(j, entry->getAS(j));
-                }
+                updateMsg = createUpdateMessage((*sessionIt).second, entry);
             }
+            (*sessionIt).second->getSocket()->send(updateMsg);
+            (*sessionIt).second->addUpdateMsgSent();
+        }
+    }
+}
+
+void BGPRouting::updateSendProcess(BGP::SessionID sessionIndex, const std::vector<BGP::RoutingTableEntry*>& entries)
+{
+    if (_maxPrefixesPerUpdate == 1)
+    {
+        for (std::vector<BGP::RoutingTableEntry*>::const_iterator it = entries.begin(); it != entries.end(); it++)
+        {
+            updateSendProcess(BGP::NEW_SESSION_ESTABLISHED, sessionIndex, *it);
+        }
+        return;
+    }
+
+    BGPSession* session = _BGPSessions[sessionIndex];
+    if (!session->isEstablished())
+    {
+        return;
+    }
 
-            InterfaceEntry*  iftEntry = (*sessionIt).second->getLinkIntf();
-            content.getOrigin().setValue((*sessionIt).second->getType());
-            content.getNextHop().setValue(iftEntry->ipv4Data()->getIPAddress());
+    // one UPDATE message under construction per AS_PATH; a message is sent
+    // when it is full, the rest at the end
+    typedef std::map<std::vector<BGP::ASID>, BGPUpdateMessage*> PendingMessages;
+    PendingMessages pendingMessages;
+    for (std::vector<BGP::RoutingTableEntry*>::const_iterator it = entries.begin(); it != entries.end(); it++)
+    {
+        BGP::RoutingTableEntry* entry = *it;
+        if (isInTable(_prefixListOUT, entry) != (unsigned long)-1 || isInASList(_ASListOUT, entry))
+        {
+            continue;
+        }
+
+        std::vector<BGP::ASID> ASPath;
+        for (unsigned int i = 0; i < entry->getASCount(); i++)
+        {
+            ASPath.push_back(entry->getAS(i));
+        }
+        BGPUpdateMessage*& updateMsg = pendingMessages[ASPath];
+        if (updateMsg &&
+            ((int)updateMsg->getNLRIArraySize() >= _maxPrefixesPerUpdate ||
+             updateMsg->getByteLength() + 5 > BGP_MAX_MESSAGE_OCTETS))
+        {
+            session->getSocket()->send(updateMsg);
+            session->addUpdateMsgSent();
+            updateMsg = NULL;
+        }
+        if (!updateMsg)
+        {
+            updateMsg = createUpdateMessage(session, entry);
+        }
+        else
+        {
             IPv4Address netMask = entry->getNetmask();
+            BGPUpdateNLRI NLRI;
             NLRI.prefix = entry->getDestination().doAnd(netMask);
             NLRI.length = (unsigned char) netMask.getNetmaskLength();
-            {
-                BGPUpdateMessage* updateMsg = new BGPUpdateMessage("BGPUpdate");
-                updateMsg->setPathAttributeListArraySize(1);
-                updateMsg->setPathAttributeList(content);
-                updateMsg->setNLRI(NLRI);
-                (*sessionIt).second->getSocket()->send(updateMsg);
-                (*sessionIt).second->addUpdateMsgSent();
-            }
+            unsigned int count = updateMsg->getNLRIArraySize();
+            updateMsg->setNLRIArraySize(count + 1);
+            updateMsg->setNLRI(count, NLRI);
+        }
+    }
+    for (PendingMessages::iterator it = pendingMessages.begin(); it != pendingMessages.end(); it++)
+    {
+        if (it->second)
+        {
+            session->getSocket()->send(it->second);
+            session->addUpdateMsgSent();
+        }
+    }
+}
+
+BGPUpdateMessage* BGPRouting::createUpdateMessage(BGPSession* session, BGP::RoutingTableEntry* entry)
+{
+    BGPUpdateNLRI               NLRI;
+    BGPUpdatePathAttributeList  content;
+
+    unsigned int nbAS = entry->getASCount();
+    content.setAsPathArraySize(1);
+    content.getAsPath(0).setValueArraySize(1);
+    content.getAsPath(0).getValue(0).setType(BGP::AS_SEQUENCE);
+    //RFC 4271 : set My AS in first position if it is not already
+    if (entry->getAS(0) != _myAS)
+    {
+        content.getAsPath(0).getValue(0).setAsValueArraySize(nbAS+1);
+        content.getAsPath(0).getValue(0).setLength(1);
+        content.getAsPath(0).getValue(0).setAsValue(0, _myAS);
+        for (unsigned int j = 1; j < nbAS+1; j++)
+        {
+            content.getAsPath(0).getValue(0).setAsValue(j, entry->getAS(j-1));
         }
     }
+    else
+    {
+        content.getAsPath(0).getValue(0).setAsValueArraySize(nbAS);
+        content.getAsPath(0).getValue(0).setLength(1);
+        for (unsigned int j = 0; j < nbAS; j++)
+        {
+            content.getAsPath(0).getValue(0).setAsValue(j, entry->getAS(j));
+        }
+    }
+
+    InterfaceEntry*  iftEntry = session->getLinkIntf();
+    content.getOrigin().setValue(session->getType());
+    content.getNextHop().setValue(iftEntry->ipv4Data()->getIPAddress());
+    IPv4Address netMask = entry->getNetmask();
+    NLRI.prefix = entry->getDestination().doAnd(netMask);
+    NLRI.length = (unsigned char) netMask.getNetmaskLength();
+
+    BGPUpdateMessage* updateMsg = new BGPUpdateMessage("BGPUpdate");
+    updateMsg->setPathAttributeListArraySize(1);
+    updateMsg->setPathAttributeList(content);
+    updateMsg->setNLRIArraySize(1);
+    updateMsg->setNLRI(0, NLRI);
+    return updateMsg;
 }
 
 bool BGPRouting::checkExternalRoute(const IPv4Route* route)
@@ -728,14 +1066,16 @@ BGP::SessionID BGPRouting::createSession(BGP::type typeSession, const char* peer
     newSessionId = info.sessionID;
     newSession->setInfo(info);
     _BGPSessions[newSessionId] = newSession;
+    if (!_adjRIBIn[newSessionId])
+        _adjRIBIn[newSessionId] = new AdjRIBIn();
 
     return newSessionId;
 }
 
 
-BGP::SessionID BGPRouting::findIdFromPeerAddr(std::map<BGP::SessionID, BGPSession*> sessions, IPv4Address peerAddr)
+BGP::SessionID BGPRouting::findIdFromPeerAddr(const std::map<BGP::SessionID, BGPSession*>& sessions, IPv4Address peerAddr)
 {
-    for (std::map<BGP::SessionID, BGPSession*>::iterator sessionIterator = sessions.begin();
+    for (std::map<BGP::SessionID, BGPSession*>::const_iterator sessionIterator = sessions.begin();
         sessionIterator != sessions.end(); sessionIterator ++)
     {
         if ((*sessionIterator).second->getPeerAddr().equals(peerAddr))
@@ -746,22 +1086,6 @@ BGP::SessionID BGPRouting::findIdFromPeerAddr(std::map<BGP::SessionID, BGPSessio
     return -1;
 }
 
-/*delete BGP Routing entry, if the route deleted correctly return true, false else*/
-bool BGPRouting::deleteBGPRoutingEntry(BGP::RoutingTableEntry* entry){
-    for (std::vector<BGP::RoutingTableEntry*>::iterator it = _BGPRoutingTable.begin();
-         it != _BGPRoutingTable.end(); it++)
-    {
-        if (((*it)->getDestination().getInt() & (*it)->getNetmask().getInt()) ==
-            (entry->getDestination().getInt() & entry->getNetmask().getInt()))
-        {
-            _BGPRoutingTable.erase(it);
-            _rt->deleteRoute(entry);
-            return true;
-        }
-    }
-    return false;
-}
-
 /*return index of the IPv4 table if the route is found, -1 else*/
 int BGPRouting::isInRoutingTable(IRoutingTable* rtTable, IPv4Address addr)
 {
@@ -788,9 +1112,9 @@ int BGPRouting::isInInterfaceTable(IInterfaceTable* ifTable, IPv4Address addr)
     return -1;
 }
 
-BGP::SessionID BGPRouting::findIdFromSocketConnId(std::map<BGP::SessionID, BGPSession*> sessions, int connId)
+BGP::SessionID BGPRouting::findIdFromSocketConnId(const std::map<BGP::SessionID, BGPSession*>& sessions, int connId)
 {
-    for (std::map<BGP::SessionID, BGPSession*>::iterator sessionIterator = sessions.begin();
+    for (std::map<BGP::SessionID, BGPSession*>::const_iterator sessionIterator = sessions.begin();
         sessionIterator != sessions.end(); sessionIterator ++)
     {
         TCPSocket* socket = (*sessionIterator).second->getSocket();
@@ -803,7 +1127,7 @@ BGP::SessionID BGPRouting::findIdFromSocketConnId(std::map<BGP::SessionID, BGPSe
 }
 
 /*return index of the table if the route is found, -1 else*/
-unsigned long BGPRouting::isInTable(std::vector<BGP::RoutingTableEntry*> rtTable, BGP::RoutingTableEntry* entry)
+unsigned long BGPRouting::isInTable(const std::vector<BGP::RoutingTableEntry*>& rtTable, BGP::RoutingTableEntry* entry)
 {
     for (unsigned long i = 0; i < rtTable.size(); i++)
     {
@@ -818,9 +1142,9 @@ unsigned long BGPRouting::isInTable(std::vector<BGP::RoutingTableEntry*> rtTable
 }
 
 /*return true if the AS is found, false else*/
-bool BGPRouting::isInASList(std::vector<BGP::ASID> ASList, BGP::RoutingTableEntry* entry)
+bool BGPRouting::isInASList(const std::vector<BGP::ASID>& ASList, BGP::RoutingTableEntry* entry)
 {
-    for (std::vector<BGP::ASID>::iterator it = ASList.begin(); it != ASList.end(); it++)
+    for (std::vector<BGP::ASID>::const_iterator it = ASList.begin(); it != ASList.end(); it++)
     {
         for (unsigned int i = 0; i < entry->getASCount(); i++)
         {
@@ -836,6 +1160,10 @@ bool BGPRouting::isInASList(std::vector<BGP::ASID> ASList, BGP::RoutingTableEntr
 /*return true if OSPF exists, false else*/
 bool BGPRouting::ospfExist(IRoutingTable* rtTable)
 {
+    if (OSPFRoutingAccess().getIfExists() == NULL)
+    {
+        return false;
+    }
     for (int i=0; i<rtTable->getNumRoutes(); i++)
     {
         if (rtTable->getRoute(i)->getSourceType() == IPv4Route::OSPF)
@@ -26,6 +26,7 @@
 #include "InterfaceTableAccess.h"
 #include "OSPFRoutingAccess.h"
 #include "BGPRoutingTableEntry.h"
+#include "IPv4PrefixTrie.h"
 #include "BGPCommon.h"
 #include "IPv4InterfaceData.h"
 #include "IPv4Address.h"
@@ -41,7 +42,7 @@ class INET_API BGPRouting : public cSimpleModule, public ILifecycle, public TCPS
 {
 public:
     BGPRouting()
-        : _myAS(0), _inft(0), _rt(0) {}
+        : _myAS(0), _inft(0), _rt(0), _locRIBSequenceNumber(0), _maxPrefixesPerUpdate(1), _useAdjRIBIn(false) {}
 
     virtual ~BGPRouting();
 
@@ -66,7 +67,10 @@ protected:
     cMessage*       getCancelEvent(cMessage* msg)               { return cancelEvent(msg);}
     cGate*          getGate(const char* gateName)               { return gate(gateName);}
     IRoutingTable*  getIPRoutingTable()                         { return _rt;}
-    std::vector<BGP::RoutingTableEntry*> getBGPRoutingTable()   { return _BGPRoutingTable;}
+    /**
+     * \brief returns the routes of the Loc-RIB, in the order they were selected
+     */
+    std::vector<BGP::RoutingTableEntry*> getBGPRoutingTable();
     /**
      * \brief active listenSocket for a given session (used by BGPFSM)
      */
@@ -79,6 +83,11 @@ protected:
      * \brief RFC 4271, 9.2 : Update-Send Process / Sent or not new UPDATE messages to its peers
       */
     void updateSendProcess(const unsigned char decisionProcessResult, BGP::SessionID sessionIndex, BGP::RoutingTableEntry* entry);
+    /**
+     * \brief RFC 4271, 9.2 : Update-Send Process for a newly established session / send the given routes to the peer.
+     *  Routes with the same AS_PATH are packed into UPDATE messages of up to maxPrefixesPerUpdate prefixes.
+     */
+    void updateSendProcess(BGP::SessionID sessionIndex, const std::vector<BGP::RoutingTableEntry*>& entries);
     /**
      * \brief find the next SessionID compared to his type and start this session if boolean is true
      */
@@ -91,6 +100,22 @@ protected:
     bool checkExternalRoute(const IPv4Route* ospfRoute);
 
 private:
+    /**
+     * Loc-RIB entry of a prefix: the route selected by the Decision Process
+     * and its copy in the IP routing table.
+     */
+    struct LocRIBEntry
+    {
+        BGP::RoutingTableEntry* route;  // owned by the Adj-RIB-In of the session if useAdjRIBIn, by the Loc-RIB otherwise
+        BGP::SessionID          sessionID;
+        IPv4Route*              installedRoute; // owned by the IP routing table, or NULL
+        unsigned long           sequenceNumber; // increases with every selected route; the Loc-RIB is sent to new peers in this order
+        LocRIBEntry() : route(NULL), sessionID(0), installedRoute(NULL), sequenceNumber(0) {}
+    };
+
+    typedef IPv4PrefixTrie<BGP::RoutingTableEntry*>   AdjRIBIn; // routes received from a peer, by prefix
+    typedef IPv4PrefixTrie<LocRIBEntry>               LocRIB;   // selected routes, by prefix
+
     void handleTimer(cMessage *timer);
 
     void processMessageFromTCP(cMessage *msg);
@@ -98,24 +123,53 @@ private:
     void processMessage(const BGPKeepAliveMessage& msg);
     void processMessage(const BGPUpdateMessage& msg);
 
-    bool deleteBGPRoutingEntry(BGP::RoutingTableEntry* entry);
     /**
-     * \brief RFC 4271: 9.1. : Decision Process used when an UPDATE message is received
-     *  As matches, routes are sent or not to UpdateSentProcess
-     *  The result can be ROUTE_DESTINATION_CHANGED, NEW_ROUTE_ADDED or 0 if no routingTable modification
+     * \brief creates a route from the path attributes and the given NLRI of a received UPDATE message
      */
-    unsigned char decisionProcess(const BGPUpdateMessage& msg, BGP::RoutingTableEntry* entry, BGP::SessionID sessionIndex);
+    BGP::RoutingTableEntry* createRoutingTableEntry(const BGPUpdateMessage& msg, unsigned int NLRIIndex);
+    /**
+     * \brief RFC 4271: 9.1.1 : checks whether a route received from a peer may enter its Adj-RIB-In
+     *  (no AS loop, not denied by the IN prefix and AS lists, no conflicting non-BGP route)
+     */
+    bool isAcceptedRoute(BGP::RoutingTableEntry* entry, BGP::SessionID sessionIndex);
+    /**
+     * \brief checks a received route against the given route of the IP routing table, if any: a non-BGP route
+     *  rejects routes from EGP sessions, and is taken over by BGP for routes from IGP sessions
+     */
+    bool isAcceptedOverRoute(IPv4Route* route, BGP::SessionID sessionIndex);
+    /**
+     * \brief RFC 4271: 9.1. : Decision Process used for each prefix of a received UPDATE message if useAdjRIBIn is set,
+     *  after the Adj-RIB-In of the peer has been updated with the whole message.
+     *  Selects the best route of all Adj-RIB-Ins for the prefix and updates the Loc-RIB and the IP routing table.
+     *  The result can be ROUTE_DESTINATION_CHANGED, NEW_ROUTE_ADDED, ROUTE_WITHDRAWN or 0 if the Loc-RIB did not change;
+     *  outSessionIndex and outEntry are set to the session and route to be passed to the Update-Send Process.
+     */
+    unsigned char decisionProcess(const IPv4Address& prefix, int length, BGP::SessionID& outSessionIndex, BGP::RoutingTableEntry*& outEntry);
+    /**
+     * \brief RFC 4271: 9.1. : Decision Process used for each accepted route unless useAdjRIBIn is set:
+     *  the route replaces the one in the Loc-RIB if it is preferred to it, and is deleted otherwise.
+     *  The result can be ROUTE_DESTINATION_CHANGED, NEW_ROUTE_ADDED or 0 if the route was deleted.
+     */
+    unsigned char decisionProcess(BGP::RoutingTableEntry* entry, BGP::SessionID sessionIndex);
     /**
      * \brief RFC 4271: 9.1.2.2 Breaking Ties used when BGP speaker may have several routes
      *  to the same destination that have the same degree of preference.
      *
-     * \return bool, true if this process changed the route, false else
+     * \return bool, true if oldEntry is kept, false if entry is preferred
      */
     bool tieBreakingProcess(BGP::RoutingTableEntry* oldEntry, BGP::RoutingTableEntry* entry);
+    /**
+     * \brief the Loc-RIB entry that decisionProcess(entry, sessionIndex) compares entry with, and its prefix length
+     */
+    LocRIBEntry* findFirstLocRIBEntry(BGP::RoutingTableEntry* entry, int& outLength);
+    void installRoute(LocRIBEntry& locEntry, bool isNewPrefix);
+    static bool sequenceNumberLess(const LocRIBEntry* a, const LocRIBEntry* b) { return a->sequenceNumber < b->sequenceNumber; }
+    void uninstallRoute(LocRIBEntry& locEntry);
+    BGPUpdateMessage* createUpdateMessage(BGPSession* session, BGP::RoutingTableEntry* entry);
 
     BGP::SessionID createSession(BGP::type typeSession, const char* peerAddr);
-    bool isInASList(std::vector<BGP::ASID> ASList, BGP::RoutingTableEntry* entry);
-    unsigned long   isInTable(std::vector<BGP::RoutingTableEntry*> rtTable, BGP::RoutingTableEntry* entry);
+    bool isInASList(const std::vector<BGP::ASID>& ASList, BGP::RoutingTableEntry* entry);
+    unsigned long   isInTable(const std::vector<BGP::RoutingTableEntry*>& rtTable, BGP::RoutingTableEntry* entry);
 
     std::vector<const char *> loadASConfig(cXMLElementList& ASConfig);
     void loadSessionConfig(cXMLElementList& sessionList, simtime_t* delayTab);
@@ -124,10 +178,10 @@ private:
     bool ospfExist(IRoutingTable* rtTable);
     void loadTimerConfig(cXMLElementList& timerConfig, simtime_t* delayTab);
     unsigned char asLoopDetection(BGP::RoutingTableEntry* entry, BGP::ASID myAS);
-    BGP::SessionID findIdFromPeerAddr(std::map<BGP::SessionID, BGPSession*> sessions, IPv4Address peerAddr);
-    int isInRoutingTable(IRoutingTable* rtTable, IPv4Address addr);
+    BGP::SessionID findIdFromPeerAddr(const std::map<BGP::SessionID, BGPSession*>& sessions, IPv4Address peerAddr);
     int isInInterfaceTable(IInterfaceTable* rtTable, IPv4Address addr);
-    BGP::SessionID findIdFromSocketConnId(std::map<BGP::SessionID, BGPSession*> sessions, int connId);
+    int isInRoutingTable(IRoutingTable* rtTable, IPv4Address addr);
+    BGP::SessionID findIdFromSocketConnId(const std::map<BGP::SessionID, BGPSession*>& sessions, int connId);
     unsigned int calculateStartDelay(int rtListSize, unsigned char rtPosition, unsigned char rtPeerPosition);
 
     TCPSocketMap                            _socketMap;
@@ -136,12 +190,16 @@ private:
 
     IInterfaceTable*                        _inft;
     IRoutingTable*                          _rt;                // The IP routing table
-    std::vector<BGP::RoutingTableEntry*>    _BGPRoutingTable;   // The BGP routing table
+    LocRIB                                  _BGPRoutingTable;   // The BGP routing table (Loc-RIB)
+    unsigned long                           _locRIBSequenceNumber;
+    std::map<BGP::SessionID, AdjRIBIn*>     _adjRIBIn;          // Adj-RIB-In of each session
     std::vector<BGP::RoutingTableEntry*>    _prefixListIN;
     std::vector<BGP::RoutingTableEntry*>    _prefixListOUT;
     std::vector<BGP::ASID>                  _ASListIN;
     std::vector<BGP::ASID>                  _ASListOUT;
     std::map<BGP::SessionID, BGPSession*>   _BGPSessions;
+    int                                     _maxPrefixesPerUpdate;
+    bool                                    _useAdjRIBIn;
 
     static const int  BGP_TCP_CONNECT_VALID = 71;
     static const int  BGP_TCP_CONNECT_CONFIRM = 72;
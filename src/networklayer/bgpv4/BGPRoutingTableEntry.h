@@ -56,7 +56,8 @@ inline BGP::RoutingTableEntry::RoutingTableEntry(void) :
     setSourceType(IPv4Route::BGP);
 }
 
-inline BGP::RoutingTableEntry::RoutingTableEntry(const IPv4Route* entry)
+inline BGP::RoutingTableEntry::RoutingTableEntry(const IPv4Route* entry) :
+    IPv4Route(), _pathType(BGP::Incomplete)
 {
     setDestination(entry->getDestination());
     setNetmask(entry->getNetmask());
@@ -65,7 +65,7 @@ public:
     std::vector<BGP::RoutingTableEntry*> getBGPRoutingTable()   { return _bgpRouting.getBGPRoutingTable();}
     Macho::Machine<BGPFSM::TopState>&    getFSM()               { return *_fsm;}
     bool checkExternalRoute(const IPv4Route* ospfRoute)           { return _bgpRouting.checkExternalRoute(ospfRoute);}
-    void updateSendProcess(BGP::RoutingTableEntry* entry)       { return _bgpRouting.updateSendProcess(BGP::NEW_SESSION_ESTABLISHED, _info.sessionID, entry);}
+    void updateSendProcess(const std::vector<BGP::RoutingTableEntry*>& entries) { return _bgpRouting.updateSendProcess(_info.sessionID, entries);}
 
 private:
     BGP::SessionInfo    _info;
@@ -41,6 +41,36 @@
 
 using namespace DiffservUtil;
 
+void MultiFieldClassifier::getPorts(cPacket *packet, int& srcPort, int& destPort)
+{
+    srcPort = destPort = -1;
+#ifdef WITH_UDP
+    UDPPacket *udpPacket = dynamic_cast<UDPPacket*>(packet);
+    if (udpPacket)
+    {
+        srcPort = udpPacket->getSourcePort();
+        destPort = udpPacket->getDestinationPort();
+    }
+#endif
+#ifdef WITH_TCP_COMMON
+    TCPSegment *tcpSegment = dynamic_cast<TCPSegment*>(packet);
+    if (tcpSegment)
+    {
+        srcPort = tcpSegment->getSrcPort();
+        destPort = tcpSegment->getDestPort();
+    }
+#endif
+}
+
+bool MultiFieldClassifier::Filter::matchesPorts(int srcPort, int destPort) const
+{
+    if (srcPortMin >= 0 && (srcPort < srcPortMin || srcPort > srcPortMax))
+        return false;
+    if (destPortMin >= 0 && (destPort < destPortMin || destPort > destPortMax))
+        return false;
+    return true;
+}
+
 #ifdef WITH_IPv4
 bool MultiFieldClassifier::Filter::matches(IPv4Datagram *datagram)
 {
@@ -54,28 +84,9 @@ bool MultiFieldClassifier::Filter::matches(IPv4Datagram *datagram)
         return false;
     if (srcPortMin >= 0 || destPortMin >= 0)
     {
-        int srcPort = -1, destPort = -1;
-        cPacket *packet = datagram->getEncapsulatedPacket();
-#ifdef WITH_UDP
-        UDPPacket *udpPacket = dynamic_cast<UDPPacket*>(packet);
-        if (udpPacket)
-        {
-            srcPort = udpPacket->getSourcePort();
-            destPort = udpPacket->getDestinationPort();
-        }
-#endif
-#ifdef WITH_TCP_COMMON
-        TCPSegment *tcpSegment = dynamic_cast<TCPSegment*>(packet);
-        if (tcpSegment)
-        {
-            srcPort = tcpSegment->getSrcPort();
-            destPort = tcpSegment->getDestPort();
-        }
-#endif
-
-        if (srcPortMin >= 0 && (srcPort < srcPortMin || srcPort > srcPortMax))
-            return false;
-        if (destPortMin >= 0 && (destPort < destPortMin || destPort > destPortMax))
+        int srcPort, destPort;
+        getPorts(datagram->getEncapsulatedPacket(), srcPort, destPort);
+        if (!matchesPorts(srcPort, destPort))
             return false;
     }
 
@@ -96,28 +107,9 @@ bool MultiFieldClassifier::Filter::matches(IPv6Datagram *datagram)
         return false;
     if (srcPortMin >= 0 || destPortMin >= 0)
     {
-        int srcPort = -1, destPort = -1;
-        cPacket *packet = datagram->getEncapsulatedPacket();
-#ifdef WITH_UDP
-        UDPPacket *udpPacket = dynamic_cast<UDPPacket*>(packet);
-        if (udpPacket)
-        {
-            srcPort = udpPacket->getSourcePort();
-            destPort = udpPacket->getDestinationPort();
-        }
-#endif
-#ifdef WITH_TCP_COMMON
-        TCPSegment *tcpSegment = dynamic_cast<TCPSegment*>(packet);
-        if (tcpSegment)
-        {
-            srcPort = tcpSegment->getSrcPort();
-            destPort = tcpSegment->getDestPort();
-        }
-#endif
-
-        if (srcPortMin >= 0 && (srcPort < srcPortMin || srcPort > srcPortMax))
-            return false;
-        if (destPortMin >= 0 && (destPort < destPortMin || destPort > destPortMax))
+        int srcPort, destPort;
+        getPorts(datagram->getEncapsulatedPacket(), srcPort, destPort);
+        if (!matchesPorts(srcPort, destPort))
             return false;
     }
 
@@ -146,6 +138,7 @@ void MultiFieldClassifier::initialize(int stage)
     {
         cXMLElement *config = par("filters").xmlValue();
         configureFilters(config);
+        compileFilters();
     }
 }
 
@@ -171,6 +164,114 @@ void MultiFieldClassifier::handleMessage(cMessage *msg)
 }
 
 int MultiFieldClassifier::classifyPacket(cPacket *packet)
+{
+    for (; packet; packet = packet->getEncapsulatedPacket())
+    {
+#ifdef WITH_IPv4
+        IPv4Datagram *ipv4Datagram = dynamic_cast<IPv4Datagram*>(packet);
+        if (ipv4Datagram)
+        {
+            FilterKey packetKey;
+            packetKey.words[FilterKey::SRC] = ipv4Datagram->getSrcAddress().getInt();
+            packetKey.words[FilterKey::DEST] = ipv4Datagram->getDestAddress().getInt();
+            packetKey.words[FilterKey::PROTOCOL] = ipv4Datagram->getTransportProtocol();
+            packetKey.words[FilterKey::TOS] = ipv4Datagram->getTypeOfService();
+            if (ipv4Index.needsPorts)
+            {
+                int srcPort, destPort;
+                getPorts(ipv4Datagram->getEncapsulatedPacket(), srcPort, destPort);
+                packetKey.words[FilterKey::SRC_PORT] = srcPort;
+                packetKey.words[FilterKey::DEST_PORT] = destPort;
+            }
+            int filterIndex = findFirstMatchingFilter(ipv4Index, packetKey, 1);
+            return filterIndex >= 0 ? filters[filterIndex].gateIndex : -1;
+        }
+#endif
+#ifdef WITH_IPv6
+        IPv6Datagram *ipv6Datagram = dynamic_cast<IPv6Datagram *>(packet);
+        if (ipv6Datagram)
+        {
+            FilterKey packetKey;
+            memcpy(packetKey.words + FilterKey::SRC, ipv6Datagram->getSrcAddress().words(), 4 * sizeof(uint32));
+            memcpy(packetKey.words + FilterKey::DEST, ipv6Datagram->getDestAddress().words(), 4 * sizeof(uint32));
+            packetKey.words[FilterKey::PROTOCOL] = ipv6Datagram->getTransportProtocol();
+            packetKey.words[FilterKey::TOS] = ipv6Datagram->getTrafficClass();
+            if (ipv6Index.needsPorts)
+            {
+                int srcPort, destPort;
+                getPorts(ipv6Datagram->getEncapsulatedPacket(), srcPort, destPort);
+                packetKey.words[FilterKey::SRC_PORT] = srcPort;
+                packetKey.words[FilterKey::DEST_PORT] = destPort;
+            }
+            int filterIndex = findFirstMatchingFilter(ipv6Index, packetKey, 4);
+            return filterIndex >= 0 ? filters[filterIndex].gateIndex : -1;
+        }
+#endif
+    }
+
+    return -1;
+}
+
+int MultiFieldClassifier::findFirstMatchingFilter(const FilterIndex& index, const FilterKey& packetKey, int addressWords) const
+{
+    int srcPort = (int)packetKey.words[FilterKey::SRC_PORT];
+    int destPort = (int)packetKey.words[FilterKey::DEST_PORT];
+    int best = -1;
+    for (std::vector<FilterTuple>::const_iterator tuple = index.tuples.begin(); tuple != index.tuples.end(); ++tuple)
+    {
+        // tuples are ordered by their first filter, so the rest cannot match earlier
+        if (best >= 0 && tuple->firstFilter > best)
+            break;
+
+        FilterKey key;
+        if (tuple->srcPrefixLength > 0)
+        {
+            memcpy(key.words + FilterKey::SRC, packetKey.words + FilterKey::SRC, addressWords * sizeof(uint32));
+            maskAddress(key.words + FilterKey::SRC, addressWords, tuple->srcPrefixLength);
+        }
+        if (tuple->destPrefixLength > 0)
+        {
+            memcpy(key.words + FilterKey::DEST, packetKey.words + FilterKey::DEST, addressWords * sizeof(uint32));
+            maskAddress(key.words + FilterKey::DEST, addressWords, tuple->destPrefixLength);
+        }
+        if (tuple->hasProtocol)
+            key.words[FilterKey::PROTOCOL] = packetKey.words[FilterKey::PROTOCOL];
+        key.words[FilterKey::TOS] = packetKey.words[FilterKey::TOS] & tuple->tosMask;
+        if (tuple->hasSrcPort)
+            key.words[FilterKey::SRC_PORT] = packetKey.words[FilterKey::SRC_PORT];
+        if (tuple->hasDestPort)
+            key.words[FilterKey::DEST_PORT] = packetKey.words[FilterKey::DEST_PORT];
+
+        std::map<FilterKey, std::vector<int> >::const_iterator it = tuple->filtersByKey.find(key);
+        if (it == tuple->filtersByKey.end())
+            continue;
+        for (std::vector<int>::const_iterator filterIndex = it->second.begin(); filterIndex != it->second.end(); ++filterIndex)
+        {
+            if (best >= 0 && *filterIndex > best)
+                break;
+            if (filters[*filterIndex].matchesPorts(srcPort, destPort))
+            {
+                best = *filterIndex;
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+void MultiFieldClassifier::maskAddress(uint32 *words, int addressWords, int prefixLength)
+{
+    for (int i = 0; i < addressWords; i++)
+    {
+        int bits = prefixLength - 32 * i;
+        if (bits <= 0)
+            words[i] = 0;
+        else if (bits < 32)
+            words[i] &= 0xffffffffu << (32 - bits);
+    }
+}
+
+int MultiFieldClassifier::classifyPacketLinear(cPacket *packet)
 {
     for (; packet; packet = packet->getEncapsulatedPacket())
     {
@@ -231,6 +332,79 @@ void MultiFieldClassifier::addFilter(const Filter &filter)
     filters.push_back(filter);
 }
 
+void MultiFieldClassifier::compileFilters()
+{
+    ipv4Index = FilterIndex();
+    ipv6Index = FilterIndex();
+    for (int i = 0; i < (int)filters.size(); i++)
+    {
+        const Filter& filter = filters[i];
+        bool ipv4Only = (filter.srcPrefixLength > 0 && !filter.srcAddr.isIPv6()) || (filter.destPrefixLength > 0 && !filter.destAddr.isIPv6());
+        bool ipv6Only = (filter.srcPrefixLength > 0 && filter.srcAddr.isIPv6()) || (filter.destPrefixLength > 0 && filter.destAddr.isIPv6());
+        if (!ipv6Only)
+            addToIndex(ipv4Index, i, 1);
+        if (!ipv4Only)
+            addToIndex(ipv6Index, i, 4);
+    }
+}
+
+void MultiFieldClassifier::addToIndex(FilterIndex& index, int filterIndex, int addressWords)
+{
+    const Filter& filter = filters[filterIndex];
+    bool hasProtocol = filter.protocol >= 0;
+    bool hasSrcPort = filter.srcPortMin >= 0 && filter.srcPortMin == filter.srcPortMax;
+    bool hasDestPort = filter.destPortMin >= 0 && filter.destPortMin == filter.destPortMax;
+
+    FilterTuple *tuple = NULL;
+    for (std::vector<FilterTuple>::iterator it = index.tuples.begin(); it != index.tuples.end() && !tuple; ++it)
+        if (it->srcPrefixLength == filter.srcPrefixLength && it->destPrefixLength == filter.destPrefixLength &&
+                it->hasProtocol == hasProtocol && it->tosMask == filter.tosMask &&
+                it->hasSrcPort == hasSrcPort && it->hasDestPort == hasDestPort)
+            tuple = &(*it);
+    if (!tuple)
+    {
+        // filters are added in order, so tuples are ordered by their first filter
+        index.tuples.push_back(FilterTuple());
+        tuple = &index.tuples.back();
+        tuple->srcPrefixLength = filter.srcPrefixLength;
+        tuple->destPrefixLength = filter.destPrefixLength;
+        tuple->hasProtocol = hasProtocol;
+        tuple->tosMask = filter.tosMask;
+        tuple->hasSrcPort = hasSrcPort;
+        tuple->hasDestPort = hasDestPort;
+        tuple->firstFilter = filterIndex;
+    }
+
+    FilterKey key;
+    if (filter.srcPrefixLength > 0)
+    {
+        if (addressWords == 1)
+            key.words[FilterKey::SRC] = filter.srcAddr.get4().getInt();
+        else
+            memcpy(key.words + FilterKey::SRC, filter.srcAddr.get6().words(), 4 * sizeof(uint32));
+        maskAddress(key.words + FilterKey::SRC, addressWords, filter.srcPrefixLength);
+    }
+    if (filter.destPrefixLength > 0)
+    {
+        if (addressWords == 1)
+            key.words[FilterKey::DEST] = filter.destAddr.get4().getInt();
+        else
+            memcpy(key.words + FilterKey::DEST, filter.destAddr.get6().words(), 4 * sizeof(uint32));
+        maskAddress(key.words + FilterKey::DEST, addressWords, filter.destPrefixLength);
+    }
+    if (hasProtocol)
+        key.words[FilterKey::PROTOCOL] = filter.protocol;
+    key.words[FilterKey::TOS] = filter.tos & filter.tosMask;
+    if (hasSrcPort)
+        key.words[FilterKey::SRC_PORT] = filter.srcPortMin;
+    if (hasDestPort)
+        key.words[FilterKey::DEST_PORT] = filter.destPortMin;
+
+    tuple->filtersByKey[key].push_back(filterIndex);
+    if (filter.srcPortMin >= 0 || filter.destPortMin >= 0)
+        index.needsPorts = true;
+}
+
 void MultiFieldClassifier::configureFilters(cXMLElement *config)
 {
     IPvXAddressResolver addressResolver;
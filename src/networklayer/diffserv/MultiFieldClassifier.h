@@ -20,6 +20,10 @@
 #ifndef __INET_MULTIFIELDCLASSIFIER_H
 #define __INET_MULTIFIELDCLASSIFIER_H
 
+#include <map>
+#include <string.h>
+#include <vector>
+
 #include "INETDefs.h"
 
 /**
@@ -53,11 +57,56 @@ class INET_API MultiFieldClassifier : public cSimpleModule
     #ifdef WITH_IPv6
             bool matches(IPv6Datagram *datagram);
     #endif
+            bool matchesPorts(int srcPort, int destPort) const;
+        };
+
+        /**
+         * Header fields of a packet, or the fields a filter compares; the
+         * fields not examined by a filter tuple are zero.
+         */
+        struct FilterKey
+        {
+            enum { SRC = 0, DEST = 4, PROTOCOL = 8, TOS = 9, SRC_PORT = 10, DEST_PORT = 11, LENGTH = 12 };
+            uint32 words[LENGTH];
+
+            FilterKey() { memset(words, 0, sizeof(words)); }
+            bool operator<(const FilterKey& other) const { return memcmp(words, other.words, sizeof(words)) < 0; }
+        };
+
+        /**
+         * Filters that examine the same fields with the same prefix lengths
+         * and masks (tuple space search). Packets are masked accordingly and
+         * looked up in a map; each key lists its filters in configuration
+         * order. Port ranges are checked on the filters found.
+         */
+        struct FilterTuple
+        {
+            int srcPrefixLength;
+            int destPrefixLength;
+            bool hasProtocol;
+            int tosMask;
+            bool hasSrcPort;    // exact source port is part of the key
+            bool hasDestPort;   // exact destination port is part of the key
+            int firstFilter;    // index of the first filter of the tuple
+            std::map<FilterKey, std::vector<int> > filtersByKey;
+        };
+
+        /**
+         * Filters applicable to one address family, compiled into tuples
+         * ordered by their first filter.
+         */
+        struct FilterIndex
+        {
+            std::vector<FilterTuple> tuples;
+            bool needsPorts;
+            FilterIndex() : needsPorts(false) {}
         };
 
   protected:
     int numOutGates;
     std::vector<Filter> filters;
+    FilterIndex ipv4Index;
+    FilterIndex ipv6Index;
 
     int numRcvd;
 
@@ -67,6 +116,13 @@ class INET_API MultiFieldClassifier : public cSimpleModule
     void addFilter(const Filter &filter);
     void configureFilters(cXMLElement *config);
 
+    // builds ipv4Index and ipv6Index from filters
+    void compileFilters();
+    void addToIndex(FilterIndex& index, int filterIndex, int addressWords);
+    int findFirstMatchingFilter(const FilterIndex& index, const FilterKey& packetKey, int addressWords) const;
+    static void getPorts(cPacket *packet, int& srcPort, int& destPort);
+    static void maskAddress(uint32 *words, int addressWords, int prefixLength);
+
   public:
     MultiFieldClassifier() {}
 
@@ -78,6 +134,9 @@ class INET_API MultiFieldClassifier : public cSimpleModule
     virtual void handleMessage(cMessage *msg);
 
     virtual int classifyPacket(cPacket *packet);
+
+    // evaluates the filters one by one; reference for classifyPacket()
+    int classifyPacketLinear(cPacket *packet);
 };
 
 #endif
@@ -432,13 +432,13 @@ void IPv4::routeUnicastPacket(IPv4Datagram *datagram, const InterfaceEntry *from
 {
     IPv4Address destAddr = datagram->getDestAddress();
 
-    EV << "Routing datagram `" << datagram->getName() << "' with dest=" << destAddr << ": ";
+    EV_INFO << "Routing datagram `" << datagram->getName() << "' with dest=" << destAddr << ": ";
 
     IPv4Address nextHopAddr;
     // if output port was explicitly requested, use that, otherwise use IPv4 routing
     if (destIE)
     {
-        EV << "using manually specified output interface " << destIE->getName() << "\n";
+        EV_INFO << "using manually specified output interface " << destIE->getName() << "\n";
         // and nextHopAddr remains unspecified
         if (!requestedNextHopAddress.isUnspecified())
             nextHopAddr = requestedNextHopAddress;
@@ -464,7 +464,7 @@ void IPv4::routeUnicastPacket(IPv4Datagram *datagram, const InterfaceEntry *from
 
     if (!destIE) // no route found
     {
-        EV << "unroutable, sending ICMP_DESTINATION_UNREACHABLE\n";
+        EV_INFO << "unroutable, sending ICMP_DESTINATION_UNREACHABLE\n";
         numUnroutable++;
         icmpAccess.get()->sendErrorMessage(datagram, fromIE ? fromIE->getInterfaceId() : -1, ICMP_DESTINATION_UNREACHABLE, 0);
     }
@@ -482,7 +482,7 @@ void IPv4::routeUnicastPacket(IPv4Datagram *datagram, const InterfaceEntry *from
 
 void IPv4::routeUnicastPacketFinish(IPv4Datagram *datagram, const InterfaceEntry *fromIE, const InterfaceEntry *destIE, IPv4Address nextHopAddr)
 {
-    EV << "output interface is " << destIE->getName() << ", next-hop address: " << nextHopAddr << "\n";
+    EV_INFO << "output interface is " << destIE->getName() << ", next-hop address: " << nextHopAddr << "\n";
     numForwarded++;
     fragmentPostRouting(datagram, destIE, nextHopAddr);
 }
@@ -0,0 +1,285 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IPv4PREFIXTRIE_H
+#define __INET_IPv4PREFIXTRIE_H
+
+#include <algorithm>
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "IPv4Address.h"
+
+
+/**
+ * Map from IPv4 prefixes (address and prefix length) to values of type T.
+ * It is the index of IPv4RouteTrie, and holds the routing information
+ * bases of BGPRouting.
+ *
+ * The map is a path-compressed binary trie: every node holds a prefix,
+ * optionally a value, and at most two children whose prefixes extend the
+ * node's prefix. Nodes without a value are only kept where two branches
+ * meet, so the depth of the trie is bounded by both 33 and the number of
+ * prefixes.
+ *
+ * Host bits of the given addresses are ignored. Values are never moved,
+ * so pointers to them stay valid until they are erased. Tries cannot be
+ * copied.
+ */
+template<typename T>
+class IPv4PrefixTrie
+{
+  protected:
+    struct Node
+    {
+        uint32 prefix;  // masked address
+        int length;     // prefix length, 0..32
+        bool hasValue;
+        T value;
+        Node *parent;
+        Node *children[2];
+
+        Node(uint32 prefix, int length) : prefix(prefix), length(length), hasValue(false), value(), parent(NULL) { children[0] = children[1] = NULL; }
+    };
+
+    Node *root;
+    int numValues;
+    int numNodes;
+
+  private:
+    IPv4PrefixTrie(const IPv4PrefixTrie&);
+    IPv4PrefixTrie& operator=(const IPv4PrefixTrie&);
+
+  protected:
+    static uint32 mask(int length) { return length == 0 ? 0 : (0xffffffffu << (32 - length)); }
+    static int bitAt(uint32 addr, int index) { return (addr >> (31 - index)) & 1; }
+
+    static int commonPrefixLength(uint32 a, uint32 b, int maxLength)
+    {
+        uint32 diff = a ^ b;
+        int length = 0;
+        while (length < maxLength && !(diff & (0x80000000u >> length)))
+            length++;
+        return length;
+    }
+
+    Node *findNode(uint32 prefix, int length) const
+    {
+        Node *node = root;
+        while (node && node->length <= length && (prefix & mask(node->length)) == node->prefix)
+        {
+            if (node->length == length)
+                return node;
+            node = node->children[bitAt(prefix, node->length)];
+        }
+        return NULL;
+    }
+
+    Node *findOrCreateNode(uint32 prefix, int length)
+    {
+        Node *parent = NULL;
+        Node **slot = &root;
+        while (*slot)
+        {
+            Node *node = *slot;
+            int common = commonPrefixLength(node->prefix, prefix, std::min(node->length, length));
+            if (common == node->length)
+            {
+                // node's prefix contains the new one
+                if (length == node->length)
+                    return node;
+                parent = node;
+                slot = &node->children[bitAt(prefix, node->length)];
+                continue;
+            }
+
+            // the new prefix diverges from node's prefix at bit 'common' (or ends there):
+            // insert a new node above node
+            Node *newNode = new Node(prefix, length);
+            numNodes++;
+            if (common == length)
+            {
+                // new prefix contains node's prefix
+                newNode->children[bitAt(node->prefix, length)] = node;
+                node->parent = newNode;
+                newNode->parent = parent;
+                *slot = newNode;
+            }
+            else
+            {
+                // branching node without value
+                Node *glue = new Node(prefix & mask(common), common);
+                numNodes++;
+                glue->children[bitAt(node->prefix, common)] = node;
+                glue->children[bitAt(prefix, common)] = newNode;
+                node->parent = glue;
+                newNode->parent = glue;
+                glue->parent = parent;
+                *slot = glue;
+            }
+            return newNode;
+        }
+
+        Node *node = new Node(prefix, length);
+        numNodes++;
+        node->parent = parent;
+        *slot = node;
+        return node;
+    }
+
+    void pruneNode(Node *node)
+    {
+        // remove nodes without value that do not branch, bottom-up
+        while (node && !node->hasValue && !(node->children[0] && node->children[1]))
+        {
+            Node *parent = node->parent;
+            Node *child = node->children[0] ? node->children[0] : node->children[1];
+            if (!parent)
+                root = child;
+            else
+                parent->children[parent->children[0] == node ? 0 : 1] = child;
+            if (child)
+                child->parent = parent;
+            delete node;
+            numNodes--;
+            node = parent;
+        }
+    }
+
+    static void deleteSubtree(Node *node)
+    {
+        if (node)
+        {
+            deleteSubtree(node->children[0]);
+            deleteSubtree(node->children[1]);
+            delete node;
+        }
+    }
+
+    static void collectValues(Node *node, std::vector<T *>& result)
+    {
+        for (; node; node = node->children[1])
+        {
+            if (node->hasValue)
+                result.push_back(&node->value);
+            collectValues(node->children[0], result);
+        }
+    }
+
+  public:
+    IPv4PrefixTrie() : root(NULL), numValues(0), numNodes(0) {}
+    ~IPv4PrefixTrie() { deleteSubtree(root); }
+
+    /**
+     * Returns the value stored under exactly the given prefix, or NULL.
+     */
+    T *find(const IPv4Address& address, int length)
+    {
+        Node *node = findNode(address.getInt() & mask(length), length);
+        return node && node->hasValue ? &node->value : NULL;
+    }
+
+    const T *find(const IPv4Address& address, int length) const
+    {
+        Node *node = findNode(address.getInt() & mask(length), length);
+        return node && node->hasValue ? &node->value : NULL;
+    }
+
+    /**
+     * Stores the values of all prefixes that contain the given address into
+     * matches, shortest prefix first, and returns their number. There can be
+     * at most 33 of them (prefix lengths 0..32).
+     */
+    int findMatches(const IPv4Address& address, const T *matches[33]) const
+    {
+        int numMatches = 0;
+        uint32 addr = address.getInt();
+        const Node *node = root;
+        while (node && (addr & mask(node->length)) == node->prefix)
+        {
+            if (node->hasValue)
+                matches[numMatches++] = &node->value;
+            if (node->length == 32)
+                break;
+            node = node->children[bitAt(addr, node->length)];
+        }
+        return numMatches;
+    }
+
+    /**
+     * Returns the value stored under the given prefix; a default constructed
+     * value is stored first if there is none.
+     */
+    T& insert(const IPv4Address& address, int length)
+    {
+        ASSERT(length >= 0 && length <= 32);
+        Node *node = findOrCreateNode(address.getInt() & mask(length), length);
+        if (!node->hasValue)
+        {
+            node->hasValue = true;
+            numValues++;
+        }
+        return node->value;
+    }
+
+    /**
+     * Removes the value stored under the given prefix. Returns false if
+     * there was none.
+     */
+    bool erase(const IPv4Address& address, int length)
+    {
+        Node *node = findNode(address.getInt() & mask(length), length);
+        if (!node || !node->hasValue)
+            return false;
+        node->hasValue = false;
+        node->value = T();
+        numValues--;
+        pruneNode(node);
+        return true;
+    }
+
+    /**
+     * Removes all values.
+     */
+    void clear()
+    {
+        deleteSubtree(root);
+        root = NULL;
+        numValues = numNodes = 0;
+    }
+
+    /**
+     * Appends pointers to all stored values to result, in the order of
+     * their prefixes (shorter prefixes first among nested ones).
+     */
+    void getValues(std::vector<T *>& result)
+    {
+        result.reserve(result.size() + numValues);
+        collectValues(root, result);
+    }
+
+    /**
+     * Returns the number of stored values.
+     */
+    int size() const { return numValues; }
+
+    /**
+     * Returns the number of trie nodes, for statistics and testing.
+     */
+    int getNumNodes() const { return numNodes; }
+};
+
+#endif
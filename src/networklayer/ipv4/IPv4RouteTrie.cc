@@ -0,0 +1,73 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+
+#include "IPv4RouteTrie.h"
+
+#include "IPv4Route.h"
+
+
+IPv4RouteTrie::IPv4RouteTrie(RouteLessThan routeLessThan)
+{
+    this->routeLessThan = routeLessThan;
+}
+
+void IPv4RouteTrie::clear()
+{
+    trie.clear();
+    routeToPrefix.clear();
+}
+
+void IPv4RouteTrie::addRoute(IPv4Route *route)
+{
+    ASSERT(routeToPrefix.find(route) == routeToPrefix.end());
+
+    Prefix prefix(route->getDestination(), route->getNetmask().getNetmaskLength());
+    RouteVector& routes = trie.insert(prefix.first, prefix.second);
+    routes.insert(std::upper_bound(routes.begin(), routes.end(), route, routeLessThan), route);
+    routeToPrefix[route] = prefix;
+}
+
+bool IPv4RouteTrie::removeRoute(const IPv4Route *route)
+{
+    RouteToPrefixMap::iterator it = routeToPrefix.find(route);
+    if (it == routeToPrefix.end())
+        return false;
+
+    Prefix prefix = it->second;
+    routeToPrefix.erase(it);
+    RouteVector *routes = trie.find(prefix.first, prefix.second);
+    ASSERT(routes);
+    RouteVector::iterator pos = std::find(routes->begin(), routes->end(), route);
+    ASSERT(pos != routes->end());
+    routes->erase(pos);
+    if (routes->empty())
+        trie.erase(prefix.first, prefix.second);
+    return true;
+}
+
+IPv4Route *IPv4RouteTrie::findBestMatchingRoute(const IPv4Address& dest) const
+{
+    const RouteVector *matches[33];
+    int numMatches = trie.findMatches(dest, matches);
+
+    // longest prefix first; fall back to shorter ones if all routes are invalid
+    for (int i = numMatches - 1; i >= 0; i--)
+        for (RouteVector::const_iterator it = matches[i]->begin(); it != matches[i]->end(); ++it)
+            if ((*it)->isValid())
+                return *it;
+    return NULL;
+}
@@ -0,0 +1,96 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IPv4ROUTETRIE_H
+#define __INET_IPv4ROUTETRIE_H
+
+#include <map>
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "IPv4Address.h"
+#include "IPv4PrefixTrie.h"
+
+class IPv4Route;
+
+
+/**
+ * Longest prefix match index over IPv4 unicast routes, used by RoutingTable.
+ *
+ * The index is an IPv4PrefixTrie that maps every prefix to the routes
+ * with exactly that prefix.
+ *
+ * Routes with the same prefix are kept in the order given by the
+ * comparison function passed to the constructor (best first), so lookup
+ * returns exactly the route that a linear scan over the sorted route
+ * vector of RoutingTable would find. Routes whose isValid() returns false
+ * are skipped at lookup time.
+ *
+ * Routes are indexed under the prefix they had when they were added, so
+ * they can be removed even after their destination or netmask has been
+ * modified.
+ */
+class INET_API IPv4RouteTrie
+{
+  public:
+    typedef bool (*RouteLessThan)(const IPv4Route *a, const IPv4Route *b);
+
+  protected:
+    typedef std::vector<IPv4Route *> RouteVector;   // routes with the same prefix, best first
+    typedef std::pair<IPv4Address, int> Prefix;
+    typedef std::map<const IPv4Route *, Prefix> RouteToPrefixMap;
+
+    IPv4PrefixTrie<RouteVector> trie;
+    RouteLessThan routeLessThan;
+    RouteToPrefixMap routeToPrefix;
+
+  public:
+    IPv4RouteTrie(RouteLessThan routeLessThan);
+
+    /**
+     * Indexes the route under its current destination and netmask.
+     * The netmask must be a valid (contiguous) netmask.
+     */
+    void addRoute(IPv4Route *route);
+
+    /**
+     * Removes the route from the index. Returns false if it was not indexed.
+     */
+    bool removeRoute(const IPv4Route *route);
+
+    /**
+     * Removes all routes.
+     */
+    void clear();
+
+    /**
+     * Returns the best valid route whose prefix contains the given address,
+     * or NULL if there is none.
+     */
+    IPv4Route *findBestMatchingRoute(const IPv4Address& dest) const;
+
+    /**
+     * Returns the number of indexed routes.
+     */
+    int getNumRoutes() const { return routeToPrefix.size(); }
+
+    /**
+     * Returns the number of trie nodes, for statistics and testing.
+     */
+    int getNumNodes() const { return trie.getNumNodes(); }
+};
+
+#endif
@@ -52,7 +52,7 @@ std::ostream& operator<<(std::ostream& os, const IPv4MulticastRoute& e)
     return os;
 };
 
-RoutingTable::RoutingTable()
+RoutingTable::RoutingTable() : routeTrie(routeLessThan)
 {
     ift = NULL;
     nb = NULL;
@@ -233,6 +233,7 @@ void RoutingTable::deleteInterfaceRoutes(InterfaceEntry *entry)
         if (route->getInterface() == entry)
         {
             it = routes.erase(it);
+            routeTrie.removeRoute(route);
             ASSERT(route->getRoutingTable() == this); // still filled in, for the listeners' benefit
             nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, route);
             delete route;
@@ -277,7 +278,6 @@ void RoutingTable::deleteInterfaceRoutes(InterfaceEntry *entry)
 
 void RoutingTable::invalidateCache()
 {
-    routingCache.clear();
     localAddresses.clear();
     localBroadcastAddresses.clear();
 }
@@ -467,6 +467,7 @@ void RoutingTable::purge()
         else
         {
             it = routes.erase(it);
+            routeTrie.removeRoute(route);
             ASSERT(route->getRoutingTable() == this); // still filled in, for the listeners' benefit
             nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, route);
             delete route;
@@ -501,31 +502,9 @@ IPv4Route *RoutingTable::findBestMatchingRoute(const IPv4Address& dest) const
 {
     Enter_Method("findBestMatchingRoute(%u.%u.%u.%u)", dest.getDByte(0), dest.getDByte(1), dest.getDByte(2), dest.getDByte(3)); // note: str().c_str() too slow here
 
-    RoutingCache::iterator it = routingCache.find(dest);
-    if (it != routingCache.end())
-    {
-        if (it->second==NULL || it->second->isValid())
-            return it->second;
-    }
-
-    // find best match (one with longest prefix)
+    // find best match (one with longest prefix) in the trie;
     // default route has zero prefix length, so (if exists) it'll be selected as last resort
-    IPv4Route *bestRoute = NULL;
-    for (RouteVector::const_iterator i=routes.begin(); i!=routes.end(); ++i)
-    {
-        IPv4Route *e = *i;
-        if (e->isValid())
-        {
-            if (IPv4Address::maskedAddrAreEqual(dest, e->getDestination(), e->getNetmask())) // match
-            {
-                bestRoute = const_cast<IPv4Route *>(e);
-                break;
-            }
-        }
-    }
-
-    routingCache[dest] = bestRoute;
-    return bestRoute;
+    return routeTrie.findBestMatchingRoute(dest);
 }
 
 InterfaceEntry *RoutingTable::getInterfaceForDestAddr(const IPv4Address& dest) const
@@ -644,6 +623,7 @@ void RoutingTable::internalAddRoute(IPv4Route *entry)
     // stop at the first match when doing the longest netmask matching
     RouteVector::iterator pos = upper_bound(routes.begin(), routes.end(), entry, routeLessThan);
     routes.insert(pos, entry);
+    routeTrie.addRoute(entry);
 
     entry->setRoutingTable(this);
 }
@@ -666,6 +646,7 @@ IPv4Route *RoutingTable::internalRemoveRoute(IPv4Route *entry)
     if (i!=routes.end())
     {
         routes.erase(i);
+        routeTrie.removeRoute(entry);
         return entry;
     }
     return NULL;
@@ -858,6 +839,7 @@ void RoutingTable::updateNetmaskRoutes()
             std::vector<IPv4Route *>::iterator it = routes.begin()+(k--);  // '--' is necessary because indices shift down
             IPv4Route *route = *it;
             routes.erase(it);
+            routeTrie.removeRoute(route);
             ASSERT(route->getRoutingTable() == this); // still filled in, for the listeners' benefit
             nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, route);
             delete route;
@@ -884,6 +866,7 @@ void RoutingTable::updateNetmaskRoutes()
             route->setRoutingTable(this);
             RouteVector::iterator pos = upper_bound(routes.begin(), routes.end(), route, routeLessThan);
             routes.insert(pos, route);
+            routeTrie.addRoute(route);
             nb->fireChangeNotification(NF_IPv4_ROUTE_ADDED, route);
         }
     }
@@ -34,6 +34,7 @@
 
 #include "INotifiable.h"
 #include "IPv4Address.h"
+#include "IPv4RouteTrie.h"
 #include "IRoutingTable.h"
 #include "ILifecycle.h"
 
@@ -86,10 +87,6 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
     typedef IPv4MulticastRoute::OutInterface OutInterface;
     typedef IPv4MulticastRoute::OutInterfaceVector OutInterfaceVector;
 
-    // routing cache: maps destination address to the route
-    typedef std::map<IPv4Address, IPv4Route *> RoutingCache;
-    mutable RoutingCache routingCache;
-
     // local addresses cache (to speed up isLocalAddress())
     typedef std::set<IPv4Address> AddressSet;
     mutable AddressSet localAddresses;
@@ -103,6 +100,7 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
 
     typedef std::vector<IPv4Route *> RouteVector;
     RouteVector routes;          // Unicast route array, sorted by netmask desc, dest asc, metric asc
+    IPv4RouteTrie routeTrie;     // longest prefix match index over 'routes', maintained together with it
 
     typedef std::vector<IPv4MulticastRoute*> MulticastRouteVector;
     MulticastRouteVector multicastRoutes; // Multicast route array, sorted by netmask desc, origin asc, metric asc
@@ -127,7 +125,7 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
     // delete routes for the given interface
     virtual void deleteInterfaceRoutes(InterfaceEntry *entry);
 
-    // invalidates routing cache and local addresses cache
+    // invalidates local addresses cache
     virtual void invalidateCache();
 
     // helper for sorting routing table, used by addRoute()
@@ -82,6 +82,9 @@ std::ostream& operator<<(std::ostream& os, const RoutingTable6::DestCacheEntry&
 
 RoutingTable6::RoutingTable6()
 {
+    destCacheCapacity = 0;
+    clockHand = destCache.end();
+    numDestCacheHits = numDestCacheMisses = numDestCacheEvictions = 0;
 }
 
 RoutingTable6::~RoutingTable6()
@@ -112,6 +115,13 @@ void RoutingTable6::initialize(int stage)
 
         WATCH_PTRVECTOR(routeList);
         WATCH_MAP(destCache); // FIXME commented out for now
+        destCacheCapacity = par("destCacheCapacity");
+        if (destCacheCapacity < 0)
+            error("destCacheCapacity must not be negative");
+        numDestCacheHits = numDestCacheMisses = numDestCacheEvictions = 0;
+        WATCH(numDestCacheHits);
+        WATCH(numDestCacheMisses);
+        WATCH(numDestCacheEvictions);
         isrouter = par("isRouter");
         multicastForward = par("forwardMulticast");
         WATCH(isrouter);
@@ -162,6 +172,13 @@ void RoutingTable6::initialize(int stage)
     }
 }
 
+void RoutingTable6::finish()
+{
+    recordScalar("destination cache hits", numDestCacheHits);
+    recordScalar("destination cache misses", numDestCacheMisses);
+    recordScalar("destination cache evictions", numDestCacheEvictions);
+}
+
 void RoutingTable6::parseXMLConfigFile()
 {
     // TODO to be revised by Andras
@@ -266,7 +283,7 @@ void RoutingTable6::routeChanged(IPv6Route *entry, int fieldCode)
      the Destination Cache in such a way that all entries will use the latest
      route information.*/
     if (fieldCode==IPv6Route::F_NEXTHOP || fieldCode==IPv6Route::F_IFACE)
-        purgeDestCache();
+        purgeDestCacheForPrefix(entry->getDestPrefix(), entry->getPrefixLength());
 
     updateDisplayString();
 
@@ -518,17 +535,21 @@ const IPv6Address& RoutingTable6::lookupDestCache(const IPv6Address& dest, int&
     DestCache::iterator it = destCache.find(dest);
     if (it == destCache.end())
     {
+        numDestCacheMisses++;
         outInterfaceId = -1;
         return IPv6Address::UNSPECIFIED_ADDRESS;
     }
     DestCacheEntry &entry = it->second;
     if (entry.expiryTime > 0 && simTime() > entry.expiryTime)
     {
-        destCache.erase(it);
+        numDestCacheMisses++;
+        eraseDestCacheEntry(it);
         outInterfaceId = -1;
         return IPv6Address::UNSPECIFIED_ADDRESS;
     }
 
+    numDestCacheHits++;
+    entry.referenced = true;
     outInterfaceId = entry.interfaceId;
     return entry.nextHopAddr;
 }
@@ -576,7 +597,15 @@ bool RoutingTable6::isPrefixPresent(const IPv6Address& prefix) const
 
 void RoutingTable6::updateDestCache(const IPv6Address& dest, const IPv6Address& nextHopAddr, int interfaceId, simtime_t expiryTime)
 {
-    DestCacheEntry &entry = destCache[dest];
+    DestCache::iterator it = destCache.find(dest);
+    if (it == destCache.end())
+    {
+        if (destCacheCapacity > 0 && (int)destCache.size() >= destCacheCapacity)
+            evictDestCacheEntry();
+        it = destCache.insert(std::make_pair(dest, DestCacheEntry())).first;
+        it->second.referenced = false;
+    }
+    DestCacheEntry &entry = it->second;
     entry.nextHopAddr = nextHopAddr;
     entry.interfaceId = interfaceId;
     entry.expiryTime = expiryTime;
@@ -584,9 +613,51 @@ void RoutingTable6::updateDestCache(const IPv6Address& dest, const IPv6Address&
     updateDisplayString();
 }
 
+void RoutingTable6::eraseDestCacheEntry(DestCache::iterator it)
+{
+    if (it == clockHand)
+        ++clockHand;
+    destCache.erase(it);
+}
+
+void RoutingTable6::evictDestCacheEntry()
+{
+    // CLOCK: sweep the entries in a circle, giving referenced ones a second
+    // chance (clearing their bit), and evict the first unreferenced one
+    ASSERT(!destCache.empty());
+    while (true)
+    {
+        if (clockHand == destCache.end())
+            clockHand = destCache.begin();
+        if (clockHand->second.referenced)
+        {
+            clockHand->second.referenced = false;
+            ++clockHand;
+        }
+        else
+        {
+            eraseDestCacheEntry(clockHand);
+            numDestCacheEvictions++;
+            return;
+        }
+    }
+}
+
 void RoutingTable6::purgeDestCache()
 {
     destCache.clear();
+    clockHand = destCache.end();
+    updateDisplayString();
+}
+
+void RoutingTable6::purgeDestCacheForPrefix(const IPv6Address& prefix, int prefixLength)
+{
+    // destCache is ordered by address, so the destinations covered by the
+    // prefix form a contiguous range starting at the masked prefix
+    DestCache::iterator it = destCache.lower_bound(prefix.getPrefix(prefixLength));
+    while (it != destCache.end() && it->first.matches(prefix, prefixLength))
+        eraseDestCacheEntry(it++);
+
     updateDisplayString();
 }
 
@@ -597,7 +668,7 @@ void RoutingTable6::purgeDestCacheEntriesToNeighbour(const IPv6Address& nextHopA
         if (it->second.interfaceId==interfaceId && it->second.nextHopAddr==nextHopAddr)
         {
             // move the iterator past this element before removing it
-            destCache.erase(it++);
+            eraseDestCacheEntry(it++);
         }
         else
         {
@@ -615,7 +686,7 @@ void RoutingTable6::purgeDestCacheForInterfaceID(int interfaceId)
         if (it->second.interfaceId==interfaceId)
         {
             // move the iterator past this element before removing it
-            destCache.erase(it++);
+            eraseDestCacheEntry(it++);
         }
         else
         {
@@ -785,9 +856,9 @@ void RoutingTable6::addRoute(IPv6Route *route)
     // stop at the first match when doing the longest prefix matching
     std::sort(routeList.begin(), routeList.end(), routeLessThan);
 
-    /*XXX: this deletes some cache entries we want to keep, but the node MUST update
-     the Destination Cache in such a way that the latest route information are used.*/
-    purgeDestCache();
+    // the node MUST update the Destination Cache in such a way that the latest
+    // route information are used; only destinations covered by the new prefix are affected
+    purgeDestCacheForPrefix(route->getDestPrefix(), route->getPrefixLength());
     updateDisplayString();
 
     nb->fireChangeNotification(NF_IPv6_ROUTE_ADDED, route);
@@ -801,13 +872,13 @@ void RoutingTable6::removeRoute(IPv6Route *route)
     nb->fireChangeNotification(NF_IPv6_ROUTE_DELETED, route); // rather: going to be deleted
 
     routeList.erase(it);
-    delete route;
 
-    /*XXX: this deletes some cache entries we want to keep, but the node MUST update
-     the Destination Cache in such a way that all entries using the next-hop from
-     the deleted route perform next-hop determination again rather than continue
-     sending traffic using that deleted route next-hop.*/
-    purgeDestCache();
+    // the node MUST update the Destination Cache in such a way that all entries
+    // using the next-hop from the deleted route perform next-hop determination again
+    // rather than continue sending traffic using that deleted route next-hop;
+    // those entries are all covered by the route's prefix
+    purgeDestCacheForPrefix(route->getDestPrefix(), route->getPrefixLength());
+    delete route;
     updateDisplayString();
 }
 
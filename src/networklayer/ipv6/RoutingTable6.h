@@ -166,12 +166,22 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable, publ
         int interfaceId;
         IPv6Address nextHopAddr;
         simtime_t expiryTime;
+        bool referenced;  // CLOCK reference bit, set on every cache hit
         // more destination specific data may be added here, e.g. path MTU
     };
     friend std::ostream& operator<<(std::ostream& os, const DestCacheEntry& e);
     typedef std::map<IPv6Address,DestCacheEntry> DestCache;
     DestCache destCache;
 
+    // The Destination Cache holds at most destCacheCapacity entries (0 means
+    // unlimited); when it is full, an entry is evicted with the CLOCK algorithm.
+    // Entries are recomputed on demand, so eviction only costs a new lookup.
+    int destCacheCapacity;
+    DestCache::iterator clockHand;
+    long numDestCacheHits;
+    long numDestCacheMisses;
+    long numDestCacheEvictions;
+
     // RouteList contains local prefixes, and (for routers)
     // static, OSPF, RIP etc routes as well
     typedef std::vector<IPv6Route*> RouteList;
@@ -210,6 +220,7 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable, publ
   protected:
     virtual int numInitStages() const  {return 5;}
     virtual void initialize(int stage);
+    virtual void finish();
     virtual void parseXMLConfigFile();
 
     /**
@@ -330,6 +341,23 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable, publ
      */
     void purgeDestCacheForInterfaceID(int interfaceId);
 
+    /**
+     * Removes the destination cache entries of the destinations covered by
+     * the given prefix. Called when a route for that prefix is added, removed
+     * or changed, because only those destinations may be routed differently.
+     */
+    virtual void purgeDestCacheForPrefix(const IPv6Address& prefix, int prefixLength);
+
+    /**
+     * Removes the given entry from the destination cache, keeping the CLOCK hand valid.
+     */
+    void eraseDestCacheEntry(DestCache::iterator it);
+
+    /**
+     * Makes room for a new destination cache entry using the CLOCK algorithm.
+     */
+    void evictDestCacheEntry();
+
     //@}
 
     /** @name Managing prefixes and the route table */
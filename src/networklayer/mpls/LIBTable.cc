@@ -21,6 +21,12 @@
 Define_Module(LIBTable);
 
 
+LIBTable::LIBTable()
+{
+    maxLabel = 0;
+    rehash(16);
+}
+
 void LIBTable::initialize(int stage)
 {
     cSimpleModule::initialize(stage);
@@ -46,26 +52,119 @@ void LIBTable::handleMessage(cMessage *)
     ASSERT(false);
 }
 
-bool LIBTable::resolveLabel(std::string inInterface, int inLabel,
-        LabelOpVector& outLabel, std::string& outInterface, int& color)
+int LIBTable::getInterfaceKey(const std::string& interfaceName)
+{
+    std::map<std::string, int>::iterator it = interfaceKeys.find(interfaceName);
+    if (it != interfaceKeys.end())
+        return it->second;
+
+    int key = interfaceNames.size();
+    interfaceNames.push_back(interfaceName);
+    interfaceKeys[interfaceName] = key;
+    return key;
+}
+
+int LIBTable::findIndex(int inLabel) const
 {
-    bool any = (inInterface.length() == 0);
+    for (unsigned int slot = slotOf(inLabel); slots[slot] != -1; slot = (slot + 1) & (slots.size() - 1))
+        if (lib[slots[slot]].inLabel == inLabel)
+            return slots[slot];
+    return -1;
+}
 
-    for (unsigned int i = 0; i < lib.size(); i++)
+const LIBTable::LIBEntry *LIBTable::findEntry(int inInterfaceKey, int inLabel) const
+{
+    // entries of the same label follow each other in the probe sequence
+    for (unsigned int slot = slotOf(inLabel); slots[slot] != -1; slot = (slot + 1) & (slots.size() - 1))
     {
-        if (!any && lib[i].inInterface != inInterface)
-            continue;
+        const LIBEntry& entry = lib[slots[slot]];
+        if (entry.inLabel == inLabel && (inInterfaceKey == ANY_INTERFACE || entry.inInterfaceKey == inInterfaceKey))
+            return &entry;
+    }
+    return NULL;
+}
 
-        if (lib[i].inLabel != inLabel)
-            continue;
+void LIBTable::addEntry(const LIBEntry& entry)
+{
+    if (2 * (lib.size() + 1) > slots.size())
+        rehash(2 * slots.size());
+
+    lib.push_back(entry);
+    LIBEntry& newEntry = lib.back();
+    newEntry.inInterfaceKey = getInterfaceKey(entry.inInterface);
+    newEntry.outInterfaceKey = getInterfaceKey(entry.outInterface);
+
+    unsigned int slot = slotOf(entry.inLabel);
+    while (slots[slot] != -1)
+        slot = (slot + 1) & (slots.size() - 1);
+    slots[slot] = lib.size() - 1;
+}
 
-        outLabel = lib[i].outLabel;
-        outInterface = lib[i].outInterface;
-        color = lib[i].color;
+void LIBTable::removeEntry(int index)
+{
+    unsigned int mask = slots.size() - 1;
+    unsigned int hole = slotOf(lib[index].inLabel);
+    while (slots[hole] != index)
+        hole = (hole + 1) & mask;
+
+    // backward shift deletion: move up entries that would no longer be
+    // reachable from their home slot across the hole
+    for (unsigned int slot = (hole + 1) & mask; slots[slot] != -1; slot = (slot + 1) & mask)
+    {
+        unsigned int home = slotOf(lib[slots[slot]].inLabel);
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+            slots[hole] = slots[slot];
+            hole = slot;
+        }
+    }
+    slots[hole] = -1;
 
-        return true;
+    // fill the gap in lib with its last entry
+    int last = lib.size() - 1;
+    if (index != last)
+    {
+        unsigned int slot = slotOf(lib[last].inLabel);
+        while (slots[slot] != last)
+            slot = (slot + 1) & mask;
+        slots[slot] = index;
+        lib[index] = lib[last];
     }
-    return false;
+    lib.pop_back();
+}
+
+void LIBTable::rehash(unsigned int numSlots)
+{
+    slots.assign(numSlots, -1);
+    for (unsigned int i = 0; i < lib.size(); i++)
+    {
+        unsigned int slot = slotOf(lib[i].inLabel);
+        while (slots[slot] != -1)
+            slot = (slot + 1) & (numSlots - 1);
+        slots[slot] = i;
+    }
+}
+
+bool LIBTable::resolveLabel(std::string inInterface, int inLabel,
+        LabelOpVector& outLabel, std::string& outInterface, int& color)
+{
+    int inInterfaceKey = ANY_INTERFACE;
+    if (inInterface.length() != 0)
+    {
+        std::map<std::string, int>::iterator it = interfaceKeys.find(inInterface);
+        if (it == interfaceKeys.end())
+            return false;
+        inInterfaceKey = it->second;
+    }
+
+    const LIBEntry *entry = findEntry(inInterfaceKey, inLabel);
+    if (!entry)
+        return false;
+
+    outLabel = entry->outLabel;
+    outInterface = entry->outInterface;
+    color = entry->color;
+    return true;
 }
 
 int LIBTable::installLibEntry(int inLabel, std::string inInterface, const LabelOpVector& outLabel,
@@ -79,38 +178,29 @@ int LIBTable::installLibEntry(int inLabel, std::string inInterface, const LabelO
         newItem.outLabel = outLabel;
         newItem.outInterface = outInterface;
         newItem.color = color;
-        lib.push_back(newItem);
+        addEntry(newItem);
         return newItem.inLabel;
     }
     else
     {
-        for (unsigned int i = 0; i < lib.size(); i++)
-        {
-            if (lib[i].inLabel != inLabel)
-                continue;
-
-            lib[i].inInterface = inInterface;
-            lib[i].outLabel = outLabel;
-            lib[i].outInterface = outInterface;
-            lib[i].color = color;
-            return inLabel;
-        }
-        ASSERT(false);
-        return 0; // prevent warning
+        int index = findIndex(inLabel);
+        ASSERT(index != -1);
+
+        lib[index].inInterface = inInterface;
+        lib[index].outLabel = outLabel;
+        lib[index].outInterface = outInterface;
+        lib[index].color = color;
+        lib[index].inInterfaceKey = getInterfaceKey(inInterface);
+        lib[index].outInterfaceKey = getInterfaceKey(outInterface);
+        return inLabel;
     }
 }
 
 void LIBTable::removeLibEntry(int inLabel)
 {
-    for (unsigned int i = 0; i < lib.size(); i++)
-    {
-        if (lib[i].inLabel != inLabel)
-            continue;
-
-        lib.erase(lib.begin() + i);
-        return;
-    }
-    ASSERT(false);
+    int index = findIndex(inLabel);
+    ASSERT(index != -1);
+    removeEntry(index);
 }
 
 void LIBTable::readTableFromXML(const cXMLElement* libtable)
@@ -165,10 +255,10 @@ void LIBTable::readTableFromXML(const cXMLElement* libtable)
             newItem.outLabel.push_back(l);
         }
 
-        lib.push_back(newItem);
-
         ASSERT(newItem.inLabel > 0);
 
+        addEntry(newItem);
+
         if (newItem.inLabel > maxLabel)
             maxLabel = newItem.inLabel;
     }
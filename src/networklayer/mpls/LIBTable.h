@@ -16,6 +16,7 @@
 #ifndef __INET_LIBTABLE_H
 #define __INET_LIBTABLE_H
 
+#include <map>
 #include <vector>
 #include <string>
 
@@ -57,13 +58,29 @@ class INET_API LIBTable: public cSimpleModule
 
             // FIXME colors in nam, temporary solution
             int color;
+
+            // interned inInterface and outInterface, see getInterfaceKey()
+            int inInterfaceKey;
+            int outInterfaceKey;
         };
 
+        /** Interface key that matches any incoming interface in findEntry() */
+        static const int ANY_INTERFACE = -1;
+
     protected:
         IPv4Address routerId;
         int maxLabel;
         std::vector<LIBEntry> lib;
 
+        // Open addressing hash table with linear probing on inLabel; each
+        // slot holds an index into lib, or -1 if empty. The table is at most
+        // half full, and kept free of tombstones by backward shift deletion.
+        std::vector<int> slots;
+
+        // interface names seen in the table, indexed by interface key
+        std::vector<std::string> interfaceNames;
+        std::map<std::string, int> interfaceKeys;
+
     protected:
         virtual void initialize(int stage);
         virtual int numInitStages() const { return 5; }
@@ -72,7 +89,16 @@ class INET_API LIBTable: public cSimpleModule
         // static configuration
         virtual void readTableFromXML(const cXMLElement* libtable);
 
+        // hash table maintenance
+        unsigned int slotOf(int inLabel) const { return ((unsigned int)inLabel * 2654435761u) & (slots.size() - 1); }
+        int findIndex(int inLabel) const;
+        void addEntry(const LIBEntry& entry);
+        void removeEntry(int index);
+        void rehash(unsigned int numSlots);
+
     public:
+        LIBTable();
+
         // label management
         virtual bool resolveLabel(std::string inInterface, int inLabel,
                           LabelOpVector& outLabel, std::string& outInterface, int& color);
@@ -82,6 +108,24 @@ class INET_API LIBTable: public cSimpleModule
 
         virtual void removeLibEntry(int inLabel);
 
+        /**
+         * Per-packet variant of resolveLabel(): returns the entry of inLabel
+         * on the given incoming interface (or on any interface if inInterfaceKey
+         * is ANY_INTERFACE), or NULL. Takes constant time and does not allocate.
+         * The returned pointer is invalidated by the next change of the table.
+         */
+        const LIBEntry *findEntry(int inInterfaceKey, int inLabel) const;
+
+        /**
+         * Returns the key of the given interface name, to be used with
+         * findEntry(). Keys are small nonnegative integers, and remain valid
+         * for the lifetime of the table.
+         */
+        int getInterfaceKey(const std::string& interfaceName);
+
+        /** Returns the interface name of the given key */
+        const std::string& getInterfaceName(int interfaceKey) const { return interfaceNames.at(interfaceKey); }
+
         // utility
         static LabelOpVector pushLabel(int label);
         static LabelOpVector swapLabel(int label);
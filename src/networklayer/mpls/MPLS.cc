@@ -213,12 +213,10 @@ void MPLS::processPacketFromL2(cMessage *msg)
 void MPLS::processMPLSPacketFromL2(MPLSPacket *mplsPacket)
 {
     int gateIndex = mplsPacket->getArrivalGate()->getIndex();
-    InterfaceEntry *ie = ift->getInterfaceByNetworkLayerGateIndex(gateIndex);
-    std::string senderInterface = ie->getName();
     ASSERT(mplsPacket->hasLabel());
     int oldLabel = mplsPacket->getTopLabel();
 
-    EV << "Received " << mplsPacket << " from L2, label=" << oldLabel << " inInterface=" << senderInterface << endl;
+    EV << "Received " << mplsPacket << " from L2, label=" << oldLabel << " inInterface=" << ift->getInterfaceByNetworkLayerGateIndex(gateIndex)->getName() << endl;
 
     if (oldLabel==-1)
     {
@@ -232,12 +230,8 @@ void MPLS::processMPLSPacketFromL2(MPLSPacket *mplsPacket)
         return;
     }
 
-    LabelOpVector outLabel;
-    std::string outInterface;
-    int color;
-
-    bool found = lt->resolveLabel(senderInterface, oldLabel, outLabel, outInterface, color);
-    if (!found)
+    const LIBTable::LIBEntry *entry = lt->findEntry(getInInterfaceKey(gateIndex), oldLabel);
+    if (!entry)
     {
         EV << "discarding packet, incoming label not resolved" << endl;
 
@@ -245,15 +239,16 @@ void MPLS::processMPLSPacketFromL2(MPLSPacket *mplsPacket)
         return;
     }
 
-    int outgoingPort = ift->getInterfaceByName(outInterface.c_str())->getNetworkLayerGateIndex();
+    int outgoingPort = getOutGateIndex(entry->outInterfaceKey);
+    int color = entry->color;
 
-    doStackOps(mplsPacket, outLabel);
+    doStackOps(mplsPacket, entry->outLabel);
 
     if (mplsPacket->hasLabel())
     {
         // forward labeled packet
 
-        EV << "forwarding packet to " << outInterface << endl;
+        EV << "forwarding packet to " << entry->outInterface << endl;
 
         if (mplsPacket->hasPar("color"))
         {
@@ -287,3 +282,27 @@ void MPLS::processMPLSPacketFromL2(MPLSPacket *mplsPacket)
         }
     }
 }
+
+int MPLS::getInInterfaceKey(int gateIndex)
+{
+    if (gateIndex >= (int)inInterfaceKeys.size())
+        inInterfaceKeys.resize(gateIndex + 1, -2);
+    if (inInterfaceKeys[gateIndex] == -2)
+        inInterfaceKeys[gateIndex] = lt->getInterfaceKey(ift->getInterfaceByNetworkLayerGateIndex(gateIndex)->getName());
+    return inInterfaceKeys[gateIndex];
+}
+
+int MPLS::getOutGateIndex(int interfaceKey)
+{
+    if (interfaceKey >= (int)outGateIndices.size())
+        outGateIndices.resize(interfaceKey + 1, -2);
+    if (outGateIndices[interfaceKey] == -2)
+    {
+        const std::string& name = lt->getInterfaceName(interfaceKey);
+        InterfaceEntry *ie = ift->getInterfaceByName(name.c_str());
+        if (!ie)
+            error("LIB refers to unknown interface '%s'", name.c_str());
+        outGateIndices[interfaceKey] = ie->getNetworkLayerGateIndex();
+    }
+    return outGateIndices[interfaceKey];
+}
@@ -45,6 +45,11 @@ class INET_API MPLS : public cSimpleModule
         IInterfaceTable *ift;
         IClassifier *pct;
 
+        // LIB interface keys of the interfaces by network layer gate index,
+        // and network layer gate indices by LIB interface key; -2 if not yet known
+        std::vector<int> inInterfaceKeys;
+        std::vector<int> outGateIndices;
+
     protected:
         virtual void initialize(int stage);
         virtual int numInitStages() const { return 5; }
@@ -60,6 +65,10 @@ class INET_API MPLS : public cSimpleModule
 
         virtual void sendToL2(cMessage *msg, int gateIndex);
         virtual void doStackOps(MPLSPacket *mplsPacket, const LabelOpVector& outLabel);
+
+        // cached name lookups of the label switching path
+        virtual int getInInterfaceKey(int gateIndex);
+        virtual int getOutGateIndex(int interfaceKey);
 };
 
 #endif
@@ -38,6 +38,10 @@ OSPFRouting::OSPFRouting()
 {
     isUp = false;
     ospfRouter = NULL;
+    rebuildCount = 0;
+    spfCalculationCount = 0;
+    skippedSPFCalculationCount = 0;
+    spfCalculationTime = 0;
 }
 
 OSPFRouting::~OSPFRouting()
@@ -64,6 +68,8 @@ void OSPFRouting::createOspfRouter()
 {
     IRoutingTable *rt = RoutingTableAccess().get();
     ospfRouter = new OSPF::Router(rt->getRouterId(), this);
+    ospfRouter->setIncrementalSPF(par("incrementalSPF").boolValue());
+    ospfRouter->setSPFThrottling(par("spfInitialDelay").doubleValue(), par("spfHoldTime").doubleValue(), par("spfMaxWaitTime").doubleValue());
 
     // read the OSPF AS configuration
     cXMLElement *ospfConfig = par("ospfConfig").xmlValue();
@@ -74,6 +80,16 @@ void OSPFRouting::createOspfRouter()
     ospfRouter->addWatches();
 }
 
+void OSPFRouting::deleteOspfRouter()
+{
+    rebuildCount += ospfRouter->getRebuildCount();
+    spfCalculationCount += ospfRouter->getSPFCalculationCount();
+    skippedSPFCalculationCount += ospfRouter->getSkippedSPFCalculationCount();
+    spfCalculationTime += ospfRouter->getSPFCalculationTime();
+    delete ospfRouter;
+    ospfRouter = NULL;
+}
+
 void OSPFRouting::handleMessage(cMessage *msg)
 {
     if (!isUp)
@@ -107,8 +123,7 @@ bool OSPFRouting::handleOperationStage(LifecycleOperation *operation, int stage,
         if (stage == NodeShutdownOperation::STAGE_ROUTING_PROTOCOLS) {
             ASSERT(ospfRouter);
             isUp = false;
-            delete ospfRouter;
-            ospfRouter = NULL;
+            deleteOspfRouter();
         }
     }
     else if (dynamic_cast<NodeCrashOperation *>(operation))
@@ -116,8 +131,7 @@ bool OSPFRouting::handleOperationStage(LifecycleOperation *operation, int stage,
         if (stage == NodeCrashOperation::STAGE_CRASH) {
             ASSERT(ospfRouter);
             isUp = false;
-            delete ospfRouter;
-            ospfRouter = NULL;
+            deleteOspfRouter();
         }
     }
     else
@@ -127,6 +141,15 @@ bool OSPFRouting::handleOperationStage(LifecycleOperation *operation, int stage,
     return true;
 }
 
+void OSPFRouting::finish()
+{
+    bool hasRouter = ospfRouter != NULL;
+    recordScalar("routing table rebuilds", rebuildCount + (hasRouter ? ospfRouter->getRebuildCount() : 0));
+    recordScalar("SPF calculations", spfCalculationCount + (hasRouter ? ospfRouter->getSPFCalculationCount() : 0));
+    recordScalar("skipped SPF calculations", skippedSPFCalculationCount + (hasRouter ? ospfRouter->getSkippedSPFCalculationCount() : 0));
+    recordScalar("SPF calculation time", spfCalculationTime + (hasRouter ? ospfRouter->getSPFCalculationTime() : 0), "s");
+}
+
 bool OSPFRouting::isNodeUp()
 {
     NodeStatus *nodeStatus = dynamic_cast<NodeStatus *>(findContainingNode(this)->getSubmodule("status"));
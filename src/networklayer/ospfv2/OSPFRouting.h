@@ -39,6 +39,12 @@ class OSPFRouting :  public cSimpleModule, public ILifecycle
     bool isUp;
     OSPF::Router *ospfRouter; // root object of the OSPF data structure
 
+    // statistics of the routers deleted by shutdown and crash operations
+    unsigned long rebuildCount;
+    unsigned long spfCalculationCount;
+    unsigned long skippedSPFCalculationCount;
+    double spfCalculationTime;
+
   public:
     OSPFRouting();
     virtual ~OSPFRouting();
@@ -61,8 +67,10 @@ class OSPFRouting :  public cSimpleModule, public ILifecycle
     virtual void initialize(int stage);
     virtual void handleMessage(cMessage *msg);
     virtual void handleMessageWhenDown(cMessage *msg);
+    virtual void finish();
     virtual bool handleOperationStage(LifecycleOperation *operation, int stage, IDoneCallback *doneCallback);
     virtual void createOspfRouter();
+    virtual void deleteOspfRouter();
     virtual bool isNodeUp();
 };
 
@@ -165,6 +165,12 @@ void OSPF::MessageHandler::handleTimer(cMessage* timer)
                 router->ageDatabase();
             }
             break;
+        case SPF_CALCULATION_TIMER:
+            {
+                printEvent("SPF Timer expired");
+                router->rebuildRoutingTableNow();
+            }
+            break;
         default: break;
     }
 }
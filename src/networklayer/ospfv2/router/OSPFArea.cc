@@ -18,6 +18,37 @@
 #include "OSPFArea.h"
 #include "OSPFRouter.h"
 #include <memory.h>
+#include <functional>
+#include <queue>
+#include <set>
+
+namespace {
+
+/**
+ * Entry of the candidate list of the shortest path calculation, ordered by
+ * distance (RFC2328 16.1 (3)). At the same distance network vertices come
+ * first, then the vertices that became candidates earlier.
+ */
+struct SPFCandidate
+{
+    unsigned long distance;
+    bool          isRouter;
+    unsigned long sequence;
+    OSPFLSA*      vertex;
+
+    SPFCandidate(unsigned long distance, bool isRouter, unsigned long sequence, OSPFLSA* vertex) :
+        distance(distance), isRouter(isRouter), sequence(sequence), vertex(vertex) {}
+
+    bool operator>(const SPFCandidate& other) const {
+        if (distance != other.distance) return distance > other.distance;
+        if (isRouter != other.isRouter) return isRouter;
+        return sequence > other.sequence;
+    }
+};
+
+typedef std::priority_queue<SPFCandidate, std::vector<SPFCandidate>, std::greater<SPFCandidate> > SPFCandidateList;
+
+}
 
 OSPF::Area::Area(OSPF::AreaID id) :
     areaID(id),
@@ -1346,13 +1377,97 @@ OSPF::SummaryLSA* OSPF::Area::originateSummaryLSA(const OSPF::SummaryLSA* summar
     return NULL;
 }
 
+void OSPF::Area::collectShortestPathTreeInputs(std::vector<uint64>& inputs) const
+{
+    unsigned long i, j;
+
+    // everything calculateShortestPathTree() and calculateNextHops() read, except the routing table;
+    // the LSA pointers are included, because the routing table entries point to the LSAs
+    inputs.clear();
+    inputs.push_back((uint64)(size_t)spfTreeRoot);
+    inputs.push_back(parentRouter->getRouterID().getInt());
+
+    inputs.push_back(routerLSAs.size());
+    for (i = 0; i < routerLSAs.size(); i++) {
+        const OSPF::RouterLSA* lsa = routerLSAs[i];
+        const OSPFLSAHeader& header = lsa->getHeader();
+        inputs.push_back((uint64)(size_t)lsa);
+        inputs.push_back(header.getLinkStateID().getInt());
+        inputs.push_back(header.getAdvertisingRouter().getInt());
+        inputs.push_back((uint64)header.getLsSequenceNumber());
+        inputs.push_back(header.getLsAge() == MAX_AGE);
+        inputs.push_back((lsa->getV_VirtualLinkEndpoint() ? 1 : 0) | (lsa->getE_ASBoundaryRouter() ? 2 : 0) | (lsa->getB_AreaBorderRouter() ? 4 : 0));
+        unsigned int linkCount = lsa->getLinksArraySize();
+        inputs.push_back(linkCount);
+        for (j = 0; j < linkCount; j++) {
+            const Link& link = lsa->getLinks(j);
+            inputs.push_back(link.getLinkID().getInt());
+            inputs.push_back(link.getLinkData());
+            inputs.push_back(link.getType());
+            inputs.push_back(link.getLinkCost());
+        }
+    }
+
+    inputs.push_back(networkLSAs.size());
+    for (i = 0; i < networkLSAs.size(); i++) {
+        const OSPF::NetworkLSA* lsa = networkLSAs[i];
+        const OSPFLSAHeader& header = lsa->getHeader();
+        inputs.push_back((uint64)(size_t)lsa);
+        inputs.push_back(header.getLinkStateID().getInt());
+        inputs.push_back(header.getAdvertisingRouter().getInt());
+        inputs.push_back((uint64)header.getLsSequenceNumber());
+        inputs.push_back(header.getLsAge() == MAX_AGE);
+        inputs.push_back(lsa->getNetworkMask().getInt());
+        unsigned int routerCount = lsa->getAttachedRoutersArraySize();
+        inputs.push_back(routerCount);
+        for (j = 0; j < routerCount; j++) {
+            inputs.push_back(lsa->getAttachedRouters(j).getInt());
+        }
+    }
+
+    inputs.push_back(associatedInterfaces.size());
+    for (i = 0; i < associatedInterfaces.size(); i++) {
+        const OSPF::Interface* intf = associatedInterfaces[i];
+        inputs.push_back(intf->getType());
+        inputs.push_back(intf->getState());
+        inputs.push_back(intf->getIfIndex());
+        inputs.push_back(intf->getAddressRange().address.getInt());
+        inputs.push_back(intf->getAddressRange().mask.getInt());
+        inputs.push_back(intf->getDesignatedRouter().routerID.getInt());
+        inputs.push_back(intf->getDesignatedRouter().ipInterfaceAddress.getInt());
+        unsigned long neighborCount = intf->getNeighborCount();
+        inputs.push_back(neighborCount);
+        for (j = 0; j < neighborCount; j++) {
+            const OSPF::Neighbor* neighbor = intf->getNeighbor(j);
+            inputs.push_back(neighbor->getNeighborID().getInt());
+            inputs.push_back(neighbor->getAddress().getInt());
+            inputs.push_back(neighbor->getState());
+        }
+    }
+}
+
+bool OSPF::Area::hasShortestPathTreeInputsChanged() const
+{
+    if (spfTreeRoot == NULL) {
+        return true;
+    }
+    std::vector<uint64> inputs;
+    collectShortestPathTreeInputs(inputs);
+    return inputs != spfInputs;
+}
+
 void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>& newRoutingTable)
 {
     OSPF::RouterID routerID = parentRouter->getRouterID();
     bool finished = false;
     std::vector<OSPFLSA*> treeVertices;
+    std::set<OSPFLSA*> treeVertexSet;
     OSPFLSA* justAddedVertex;
-    std::vector<OSPFLSA*> candidateVertices;
+    // candidates are kept in a heap; when the distance of a candidate decreases, it is
+    // pushed again, and the entries with the old distance are skipped when they surface
+    SPFCandidateList candidateVertices;
+    std::map<OSPFLSA*, unsigned long> candidateSequence;
+    unsigned long nextCandidateSequence = 0;
     unsigned long            i, j, k;
     unsigned long lsaCount;
 
@@ -1381,6 +1496,7 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
     }
     spfTreeRoot->setDistance(0);
     treeVertices.push_back(spfTreeRoot);
+    treeVertexSet.insert(spfTreeRoot);
     justAddedVertex = spfTreeRoot;          // (1)
 
     do {
@@ -1418,30 +1534,15 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                     continue;
                 }
 
-                unsigned int treeSize = treeVertices.size();
-                bool alreadyOnTree = false;
-
-                for (j = 0; j < treeSize; j++) {
-                    if (treeVertices[j] == joiningVertex) {
-                        alreadyOnTree = true;
-                        break;
-                    }
-                }
-                if (alreadyOnTree) {    // (2) (c)
+                if (treeVertexSet.find(joiningVertex) != treeVertexSet.end()) {    // (2) (c)
                     continue;
                 }
 
                 unsigned long linkStateCost = routerVertex->getDistance() + link.getLinkCost();
-                unsigned int candidateCount = candidateVertices.size();
-                OSPFLSA* candidate = NULL;
+                std::map<OSPFLSA*, unsigned long>::iterator candidateIt = candidateSequence.find(joiningVertex);
 
-                for (j = 0; j < candidateCount; j++) {
-                    if (candidateVertices[j] == joiningVertex) {
-                        candidate = candidateVertices[j];
-                    }
-                }
-                if (candidate != NULL) {    // (2) (d)
-                    OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (candidate);
+                if (candidateIt != candidateSequence.end()) {    // (2) (d)
+                    OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningVertex);
                     unsigned long candidateDistance = routingInfo->getDistance();
 
                     if (linkStateCost > candidateDistance) {
@@ -1450,6 +1551,7 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                     if (linkStateCost < candidateDistance) {
                         routingInfo->setDistance(linkStateCost);
                         routingInfo->clearNextHops();
+                        candidateVertices.push(SPFCandidate(linkStateCost, joiningVertexType == ROUTERLSA_TYPE, candidateIt->second, joiningVertex));
                     }
                     std::vector<OSPF::NextHop>* newNextHops = calculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
                     unsigned int nextHopCount = newNextHops->size();
@@ -1470,7 +1572,8 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                         OSPF::RoutingInfo* vertexRoutingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningRouterVertex);
                         vertexRoutingInfo->setParent(justAddedVertex);
 
-                        candidateVertices.push_back(joiningRouterVertex);
+                        candidateSequence[joiningRouterVertex] = nextCandidateSequence;
+                        candidateVertices.push(SPFCandidate(linkStateCost, true, nextCandidateSequence++, joiningRouterVertex));
                     } else {
                         OSPF::NetworkLSA* joiningNetworkVertex = check_and_cast<OSPF::NetworkLSA*> (joiningVertex);
                         joiningNetworkVertex->setDistance(linkStateCost);
@@ -1483,7 +1586,8 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                         OSPF::RoutingInfo* vertexRoutingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningNetworkVertex);
                         vertexRoutingInfo->setParent(justAddedVertex);
 
-                        candidateVertices.push_back(joiningNetworkVertex);
+                        candidateSequence[joiningNetworkVertex] = nextCandidateSequence;
+                        candidateVertices.push(SPFCandidate(linkStateCost, false, nextCandidateSequence++, joiningNetworkVertex));
                     }
                 }
             }
@@ -1502,30 +1606,15 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                     continue;
                 }
 
-                unsigned int treeSize = treeVertices.size();
-                bool alreadyOnTree = false;
-
-                for (j = 0; j < treeSize; j++) {
-                    if (treeVertices[j] == joiningVertex) {
-                        alreadyOnTree = true;
-                        break;
-                    }
-                }
-                if (alreadyOnTree) {    // (2) (c)
+                if (treeVertexSet.find(joiningVertex) != treeVertexSet.end()) {    // (2) (c)
                     continue;
                 }
 
                 unsigned long linkStateCost = networkVertex->getDistance();   // link cost from network to router is always 0
-                unsigned int candidateCount = candidateVertices.size();
-                OSPFLSA* candidate = NULL;
+                std::map<OSPFLSA*, unsigned long>::iterator candidateIt = candidateSequence.find(joiningVertex);
 
-                for (j = 0; j < candidateCount; j++) {
-                    if (candidateVertices[j] == joiningVertex) {
-                        candidate = candidateVertices[j];
-                    }
-                }
-                if (candidate != NULL) {    // (2) (d)
-                    OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (candidate);
+                if (candidateIt != candidateSequence.end()) {    // (2) (d)
+                    OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningVertex);
                     unsigned long candidateDistance = routingInfo->getDistance();
 
                     if (linkStateCost > candidateDistance) {
@@ -1534,6 +1623,7 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                     if (linkStateCost < candidateDistance) {
                         routingInfo->setDistance(linkStateCost);
                         routingInfo->clearNextHops();
+                        candidateVertices.push(SPFCandidate(linkStateCost, true, candidateIt->second, joiningVertex));
                     }
                     std::vector<OSPF::NextHop>* newNextHops = calculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
                     unsigned int nextHopCount = newNextHops->size();
@@ -1552,44 +1642,32 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                     OSPF::RoutingInfo* vertexRoutingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningVertex);
                     vertexRoutingInfo->setParent(justAddedVertex);
 
-                    candidateVertices.push_back(joiningVertex);
+                    candidateSequence[joiningVertex] = nextCandidateSequence;
+                    candidateVertices.push(SPFCandidate(linkStateCost, true, nextCandidateSequence++, joiningVertex));
                 }
             }
         }
 
+        // drop the entries of vertices whose distance has decreased since they were pushed
+        while (!candidateVertices.empty()) {
+            const SPFCandidate& top = candidateVertices.top();
+            if ((candidateSequence.find(top.vertex) != candidateSequence.end()) &&
+                (check_and_cast<OSPF::RoutingInfo*> (top.vertex)->getDistance() == top.distance))
+            {
+                break;
+            }
+            candidateVertices.pop();
+        }
+
         if (candidateVertices.empty()) {  // (3)
             finished = true;
         } else {
-            unsigned int candidateCount = candidateVertices.size();
-            unsigned long minDistance = LS_INFINITY;
-            OSPFLSA* closestVertex = candidateVertices[0];
-
-            for (i = 0; i < candidateCount; i++) {
-                OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (candidateVertices[i]);
-                unsigned long currentDistance = routingInfo->getDistance();
-
-                if (currentDistance < minDistance) {
-                    closestVertex = candidateVertices[i];
-                    minDistance = currentDistance;
-                } else {
-                    if (currentDistance == minDistance) {
-                        if ((closestVertex->getHeader().getLsType() == ROUTERLSA_TYPE) &&
-                            (candidateVertices[i]->getHeader().getLsType() == NETWORKLSA_TYPE))
-                        {
-                            closestVertex = candidateVertices[i];
-                        }
-                    }
-                }
-            }
+            OSPFLSA* closestVertex = candidateVertices.top().vertex;
 
+            candidateVertices.pop();
+            candidateSequence.erase(closestVertex);
             treeVertices.push_back(closestVertex);
-
-            for (std::vector<OSPFLSA*>::iterator it = candidateVertices.begin(); it != candidateVertices.end(); it++) {
-                if ((*it) == closestVertex) {
-                    candidateVertices.erase(it);
-                    break;
-                }
-            }
+            treeVertexSet.insert(closestVertex);
 
             if (closestVertex->getHeader().getLsType() == ROUTERLSA_TYPE) {
                 OSPF::RouterLSA* routerLSA = check_and_cast<OSPF::RouterLSA*> (closestVertex);
@@ -1825,6 +1903,8 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
             }
         }
     }
+
+    collectShortestPathTreeInputs(spfInputs);
 }
 
 std::vector<OSPF::NextHop>* OSPF::Area::calculateNextHops(OSPFLSA* destination, OSPFLSA* parent) const
@@ -48,6 +48,7 @@ private:
     bool                                                    externalRoutingCapability;
     Metric                                                  stubDefaultCost;
     RouterLSA*                                              spfTreeRoot;
+    std::vector<uint64>                                     spfInputs;      ///< The inputs of the last shortest path calculation, see collectShortestPathTreeInputs().
 
     Router*                                                 parentRouter;
 public:
@@ -114,6 +115,12 @@ public:
                                           const std::map<LSAKeyType, bool, LSAKeyType_Less>& originatedLSAs,
                                           SummaryLSA*& lsaToReoriginate);
     void              calculateShortestPathTree(std::vector<RoutingTableEntry*>& newRoutingTable);
+    /**
+     * Returns true if the router LSAs, the network LSAs or the interfaces of the area
+     * changed since the last calculateShortestPathTree() call, i.e. if calculating
+     * the shortest path tree again may give a different result.
+     */
+    bool              hasShortestPathTreeInputsChanged() const;
     void              calculateInterAreaRoutes(std::vector<RoutingTableEntry*>& newRoutingTable);
     void              recheckSummaryLSAs(std::vector<RoutingTableEntry*>& newRoutingTable);
 
@@ -123,6 +130,7 @@ public:
 private:
     SummaryLSA*           originateSummaryLSA(const OSPF::SummaryLSA* summaryLSA);
     bool                  hasLink(OSPFLSA* fromLSA, OSPFLSA* toLSA) const;
+    void                  collectShortestPathTreeInputs(std::vector<uint64>& inputs) const;
     std::vector<NextHop>* calculateNextHops(OSPFLSA* destination, OSPFLSA* parent) const;
     std::vector<NextHop>* calculateNextHops(Link& destination, OSPFLSA* parent) const;
 
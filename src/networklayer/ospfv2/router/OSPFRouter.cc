@@ -16,6 +16,9 @@
 //
 
 
+#include <algorithm>
+#include <time.h>
+
 #include "OSPFRouter.h"
 
 #include "RoutingTableAccess.h"
@@ -23,7 +26,17 @@
 
 OSPF::Router::Router(OSPF::RouterID id, cSimpleModule* containingModule) :
     routerID(id),
-    rfc1583Compatibility(false)
+    rfc1583Compatibility(false),
+    incrementalSPF(true),
+    spfInitialDelay(0),
+    spfHoldTime(0),
+    spfMaxWaitTime(0),
+    currentSPFHoldTime(0),
+    lastRebuildTime(-1),
+    rebuildCount(0),
+    spfCalculationCount(0),
+    skippedSPFCalculationCount(0),
+    spfCalculationTime(0)
 {
     messageHandler = new OSPF::MessageHandler(this, containingModule);
     ageTimer = new cMessage();
@@ -31,6 +44,10 @@ OSPF::Router::Router(OSPF::RouterID id, cSimpleModule* containingModule) :
     ageTimer->setContextPointer(this);
     ageTimer->setName("OSPF::Router::DatabaseAgeTimer");
     messageHandler->startTimer(ageTimer, 1.0);
+    spfTimer = new cMessage();
+    spfTimer->setKind(SPF_CALCULATION_TIMER);
+    spfTimer->setContextPointer(this);
+    spfTimer->setName("OSPF::Router::SPFCalculationTimer");
 }
 
 
@@ -48,8 +65,11 @@ OSPF::Router::~Router()
     for (long k = 0; k < routeCount; k++) {
         delete routingTable[k];
     }
+    clearIntraAreaRoutes();
     messageHandler->clearTimer(ageTimer);
     delete ageTimer;
+    messageHandler->clearTimer(spfTimer);
+    delete spfTimer;
     delete messageHandler;
 }
 
@@ -703,17 +723,103 @@ OSPF::RoutingTableEntry* OSPF::Router::lookup(IPv4Address destination, std::vect
 }
 
 
+void OSPF::Router::setSPFThrottling(simtime_t initialDelay, simtime_t holdTime, simtime_t maxWaitTime)
+{
+    if (initialDelay < 0 || holdTime < 0 || maxWaitTime < 0)
+        throw cRuntimeError("SPF throttling delays must not be negative");
+    spfInitialDelay = initialDelay;
+    spfHoldTime = holdTime;
+    spfMaxWaitTime = std::max(holdTime, maxWaitTime);
+    currentSPFHoldTime = holdTime;
+}
+
 void OSPF::Router::rebuildRoutingTable()
+{
+    if (spfTimer->isScheduled()) {
+        EV << "Routing table rebuild is already scheduled.\n";
+        return;
+    }
+
+    simtime_t now = simTime();
+    simtime_t delay = spfInitialDelay;
+    if (lastRebuildTime < 0 || now - lastRebuildTime > spfMaxWaitTime) {
+        // quiet period, start over with the initial hold time
+        currentSPFHoldTime = spfHoldTime;
+    } else {
+        if (lastRebuildTime + currentSPFHoldTime - now > delay) {
+            delay = lastRebuildTime + currentSPFHoldTime - now;
+        }
+        currentSPFHoldTime = std::min(2 * currentSPFHoldTime, spfMaxWaitTime);
+    }
+
+    if (delay == 0) {
+        rebuildRoutingTableNow();
+    } else {
+        EV << "Scheduling routing table rebuild in " << delay << "s.\n";
+        messageHandler->startTimer(spfTimer, delay);
+    }
+}
+
+void OSPF::Router::clearIntraAreaRoutes()
+{
+    for (unsigned long i = 0; i < intraAreaRoutes.size(); i++) {
+        for (unsigned long j = 0; j < intraAreaRoutes[i].size(); j++) {
+            delete intraAreaRoutes[i][j];
+        }
+    }
+    intraAreaRoutes.clear();
+}
+
+void OSPF::Router::rebuildRoutingTableNow()
 {
     unsigned long areaCount = areas.size();
     bool hasTransitAreas = false;
     std::vector<OSPF::RoutingTableEntry*> newTable;
-    unsigned long i;
+    unsigned long i, j;
+    long startTime = clock();
 
     EV << "Rebuilding routing table:\n";
 
-    for (i = 0; i < areaCount; i++) {
+    messageHandler->clearTimer(spfTimer);
+    lastRebuildTime = simTime();
+    rebuildCount++;
+
+    // the shortest path calculation of an area may modify the routes of the areas before it,
+    // so the calculation is repeated starting from the first area whose inputs changed
+    unsigned long firstChangedArea = 0;
+    if (incrementalSPF && intraAreaRoutes.size() == areaCount) {
+        while (firstChangedArea < areaCount && !areas[firstChangedArea]->hasShortestPathTreeInputsChanged()) {
+            firstChangedArea++;
+        }
+        skippedSPFCalculationCount += firstChangedArea;
+    } else {
+        clearIntraAreaRoutes();
+        intraAreaRoutes.resize(areaCount);
+    }
+    if (firstChangedArea > 0) {
+        const std::vector<OSPF::RoutingTableEntry*>& routes = intraAreaRoutes[firstChangedArea - 1];
+        for (j = 0; j < routes.size(); j++) {
+            newTable.push_back(new OSPF::RoutingTableEntry(*routes[j]));
+        }
+    }
+    for (i = firstChangedArea; i < areaCount; i++) {
         areas[i]->calculateShortestPathTree(newTable);
+        spfCalculationCount++;
+        if (incrementalSPF) {
+            std::vector<OSPF::RoutingTableEntry*>& routes = intraAreaRoutes[i];
+            for (j = 0; j < routes.size(); j++) {
+                delete routes[j];
+            }
+            routes.clear();
+            for (j = 0; j < newTable.size(); j++) {
+                routes.push_back(new OSPF::RoutingTableEntry(*newTable[j]));
+            }
+        }
+    }
+    if (!incrementalSPF) {
+        clearIntraAreaRoutes();
+    }
+    for (i = 0; i < areaCount; i++) {
         if (areas[i]->getTransitCapability()) {
             hasTransitAreas = true;
         }
@@ -778,6 +884,8 @@ void OSPF::Router::rebuildRoutingTable()
         delete (oldTable[i]);
     }
 
+    spfCalculationTime += (double)(clock() - startTime) / CLOCKS_PER_SEC;
+
     EV << "Routing table was rebuilt.\n"
        << "Results:\n";
 
@@ -50,6 +50,18 @@ private:
     std::vector<RoutingTableEntry*>                                    routingTable;            ///< The OSPF routing table - contains more information than the one in the IP layer.
     MessageHandler*                                                    messageHandler;          ///< The message dispatcher class.
     bool                                                               rfc1583Compatibility;    ///< Decides whether to handle the preferred routing table entry to an AS boundary router as defined in RFC1583 or not.
+    bool                                                               incrementalSPF;          ///< Decides whether to skip the shortest path calculation of areas whose link state database did not change.
+    std::vector<std::vector<RoutingTableEntry*> >                      intraAreaRoutes;         ///< A copy of the routing table under construction after the shortest path calculation of each area.
+    cMessage*                                                          spfTimer;                ///< Delays routing table rebuilds when SPF throttling is enabled.
+    simtime_t                                                          spfInitialDelay;         ///< The delay of the first routing table rebuild after a quiet period.
+    simtime_t                                                          spfHoldTime;             ///< The initial minimum time between routing table rebuilds.
+    simtime_t                                                          spfMaxWaitTime;          ///< The upper limit of the hold time; also the length of the quiet period that resets it.
+    simtime_t                                                          currentSPFHoldTime;      ///< The current minimum time between routing table rebuilds, doubled after each throttled rebuild.
+    simtime_t                                                          lastRebuildTime;         ///< The time of the last routing table rebuild, negative if there was none.
+    unsigned long                                                      rebuildCount;            ///< The number of routing table rebuilds.
+    unsigned long                                                      spfCalculationCount;     ///< The number of shortest path tree calculations in all areas.
+    unsigned long                                                      skippedSPFCalculationCount; ///< The number of shortest path tree calculations skipped by incremental SPF.
+    double                                                             spfCalculationTime;      ///< The CPU time spent rebuilding the routing table, in seconds.
 
 public:
     /**
@@ -82,6 +94,22 @@ public:
     const RoutingTableEntry* getRoutingTableEntry(unsigned long i) const  { return routingTable[i]; }
     void                     addRoutingTableEntry(RoutingTableEntry* entry) { routingTable.push_back(entry); }
 
+    void                     setIncrementalSPF(bool incremental)  { incrementalSPF = incremental; }
+    bool                     getIncrementalSPF() const  { return incrementalSPF; }
+    unsigned long            getRebuildCount() const  { return rebuildCount; }
+    unsigned long            getSPFCalculationCount() const  { return spfCalculationCount; }
+    unsigned long            getSkippedSPFCalculationCount() const  { return skippedSPFCalculationCount; }
+    double                   getSPFCalculationTime() const  { return spfCalculationTime; }
+
+    /**
+     * Configures the throttling of routing table rebuilds. After a quiet period the routing
+     * table is rebuilt initialDelay after the first change; subsequent rebuilds are at least
+     * the hold time apart, which starts from holdTime and doubles with each rebuild up to
+     * maxWaitTime. The hold time is reset after maxWaitTime without rebuilds.
+     * Zero delays mean rebuilding the routing table immediately on every change.
+     */
+    void                     setSPFThrottling(simtime_t initialDelay, simtime_t holdTime, simtime_t maxWaitTime);
+
     /**
      * Adds OMNeT++ watches for the routerID, the list of Areas and the list of AS External LSAs.
      */
@@ -203,11 +231,21 @@ public:
     RoutingTableEntry*   lookup(IPv4Address destination, std::vector<RoutingTableEntry*>* table = NULL) const;
 
     /**
-     * Rebuilds the routing table from scratch(based on the LSA database).
-     * @sa RFC2328 Section 16.
+     * Requests a routing table rebuild. Depending on the SPF throttling settings,
+     * the routing table is rebuilt immediately or when the SPF timer expires;
+     * requests arriving while a rebuild is pending are merged into it.
+     * @sa setSPFThrottling
      */
     void                 rebuildRoutingTable();
 
+    /**
+     * Rebuilds the routing table from scratch(based on the LSA database). With
+     * incremental SPF, the shortest path tree is only recalculated in the areas
+     * starting from the first one whose router or network LSAs changed.
+     * @sa RFC2328 Section 16.
+     */
+    void                 rebuildRoutingTableNow();
+
     /**
      * Scans through the router's areas' preconfigured address ranges and returns
      * the one containing the input addressRange.
@@ -264,6 +302,11 @@ public:
     RoutingTableEntry*   getPreferredEntry(const OSPFLSA& lsa, bool skipSelfOriginated, std::vector<RoutingTableEntry*>* fromRoutingTable = NULL);
 
 private:
+    /**
+     * Deletes the copies of the routing table kept for incremental SPF.
+     */
+    void                 clearIntraAreaRoutes();
+
     /**
      * Installs a new AS External LSA into the Router's database.
      * It tries to install keep one of multiple functionally equivalent AS External LSAs in the database.
@@ -150,6 +150,7 @@ void LinkStateRouting::processLINK_STATE_MESSAGE(LinkStateMsg* msg, IPv4Address
             {
                 // and we have no info on this link so far, store it as it is
                 tedmod->ted.push_back(link);
+                tedmod->invalidateShortestPaths(tedmod->ted.size() - 1);
                 change = true;
             }
             else
@@ -167,6 +168,7 @@ void LinkStateRouting::processLINK_STATE_MESSAGE(LinkStateMsg* msg, IPv4Address
                     match->UnResvBandwidth[i] = link.UnResvBandwidth[i];
                 match->MaxBandwidth = link.MaxBandwidth;
                 match->metric = link.metric;
+                tedmod->invalidateShortestPaths(match - &tedmod->ted[0]);
             }
 
             forward.push_back(link);
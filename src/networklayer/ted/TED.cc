@@ -13,6 +13,8 @@
 //
 
 #include <algorithm>
+#include <functional>
+#include <limits>
 
 #include "INETDefs.h"
 
@@ -35,6 +37,7 @@ TED::TED()
 {
     rt = NULL;
     ift = NULL;
+    numIndexedLinks = 0;
 }
 
 TED::~TED()
@@ -58,6 +61,7 @@ void TED::initialize(int stage)
         ift = InterfaceTableAccess().get();
         routerId = rt->getRouterId();
         nb = NotificationBoardAccess().get();
+        nb->subscribe(this, NF_TED_CHANGED);
         ASSERT(!routerId.isUnspecified());
 
         bool isOperational;
@@ -76,6 +80,7 @@ void TED::initializeTED()
     // We need to create one TED entry (TELinkStateInfo) for each link,
     // i.e. for each physical interface.
     //
+    invalidateShortestPaths();
     for (int i = 0; i < ift->getNumInterfaces(); i++)
     {
         InterfaceEntry *ie = ift->getInterface(i);
@@ -167,6 +172,17 @@ void TED::handleMessage(cMessage * msg)
     ASSERT(false);
 }
 
+void TED::receiveChangeNotification(int category, const cObject *details)
+{
+    Enter_Method_Silent();
+
+    ASSERT(category == NF_TED_CHANGED);
+
+    const TEDChangeInfo *d = check_and_cast<const TEDChangeInfo *>(details);
+    for (unsigned int i = 0; i < d->getTedLinkIndicesArraySize(); i++)
+        invalidateShortestPaths(d->getTedLinkIndices(i));
+}
+
 std::ostream & operator<<(std::ostream & os, const TELinkStateInfo& info)
 {
     os << "advrouter:" << info.advrouter;
@@ -182,34 +198,76 @@ std::ostream & operator<<(std::ostream & os, const TELinkStateInfo& info)
     return os;
 }
 
-// FIXME should this be called findOrCreateVertex() or something like that?
-int TED::assignIndex(std::vector<vertex_t>& vertices, IPv4Address nodeAddr)
+int TED::findOrCreateVertex(IPv4Address nodeAddr)
 {
-    // find node in vertices[] whose IPv4 address is nodeAddr
-    for (unsigned int i = 0; i < vertices.size(); i++)
-        if (vertices[i].node == nodeAddr)
-            return i;
+    std::map<IPv4Address, int>::iterator it = vertexIds.find(nodeAddr);
+    if (it != vertexIds.end())
+        return it->second;
+
+    int id = vertexAddrs.size();
+    vertexIds[nodeAddr] = id;
+    vertexAddrs.push_back(nodeAddr);
+    outLinks.push_back(std::vector<int>());
+    return id;
+}
+
+void TED::updateGraph()
+{
+    // entries are only ever appended to ted, or it is cleared
+    if (numIndexedLinks > ted.size())
+        invalidateShortestPaths();
+
+    for (; numIndexedLinks < ted.size(); numIndexedLinks++)
+    {
+        int src = findOrCreateVertex(ted[numIndexedLinks].advrouter);
+        int dest = findOrCreateVertex(ted[numIndexedLinks].linkid);
+        ASSERT(src != dest);
+        outLinks[src].push_back(numIndexedLinks);
+        linkDests.push_back(dest);
+    }
+}
 
-    // if not found, create
-    vertex_t newVertex;
-    newVertex.node = nodeAddr;
-    newVertex.dist = LS_INFINITY;
-    newVertex.parent = -1;
+bool TED::isUsableLink(unsigned int linkIndex, double req_bandwidth, int priority)
+{
+    const TELinkStateInfo& link = ted[linkIndex];
+    return link.state && link.UnResvBandwidth[priority] >= req_bandwidth;
+}
 
-    vertices.push_back(newVertex);
-    return vertices.size() - 1;
+void TED::invalidateShortestPaths(unsigned int linkIndex)
+{
+    // keep the trees for which the link did not change as far as they are concerned
+    for (ShortestPathCache::iterator it = shortestPathCache.begin(); it != shortestPathCache.end(); )
+    {
+        ShortestPathCache::iterator cur = it++;
+        const std::vector<double>& linkMetrics = cur->second.linkMetrics;
+        double oldMetric = linkIndex < linkMetrics.size() ? linkMetrics[linkIndex] : -1;
+        double newMetric = -1;
+        if (linkIndex < ted.size() && isUsableLink(linkIndex, cur->first.first, cur->first.second))
+            newMetric = ted[linkIndex].metric;
+        if (oldMetric != newMetric)
+            shortestPathCache.erase(cur);
+    }
+}
+
+void TED::invalidateShortestPaths()
+{
+    shortestPathCache.clear();
+    vertexIds.clear();
+    vertexAddrs.clear();
+    outLinks.clear();
+    linkDests.clear();
+    numIndexedLinks = 0;
 }
 
 IPAddressVector TED::calculateShortestPath(IPAddressVector dest,
-            const TELinkStateInfoVector& topology, double req_bandwidth, int priority)
+            double req_bandwidth, int priority)
 {
-    // FIXME comment: what do we do here?
-    std::vector<vertex_t> V = calculateShortestPaths(topology, req_bandwidth, priority);
+    const std::vector<vertex_t>& V = calculateShortestPaths(req_bandwidth, priority);
 
     double minDist = LS_INFINITY;
     int minIndex = -1;
 
-    // FIXME comment: what do we do in this block?
+    // find the closest reachable destination
     for (unsigned int i = 0; i < V.size(); i++)
     {
         if (V[i].dist >= minDist)
@@ -227,12 +285,14 @@ IPAddressVector TED::calculateShortestPath(IPAddressVector dest,
     if (minIndex < 0)
         return result;
 
+    // follow the parents back to the root
     result.push_back(V[minIndex].node);
     while (V[minIndex].parent != -1)
     {
         minIndex = V[minIndex].parent;
-        result.insert(result.begin(), V[minIndex].node);
+        result.push_back(V[minIndex].node);
     }
+    std::reverse(result.begin(), result.end());
 
     return result;
 }
@@ -241,7 +301,9 @@ void TED::rebuildRoutingTable()
 {
     EV << "rebuilding routing table at " << routerId << endl;
 
-    std::vector<vertex_t> V = calculateShortestPaths(ted, 0.0, 7);
+    // callers may have changed the TED without announcing it yet
+    shortestPathCache.clear();
+    const std::vector<vertex_t>& V = calculateShortestPaths(0.0, 7);
 
     // remove all routing entries, except multicast ones (we don't care about them)
     int n = rt->getNumRoutes();
@@ -360,62 +422,120 @@ bool TED::isLocalPeer(IPv4Address inetAddr)
     return it != ted.end();
 }
 
-std::vector<TED::vertex_t> TED::calculateShortestPaths(const TELinkStateInfoVector& topology,
-            double req_bandwidth, int priority)
+const std::vector<TED::vertex_t>& TED::calculateShortestPaths(double req_bandwidth, int priority)
 {
-    std::vector<vertex_t> vertices;
-    std::vector<edge_t> edges;
-
-    // select edges that have enough bandwidth left, and store them into edges[].
-    // meanwhile, collect vertices in vectices[].
-    for (unsigned int i = 0; i < topology.size(); i++)
+    std::pair<double, int> key(req_bandwidth, priority);
+    ShortestPathCache::iterator it = shortestPathCache.find(key);
+    if (it != shortestPathCache.end())
+        return it->second.vertices;
+
+    updateGraph();
+    int source = findOrCreateVertex(routerId);
+    int numVertices = vertexAddrs.size();
+    int numLinks = ted.size();
+
+    // Dijkstra with a binary heap over the usable links
+    dist.assign(numVertices, LS_INFINITY);
+    dist[source] = 0.0;
+    distHeap.clear();
+    distHeap.push_back(std::make_pair(0.0, source));
+    while (!distHeap.empty())
     {
-        if (!topology[i].state)
+        std::pop_heap(distHeap.begin(), distHeap.end(), std::greater<std::pair<double, int> >());
+        double d = distHeap.back().first;
+        int u = distHeap.back().second;
+        distHeap.pop_back();
+        if (d > dist[u])
             continue;
+        for (unsigned int i = 0; i < outLinks[u].size(); i++)
+        {
+            int link = outLinks[u][i];
+            if (!isUsableLink(link, req_bandwidth, priority))
+                continue;
+            int v = linkDests[link];
+            if (dist[u] + ted[link].metric < dist[v])
+            {
+                dist[v] = dist[u] + ted[link].metric;
+                distHeap.push_back(std::make_pair(dist[v], v));
+                std::push_heap(distHeap.begin(), distHeap.end(), std::greater<std::pair<double, int> >());
+            }
+        }
+    }
 
-        if (topology[i].UnResvBandwidth[priority] < req_bandwidth)
+    // Among equal cost paths, choose the parents the previous Bellman-Ford
+    // style implementation chose, so that routes do not change: it relaxed
+    // the links in TED order in repeated passes, and kept the first link
+    // that gave a vertex its final distance. Vertices are reached at
+    // (pass, link index) times, encoded as pass * (numLinks + 1) + index + 1;
+    // a link leaving a vertex reached at (p, i) is next relaxed at (p, j)
+    // if its index j > i, or at (p + 1, j) otherwise.
+    const int64 passLength = numLinks + 1;
+    reachTime.assign(numVertices, std::numeric_limits<int64>::max());
+    parentVertex.assign(numVertices, -1);
+    reachTime[source] = passLength;     // pass 1, before the first link
+    timeHeap.clear();
+    timeHeap.push_back(std::make_pair(reachTime[source], source));
+    while (!timeHeap.empty())
+    {
+        std::pop_heap(timeHeap.begin(), timeHeap.end(), std::greater<std::pair<int64, int> >());
+        int64 t = timeHeap.back().first;
+        int u = timeHeap.back().second;
+        timeHeap.pop_back();
+        if (t > reachTime[u])
             continue;
-
-        edge_t edge;
-        edge.src = assignIndex(vertices, topology[i].advrouter);
-        edge.dest = assignIndex(vertices, topology[i].linkid);
-        edge.metric = topology[i].metric;
-        edges.push_back(edge);
+        int64 pass = t / passLength;
+        int64 index = t % passLength - 1;
+        for (unsigned int i = 0; i < outLinks[u].size(); i++)
+        {
+            int link = outLinks[u][i];
+            int v = linkDests[link];
+            if (v == source || !isUsableLink(link, req_bandwidth, priority) || dist[u] + ted[link].metric != dist[v])
+                continue;
+            int64 relaxTime = (link > index ? pass : pass + 1) * passLength + link + 1;
+            if (relaxTime < reachTime[v])
+            {
+                reachTime[v] = relaxTime;
+                parentVertex[v] = u;
+                timeHeap.push_back(std::make_pair(relaxTime, v));
+                std::push_heap(timeHeap.begin(), timeHeap.end(), std::greater<std::pair<int64, int> >());
+            }
+        }
     }
 
-    IPv4Address srcAddr = routerId;
-
-    int srcIndex = assignIndex(vertices, srcAddr);
-    vertices[srcIndex].dist = 0.0;
-
-    // FIXME comment: Dijkstra? just guessing...
-    for (unsigned int i = 1; i < vertices.size(); i++)
+    // the result lists the vertices of the usable links in order of appearance,
+    // followed by this router if it has no usable links
+    ShortestPaths& paths = shortestPathCache[key];
+    std::vector<vertex_t>& vertices = paths.vertices;
+    paths.linkMetrics.assign(numLinks, -1);
+    resultIndex.assign(numVertices, -1);
+    for (int link = 0; link <= numLinks; link++)
     {
-        bool mod = false;
-
-        for (unsigned int j = 0; j < edges.size(); j++)
+        int ends[2];
+        int numEnds = 0;
+        if (link == numLinks)
+            ends[numEnds++] = source;
+        else if (isUsableLink(link, req_bandwidth, priority))
         {
-            int src = edges[j].src;
-            int dest = edges[j].dest;
-
-            ASSERT(src >= 0);
-            ASSERT(dest >= 0);
-            ASSERT(src < (int)vertices.size());
-            ASSERT(dest < (int)vertices.size());
-            ASSERT(src != dest);
-
-            if (vertices[src].dist + edges[j].metric >= vertices[dest].dist)
+            paths.linkMetrics[link] = ted[link].metric;
+            ends[numEnds++] = vertexIds[ted[link].advrouter];
+            ends[numEnds++] = linkDests[link];
+        }
+        for (int i = 0; i < numEnds; i++)
+        {
+            int id = ends[i];
+            if (resultIndex[id] != -1)
                 continue;
-
-            vertices[dest].dist = vertices[src].dist + edges[j].metric;
-            vertices[dest].parent = src;
-
-            mod = true;
+            resultIndex[id] = vertices.size();
+            vertex_t vertex;
+            vertex.node = vertexAddrs[id];
+            vertex.dist = dist[id];
+            vertex.parent = parentVertex[id];  // graph id, mapped below
+            vertices.push_back(vertex);
         }
-
-        if (!mod)
-            break;
     }
+    for (unsigned int i = 0; i < vertices.size(); i++)
+        if (vertices[i].parent != -1)
+            vertices[i].parent = resultIndex[vertices[i].parent];
 
     return vertices;
 }
@@ -526,12 +646,14 @@ bool TED::handleOperationStage(LifecycleOperation *operation, int stage, IDoneCa
         if (stage == NodeShutdownOperation::STAGE_APPLICATION_LAYER) {
             ted.clear();
             interfaceAddrs.clear();
+            invalidateShortestPaths();
         }
     }
     else if (dynamic_cast<NodeCrashOperation *>(operation)) {
         if (stage == NodeCrashOperation::STAGE_CRASH) {
             ted.clear();
             interfaceAddrs.clear();
+            invalidateShortestPaths();
         }
     }
     return true;
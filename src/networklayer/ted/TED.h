@@ -15,11 +15,15 @@
 #ifndef __INET_TED_H
 #define __INET_TED_H
 
+#include <map>
+#include <vector>
+
 #include "INETDefs.h"
 
 #include "TED_m.h"
 #include "IntServ.h"
 #include "ILifecycle.h"
+#include "INotifiable.h"
 
 class IRoutingTable;
 class IInterfaceTable;
@@ -33,7 +37,7 @@ class NotificationBoard;
  *
  * See NED file for more info.
  */
-class TED : public cSimpleModule, public ILifecycle
+class TED : public cSimpleModule, public ILifecycle, public INotifiable
 {
   public:
     /**
@@ -74,8 +78,14 @@ class TED : public cSimpleModule, public ILifecycle
 
     virtual void initializeTED();
 
+    /**
+     * Returns the shortest path (list of router IDs, starting with this router)
+     * to the closest of the given destinations, using only links that are up
+     * and have at least req_bandwidth unreserved at the given priority.
+     * Returns an empty vector if none of them is reachable.
+     */
     virtual IPAddressVector calculateShortestPath(IPAddressVector dest,
-        const TELinkStateInfoVector& topology, double req_bandwidth, int priority);
+        double req_bandwidth, int priority);
 
   public:
     /** @name Public interface to the Traffic Engineering Database */
@@ -91,10 +101,25 @@ class TED : public cSimpleModule, public ILifecycle
     virtual IPAddressVector getLocalAddress();
 
     virtual void rebuildRoutingTable();
+
+    /**
+     * Drops the cached shortest paths that may be affected by a change of
+     * the given entry of the ted vector (or by its addition). Changes
+     * announced via NF_TED_CHANGED are handled automatically.
+     */
+    virtual void invalidateShortestPaths(unsigned int linkIndex);
+
+    /**
+     * Drops all cached shortest paths and the graph built from the ted
+     * vector; must be called after entries have been removed from it.
+     */
+    virtual void invalidateShortestPaths();
     //@}
 
     virtual bool handleOperationStage(LifecycleOperation *operation, int stage, IDoneCallback *doneCallback);
 
+    virtual void receiveChangeNotification(int category, const cObject *details);
+
   protected:
     IRoutingTable *rt;
     IInterfaceTable *ift;
@@ -106,10 +131,39 @@ class TED : public cSimpleModule, public ILifecycle
   protected:
     int maxMessageId;
 
-    virtual int assignIndex(std::vector<vertex_t>& vertices, IPv4Address nodeAddr);
-
-    std::vector<vertex_t> calculateShortestPaths(const TELinkStateInfoVector& topology,
-        double req_bandwidth, int priority);
+    /**
+     * Shortest path tree for one (bandwidth, priority) pair, and the metric
+     * of each link as seen by the calculation (-1 for links not usable).
+     */
+    struct ShortestPaths
+    {
+        std::vector<vertex_t> vertices;
+        std::vector<double> linkMetrics;
+    };
+    typedef std::map<std::pair<double, int>, ShortestPaths> ShortestPathCache;
+    ShortestPathCache shortestPathCache;
+
+    // Graph of the links in ted, extended as links are appended to it.
+    // Vertices are numbered in the order they were seen (graph ids).
+    std::map<IPv4Address, int> vertexIds;
+    std::vector<IPv4Address> vertexAddrs;       // router ID of each vertex
+    std::vector<std::vector<int> > outLinks;    // indices into ted of the links advertised by each vertex
+    std::vector<int> linkDests;                 // graph id of the remote end of each indexed link
+    unsigned int numIndexedLinks;               // ted[0..numIndexedLinks) are in the graph
+
+    // scratch space of calculateShortestPaths(), kept to avoid reallocation
+    std::vector<double> dist;
+    std::vector<int64> reachTime;
+    std::vector<int> parentVertex;
+    std::vector<int> resultIndex;
+    std::vector<std::pair<double, int> > distHeap;
+    std::vector<std::pair<int64, int> > timeHeap;
+
+    virtual int findOrCreateVertex(IPv4Address nodeAddr);
+    virtual void updateGraph();
+    virtual bool isUsableLink(unsigned int linkIndex, double req_bandwidth, int priority);
+
+    const std::vector<vertex_t>& calculateShortestPaths(double req_bandwidth, int priority);
 
   public: //FIXME
     virtual bool checkLinkValidity(TELinkStateInfo link, TELinkStateInfo *&match);
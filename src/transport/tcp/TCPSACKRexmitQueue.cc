@@ -23,19 +23,24 @@
 TCPSACKRexmitQueue::TCPSACKRexmitQueue()
 {
     conn = NULL;
+    root = NULL;
     begin = end = 0;
+    beginKey = 0;
+    rngState = 2463534242u;
 }
 
 TCPSACKRexmitQueue::~TCPSACKRexmitQueue()
 {
-    while (!rexmitQueue.empty())
-        rexmitQueue.pop_front();
+    deleteSubtree(root);
 }
 
 void TCPSACKRexmitQueue::init(uint32 seqNum)
 {
+    deleteSubtree(root);
+    root = NULL;
     begin = seqNum;
     end = seqNum;
+    beginKey = 0;
 }
 
 std::string TCPSACKRexmitQueue::str() const
@@ -50,36 +55,302 @@ void TCPSACKRexmitQueue::info() const
 {
     tcpEV << str() << endl;
 
-    uint j = 1;
+    uint32 j = 1;
+    printRegions(root, j);
+}
+
+void TCPSACKRexmitQueue::printRegions(const Node *subtree, uint32& j) const
+{
+    if (!subtree)
+        return;
+
+    printRegions(subtree->left, j);
+    const Region& r = subtree->region;
+    tcpEV << j << ". region: [" << r.beginSeqNum << ".." << r.endSeqNum
+          << ") \t sacked=" << r.sacked << "\t rexmitted=" << r.rexmitted
+          << endl;
+    j++;
+    printRegions(subtree->right, j);
+}
+
+//
+// Treap maintenance
+//
+
+uint32 TCPSACKRexmitQueue::nextPriority()
+{
+    // xorshift32
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
 
-    for (RexmitQueue::const_iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
+TCPSACKRexmitQueue::Summary TCPSACKRexmitQueue::combine(const Summary& left, const Region& region, const Summary& right)
+{
+    uint32 bytes = region.endSeqNum - region.beginSeqNum;
+    Summary s;
+    s.numRegions = left.numRegions + 1 + right.numRegions;
+    s.sackedBytes = left.sackedBytes + (region.sacked ? bytes : 0) + right.sackedBytes;
+    s.rexmittedBytes = left.rexmittedBytes + (region.rexmitted ? bytes : 0) + right.rexmittedBytes;
+    s.numSackedRuns = left.numSackedRuns + right.numSackedRuns;
+    if (region.sacked)
     {
-        tcpEV << j << ". region: [" << i->beginSeqNum << ".." << i->endSeqNum
-              << ") \t sacked=" << i->sacked << "\t rexmitted=" << i->rexmitted
-              << endl;
-        j++;
+        // a sacked region joins the runs ending/starting next to it
+        s.numSackedRuns += 1;
+        if (left.lastSacked)
+            s.numSackedRuns--;
+        if (right.firstSacked)
+            s.numSackedRuns--;
     }
+    s.firstSacked = left.numRegions > 0 ? left.firstSacked : region.sacked;
+    s.lastSacked = right.numRegions > 0 ? right.lastSacked : region.sacked;
+    return s;
 }
 
-void TCPSACKRexmitQueue::discardUpTo(uint32 seqNum)
+void TCPSACKRexmitQueue::updateSummary(Node *node)
 {
-    ASSERT(seqLE(begin, seqNum) && seqLE(seqNum, end));
+    static const Summary empty;
+    node->summary = combine(node->left ? node->left->summary : empty, node->region, node->right ? node->right->summary : empty);
+}
+
+void TCPSACKRexmitQueue::deleteSubtree(Node *node)
+{
+    if (node)
+    {
+        deleteSubtree(node->left);
+        deleteSubtree(node->right);
+        delete node;
+    }
+}
+
+void TCPSACKRexmitQueue::rotateRight(Node *&node)
+{
+    Node *left = node->left;
+    node->left = left->right;
+    left->right = node;
+    updateSummary(node);
+    updateSummary(left);
+    node = left;
+}
+
+void TCPSACKRexmitQueue::rotateLeft(Node *&node)
+{
+    Node *right = node->right;
+    node->right = right->left;
+    right->left = node;
+    updateSummary(node);
+    updateSummary(right);
+    node = right;
+}
+
+void TCPSACKRexmitQueue::insertNode(Node *&subtree, Node *node)
+{
+    if (!subtree)
+    {
+        subtree = node;
+        updateSummary(node);
+    }
+    else if (node->key < subtree->key)
+    {
+        insertNode(subtree->left, node);
+        if (subtree->left->priority > subtree->priority)
+            rotateRight(subtree);
+        else
+            updateSummary(subtree);
+    }
+    else
+    {
+        ASSERT(node->key != subtree->key);
+        insertNode(subtree->right, node);
+        if (subtree->right->priority > subtree->priority)
+            rotateLeft(subtree);
+        else
+            updateSummary(subtree);
+    }
+}
+
+void TCPSACKRexmitQueue::eraseNode(Node *&subtree, uint64 key)
+{
+    ASSERT(subtree);
+
+    if (key < subtree->key)
+        eraseNode(subtree->left, key);
+    else if (key > subtree->key)
+        eraseNode(subtree->right, key);
+    else if (!subtree->left || !subtree->right)
+    {
+        Node *node = subtree;
+        subtree = node->left ? node->left : node->right;
+        delete node;
+        return;
+    }
+    else if (subtree->left->priority > subtree->right->priority)
+    {
+        // rotate the node down until it has at most one child
+        rotateRight(subtree);
+        eraseNode(subtree->right, key);
+    }
+    else
+    {
+        rotateLeft(subtree);
+        eraseNode(subtree->left, key);
+    }
+    updateSummary(subtree);
+}
+
+TCPSACKRexmitQueue::Node *TCPSACKRexmitQueue::insertRegion(uint32 beginSeqNum, uint32 endSeqNum, bool sacked, bool rexmitted)
+{
+    Node *node = new Node();
+    node->region.beginSeqNum = beginSeqNum;
+    node->region.endSeqNum = endSeqNum;
+    node->region.sacked = sacked;
+    node->region.rexmitted = rexmitted;
+    node->key = toKey(beginSeqNum);
+    node->priority = nextPriority();
+    node->left = node->right = NULL;
+    insertNode(root, node);
+    return node;
+}
+
+void TCPSACKRexmitQueue::refreshPath(uint64 key)
+{
+    refreshPath(root, key);
+}
+
+void TCPSACKRexmitQueue::refreshPath(Node *subtree, uint64 key)
+{
+    // recompute the summaries on the path from the root to the node with the given key
+    if (!subtree)
+        return;
+    if (key < subtree->key)
+        refreshPath(subtree->left, key);
+    else if (key > subtree->key)
+        refreshPath(subtree->right, key);
+    updateSummary(subtree);
+}
 
-    if (!rexmitQueue.empty())
+TCPSACKRexmitQueue::Node *TCPSACKRexmitQueue::findRegion(uint32 seqNum) const
+{
+    // the region with the largest begin that is not above seqNum
+    uint64 key = toKey(seqNum);
+    Node *found = NULL;
+    for (Node *node = root; node; )
     {
-        RexmitQueue::iterator i = rexmitQueue.begin();
+        if (node->key <= key)
+        {
+            found = node;
+            node = node->right;
+        }
+        else
+            node = node->left;
+    }
+    return found;
+}
+
+TCPSACKRexmitQueue::Node *TCPSACKRexmitQueue::findFirst() const
+{
+    Node *node = root;
+    while (node && node->left)
+        node = node->left;
+    return node;
+}
 
-        while ((i != rexmitQueue.end()) && seqLE(i->endSeqNum, seqNum)) // discard/delete regions from rexmit queue, which have been acked
-            i = rexmitQueue.erase(i);
+TCPSACKRexmitQueue::Node *TCPSACKRexmitQueue::findLast() const
+{
+    Node *node = root;
+    while (node && node->right)
+        node = node->right;
+    return node;
+}
 
-        if (i != rexmitQueue.end())
+TCPSACKRexmitQueue::Node *TCPSACKRexmitQueue::findNext(const Node *current) const
+{
+    Node *found = NULL;
+    for (Node *node = root; node; )
+    {
+        if (node->key > current->key)
         {
-            ASSERT(seqLE(i->beginSeqNum, seqNum) && seqLess(seqNum, i->endSeqNum));
-            i->beginSeqNum = seqNum;
+            found = node;
+            node = node->left;
         }
+        else
+            node = node->right;
+    }
+    return found;
+}
+
+TCPSACKRexmitQueue::Node *TCPSACKRexmitQueue::splitAt(Node *node, uint32 seqNum)
+{
+    Region& region = node->region;
+    ASSERT(seqLE(region.beginSeqNum, seqNum) && seqLess(seqNum, region.endSeqNum));
+
+    if (region.beginSeqNum == seqNum)
+        return node;
+
+    // chunk item
+    uint32 endSeqNum = region.endSeqNum;
+    region.endSeqNum = seqNum;
+    refreshPath(node->key);
+    return insertRegion(seqNum, endSeqNum, region.sacked, region.rexmitted);
+}
+
+TCPSACKRexmitQueue::Summary TCPSACKRexmitQueue::getSummaryFrom(uint64 key) const
+{
+    return getSummaryFrom(root, key);
+}
+
+TCPSACKRexmitQueue::Summary TCPSACKRexmitQueue::getSummaryFrom(const Node *subtree, uint64 key)
+{
+    // the nodes not below key are the ones on the search path, plus their right subtrees
+    static const Summary empty;
+    if (!subtree)
+        return empty;
+    if (subtree->key < key)
+        return getSummaryFrom(subtree->right, key);
+    return combine(getSummaryFrom(subtree->left, key), subtree->region, subtree->right ? subtree->right->summary : empty);
+}
+
+void TCPSACKRexmitQueue::resetBits(Node *subtree, bool sacked, bool rexmitted)
+{
+    if (!subtree)
+        return;
+
+    resetBits(subtree->left, sacked, rexmitted);
+    resetBits(subtree->right, sacked, rexmitted);
+    if (sacked)
+        subtree->region.sacked = false;
+    if (rexmitted)
+        subtree->region.rexmitted = false;
+    updateSummary(subtree);
+}
+
+//
+// Scoreboard operations
+//
+
+void TCPSACKRexmitQueue::discardUpTo(uint32 seqNum)
+{
+    ASSERT(seqLE(begin, seqNum) && seqLE(seqNum, end));
+
+    Node *first;
+
+    while ((first = findFirst()) != NULL && seqLE(first->region.endSeqNum, seqNum)) // discard/delete regions from rexmit queue, which have been acked
+        eraseNode(root, first->key);
+
+    uint64 newBeginKey = toKey(seqNum);
+
+    if (first)
+    {
+        ASSERT(seqLE(first->region.beginSeqNum, seqNum) && seqLess(seqNum, first->region.endSeqNum));
+        // the first region stays the first one, so its position in the tree does not change
+        first->region.beginSeqNum = seqNum;
+        first->key = newBeginKey;
+        refreshPath(first->key);
     }
 
     begin = seqNum;
+    beginKey = newBeginKey;
 
     // TESTING queue:
     ASSERT(checkQueue());
@@ -90,65 +361,51 @@ void TCPSACKRexmitQueue::enqueueSentData(uint32 fromSeqNum, uint32 toSeqNum)
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
     bool found = false;
-    Region region;
 
     tcpEV << "rexmitQ: " << str() << " enqueueSentData [" << fromSeqNum << ".." << toSeqNum << ")\n";
 
     ASSERT(seqLess(fromSeqNum, toSeqNum));
 
-    if (rexmitQueue.empty() || (end == fromSeqNum))
+    if (!root || (end == fromSeqNum))
     {
-        region.beginSeqNum = fromSeqNum;
-        region.endSeqNum = toSeqNum;
-        region.sacked = false;
-        region.rexmitted = false;
-        rexmitQueue.push_back(region);
+        insertRegion(fromSeqNum, toSeqNum, false, false);
         found = true;
         fromSeqNum = toSeqNum;
     }
     else
     {
-        RexmitQueue::iterator i = rexmitQueue.begin();
+        Node *i = findRegion(fromSeqNum);
 
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum))
-            i++;
+        ASSERT(i != NULL);
+        ASSERT(seqLE(i->region.beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->region.endSeqNum));
 
-        ASSERT(i != rexmitQueue.end());
-        ASSERT(seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
+        i = splitAt(i, fromSeqNum);
 
-        if (i->beginSeqNum != fromSeqNum)
+        while (i != NULL && seqLE(i->region.endSeqNum, toSeqNum))
         {
-            // chunk item
-            region = *i;
-            region.endSeqNum = fromSeqNum;
-            rexmitQueue.insert(i, region);
-            i->beginSeqNum = fromSeqNum;
-        }
-
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, toSeqNum))
-        {
-            i->rexmitted = true;
-            fromSeqNum = i->endSeqNum;
+            i->region.rexmitted = true;
+            refreshPath(i->key);
+            fromSeqNum = i->region.endSeqNum;
             found = true;
-            i++;
+            i = findNext(i);
         }
 
         if (fromSeqNum != toSeqNum)
         {
-            bool beforeEnd = (i != rexmitQueue.end());
+            ASSERT(i == NULL || seqLess(i->region.beginSeqNum, toSeqNum));
 
-            ASSERT(i == rexmitQueue.end() || seqLess(i->beginSeqNum, toSeqNum));
+            if (i != NULL)
+            {
+                // the front of region i is retransmitted
+                splitAt(i, toSeqNum);
+                i->region.rexmitted = true;
+                refreshPath(i->key);
+            }
+            else
+                insertRegion(fromSeqNum, toSeqNum, false, false);
 
-            region.beginSeqNum = fromSeqNum;
-            region.endSeqNum = toSeqNum;
-            region.sacked = beforeEnd ? i->sacked : false;
-            region.rexmitted = beforeEnd;
-            rexmitQueue.insert(i, region);
             found = true;
             fromSeqNum = toSeqNum;
-
-            if (beforeEnd)
-                i->beginSeqNum = toSeqNum;
         }
     }
 
@@ -162,8 +419,7 @@ void TCPSACKRexmitQueue::enqueueSentData(uint32 fromSeqNum, uint32 toSeqNum)
 
     ASSERT(found);
 
-    begin = rexmitQueue.front().beginSeqNum;
-    end = rexmitQueue.back().endSeqNum;
+    end = findLast()->region.endSeqNum;
 
     // TESTING queue:
     ASSERT(checkQueue());
@@ -174,14 +430,8 @@ void TCPSACKRexmitQueue::enqueueSentData(uint32 fromSeqNum, uint32 toSeqNum)
 bool TCPSACKRexmitQueue::checkQueue() const
 {
     uint32 b = begin;
-    bool f = true;
-
-    for (RexmitQueue::const_iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-    {
-        f = f && (b == i->beginSeqNum);
-        f = f && seqLess(i->beginSeqNum, i->endSeqNum);
-        b = i->endSeqNum;
-    }
+    uint64 prevPriority = (uint64)1 << 32;
+    bool f = checkRegions(root, b, prevPriority);
 
     f = f && (b == end);
 
@@ -194,6 +444,22 @@ bool TCPSACKRexmitQueue::checkQueue() const
     return f;
 }
 
+bool TCPSACKRexmitQueue::checkRegions(const Node *subtree, uint32& b, uint64& parentPriority) const
+{
+    if (!subtree)
+        return true;
+
+    bool f = subtree->priority <= parentPriority;  // heap property
+    uint64 priority = subtree->priority;
+    f = f && checkRegions(subtree->left, b, priority);
+    f = f && (b == subtree->region.beginSeqNum);
+    f = f && (subtree->key == toKey(subtree->region.beginSeqNum));
+    f = f && seqLess(subtree->region.beginSeqNum, subtree->region.endSeqNum);
+    b = subtree->region.endSeqNum;
+    f = f && checkRegions(subtree->right, b, priority);
+    return f;
+}
+
 void TCPSACKRexmitQueue::setSackedBit(uint32 fromSeqNum, uint32 toSeqNum)
 {
     if (seqLess(fromSeqNum, begin))
@@ -205,43 +471,30 @@ void TCPSACKRexmitQueue::setSackedBit(uint32 fromSeqNum, uint32 toSeqNum)
 
     bool found = false;
 
-    if (!rexmitQueue.empty())
+    if (root)
     {
-        RexmitQueue::iterator i = rexmitQueue.begin();
+        Node *i = findRegion(fromSeqNum);
 
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum))
-            i++;
+        ASSERT(i != NULL && seqLE(i->region.beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->region.endSeqNum));
 
-        ASSERT(i != rexmitQueue.end() && seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
+        i = splitAt(i, fromSeqNum);
 
-        if (i->beginSeqNum != fromSeqNum)
+        while (i != NULL && seqLE(i->region.endSeqNum, toSeqNum))
         {
-            Region region = *i;
-
-            region.endSeqNum = fromSeqNum;
-            rexmitQueue.insert(i, region);
-            i->beginSeqNum = fromSeqNum;
-        }
-
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, toSeqNum))
-        {
-            if (seqGE(i->beginSeqNum, fromSeqNum)) // Search region in queue!
+            found = true;
+            if (!i->region.sacked)
             {
-                found = true;
-                i->sacked = true; // set sacked bit
+                i->region.sacked = true; // set sacked bit
+                refreshPath(i->key);
             }
-
-            i++;
+            i = findNext(i);
         }
 
-        if (i != rexmitQueue.end() && seqLess(i->beginSeqNum, toSeqNum) && seqLess(toSeqNum, i->endSeqNum))
+        if (i != NULL && seqLess(i->region.beginSeqNum, toSeqNum) && seqLess(toSeqNum, i->region.endSeqNum))
         {
-            Region region = *i;
-
-            region.endSeqNum = toSeqNum;
-            region.sacked = true;
-            rexmitQueue.insert(i, region);
-            i->beginSeqNum = toSeqNum;
+            splitAt(i, toSeqNum);
+            i->region.sacked = true;
+            refreshPath(i->key);
         }
     }
 
@@ -255,61 +508,67 @@ bool TCPSACKRexmitQueue::getSackedBit(uint32 seqNum) const
 {
     ASSERT(seqLE(begin, seqNum) && seqLE(seqNum, end));
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
-
     if (end == seqNum)
         return false;
 
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, seqNum))
-        i++;
+    Node *i = findRegion(seqNum);
 
-    ASSERT((i != rexmitQueue.end()) && seqLE(i->beginSeqNum, seqNum) && seqLess(seqNum, i->endSeqNum));
+    ASSERT((i != NULL) && seqLE(i->region.beginSeqNum, seqNum) && seqLess(seqNum, i->region.endSeqNum));
 
-    return i->sacked;
+    return i->region.sacked;
 }
 
 uint32 TCPSACKRexmitQueue::getHighestSackedSeqNum() const
 {
-    for (RexmitQueue::const_reverse_iterator i = rexmitQueue.rbegin(); i != rexmitQueue.rend(); i++)
+    if (!root || root->summary.sackedBytes == 0)
+        return begin;
+
+    // descend towards the last sacked region
+    const Node *node = root;
+    while (true)
     {
-        if (i->sacked)
-            return i->endSeqNum;
+        if (node->right && node->right->summary.sackedBytes > 0)
+            node = node->right;
+        else if (node->region.sacked)
+            return node->region.endSeqNum;
+        else
+            node = node->left;
     }
-
-    return begin;
 }
 
 uint32 TCPSACKRexmitQueue::getHighestRexmittedSeqNum() const
 {
-    for (RexmitQueue::const_reverse_iterator i = rexmitQueue.rbegin(); i != rexmitQueue.rend(); i++)
+    if (!root || root->summary.rexmittedBytes == 0)
+        return begin;
+
+    // descend towards the last rexmitted region
+    const Node *node = root;
+    while (true)
     {
-        if (i->rexmitted)
-            return i->endSeqNum;
+        if (node->right && node->right->summary.rexmittedBytes > 0)
+            node = node->right;
+        else if (node->region.rexmitted)
+            return node->region.endSeqNum;
+        else
+            node = node->left;
     }
-
-    return begin;
 }
 
 uint32 TCPSACKRexmitQueue::checkRexmitQueueForSackedOrRexmittedSegments(uint32 fromSeqNum) const
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
-    if (rexmitQueue.empty() || (end == fromSeqNum))
+    if (!root || (end == fromSeqNum))
         return 0;
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
     uint32 bytes = 0;
 
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum))
-        i++;
-
-    while (i != rexmitQueue.end() && ((i->sacked || i->rexmitted)))
+    for (Node *i = findRegion(fromSeqNum); i != NULL && (i->region.sacked || i->region.rexmitted); i = findNext(i))
     {
-        ASSERT(seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
+        ASSERT(seqLE(i->region.beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->region.endSeqNum));
 
-        bytes += (i->endSeqNum - fromSeqNum);
-        fromSeqNum = i->endSeqNum;
-        i++;
+        bytes += (i->region.endSeqNum - fromSeqNum);
+        fromSeqNum = i->region.endSeqNum;
     }
 
     return bytes;
@@ -317,47 +576,28 @@ uint32 TCPSACKRexmitQueue::checkRexmitQueueForSackedOrRexmittedSegments(uint32 f
 
 void TCPSACKRexmitQueue::resetSackedBit()
 {
-    for (RexmitQueue::iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-        i->sacked = false; // reset sacked bit
+    resetBits(root, true, false); // reset sacked bit
 }
 
 void TCPSACKRexmitQueue::resetRexmittedBit()
 {
-    for (RexmitQueue::iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-        i->rexmitted = false; // reset rexmitted bit
-}
-
-uint32 TCPSACKRexmitQueue::getTotalAmountOfSackedBytes() const
-{
-    uint32 bytes = 0;
-
-    for (RexmitQueue::const_iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-    {
-        if (i->sacked)
-            bytes += (i->endSeqNum - i->beginSeqNum);
-    }
-
-    return bytes;
+    resetBits(root, false, true); // reset rexmitted bit
 }
 
 uint32 TCPSACKRexmitQueue::getAmountOfSackedBytes(uint32 fromSeqNum) const
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
-    uint32 bytes = 0;
-    RexmitQueue::const_reverse_iterator i = rexmitQueue.rbegin();
+    if (!root || (fromSeqNum == end))
+        return 0;
 
-    for (; i != rexmitQueue.rend() && seqLE(fromSeqNum, i->beginSeqNum); i++)
-    {
-        if (i->sacked)
-            bytes += (i->endSeqNum - i->beginSeqNum);
-    }
+    const Node *i = findRegion(fromSeqNum);
+    ASSERT(i != NULL);
 
-    if ( i != rexmitQueue.rend()
-            && seqLess(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum) && i->sacked)
-    {
-        bytes += (i->endSeqNum - fromSeqNum);
-    }
+    // sacked bytes from the region containing fromSeqNum, minus the part of it below fromSeqNum
+    uint32 bytes = getSummaryFrom(i->key).sackedBytes;
+    if (i->region.sacked)
+        bytes -= (fromSeqNum - i->region.beginSeqNum);
 
     return bytes;
 }
@@ -366,43 +606,26 @@ uint32 TCPSACKRexmitQueue::getNumOfDiscontiguousSacks(uint32 fromSeqNum) const
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
-    if (rexmitQueue.empty() || (fromSeqNum == end))
+    if (!root || (fromSeqNum == end))
         return 0;
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
-    uint32 counter = 0;
-
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum)) // search for seqNum
-        i++;
-
-    // search for discontiguous sacked regions
-    bool prevSacked = false;
-
-    while (i != rexmitQueue.end())
-    {
-        if (i->sacked && !prevSacked)
-            counter++;
-
-        prevSacked = i->sacked;
-        i++;
-    }
+    const Node *i = findRegion(fromSeqNum);
+    ASSERT(i != NULL);
 
-    return counter;
+    // discontiguous sacked regions = maximal sacked runs, starting at the region containing seqNum
+    return getSummaryFrom(i->key).numSackedRuns;
 }
 
 void TCPSACKRexmitQueue::checkSackBlock(uint32 fromSeqNum, uint32 &length, bool &sacked, bool &rexmitted) const
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLess(fromSeqNum, end));
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
-
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum)) // search for seqNum
-        i++;
+    const Node *i = findRegion(fromSeqNum);
 
-    ASSERT(i != rexmitQueue.end());
-    ASSERT(seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
+    ASSERT(i != NULL);
+    ASSERT(seqLE(i->region.beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->region.endSeqNum));
 
-    length = (i->endSeqNum - fromSeqNum);
-    sacked = i->sacked;
-    rexmitted = i->rexmitted;
+    length = (i->region.endSeqNum - fromSeqNum);
+    sacked = i->region.sacked;
+    rexmitted = i->region.rexmitted;
 }
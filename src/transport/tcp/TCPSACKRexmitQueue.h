@@ -25,7 +25,15 @@
 
 
 /**
- * Retransmission data for SACK.
+ * Retransmission data for SACK (the "scoreboard" of RFC 3517).
+ *
+ * The queue is a sequence of contiguous, non-overlapping regions between
+ * begin and end, each with a sacked and a rexmitted bit. Regions are stored
+ * in a treap (randomized balanced binary search tree) ordered by sequence
+ * number. Every tree node also carries aggregates of its subtree (number of
+ * regions, sacked and rexmitted bytes, number of maximal sacked runs), so
+ * locating a region, splitting it, and the "above seqNum" queries used by
+ * IsLost() take O(log n) time, and the totals are available in O(1).
  */
 class INET_API TCPSACKRexmitQueue
 {
@@ -40,12 +48,70 @@ class INET_API TCPSACKRexmitQueue
         bool rexmitted;   // indicates whether region has already been retransmitted by data sender
     };
 
-    typedef std::list<Region> RexmitQueue;
-    RexmitQueue rexmitQueue; // rexmitQueue is ordered by seqnum, and doesn't have overlapped Regions
+  protected:
+    // aggregated data of a subtree
+    struct Summary
+    {
+        uint32 numRegions;
+        uint32 sackedBytes;
+        uint32 rexmittedBytes;
+        uint32 numSackedRuns;  // number of maximal runs of adjacent sacked regions
+        bool firstSacked;      // whether the first region of the subtree is sacked
+        bool lastSacked;       // whether the last region of the subtree is sacked
+
+        Summary() : numRegions(0), sackedBytes(0), rexmittedBytes(0), numSackedRuns(0), firstSacked(false), lastSacked(false) {}
+    };
+
+    struct Node
+    {
+        Region region;
+        uint64 key;        // beginSeqNum mapped to the linear sequence number space, see toKey()
+        uint32 priority;   // heap priority of the treap
+        Node *left;
+        Node *right;
+        Summary summary;   // aggregates of the subtree rooted at this node
+    };
+
+    Node *root;  // region tree; regions are ordered by seqnum, and do not overlap
 
     uint32 begin;  // 1st sequence number stored
     uint32 end;    // last sequence number stored + 1
 
+    // Sequence numbers wrap around, so tree keys are sequence numbers mapped
+    // to a 64-bit linear space: key(seqNum) = beginKey + (seqNum - begin).
+    // This is unambiguous, because the queue is always much shorter than 2^31.
+    uint64 beginKey;
+
+    uint32 rngState;  // private generator for treap priorities, so that the simulation RNGs are not affected
+
+  protected:
+    uint64 toKey(uint32 seqNum) const { return beginKey + (uint32)(seqNum - begin); }
+    uint32 nextPriority();
+
+    static Summary combine(const Summary& left, const Region& region, const Summary& right);
+    static void updateSummary(Node *node);
+    static void deleteSubtree(Node *node);
+    static void rotateLeft(Node *&node);
+    static void rotateRight(Node *&node);
+
+    void insertNode(Node *&subtree, Node *node);
+    void eraseNode(Node *&subtree, uint64 key);
+    Node *insertRegion(uint32 beginSeqNum, uint32 endSeqNum, bool sacked, bool rexmitted);
+    void refreshPath(uint64 key);
+    static void refreshPath(Node *subtree, uint64 key);
+
+    Node *findRegion(uint32 seqNum) const;  // region containing seqNum
+    Node *findFirst() const;
+    Node *findLast() const;
+    Node *findNext(const Node *node) const;
+    Node *splitAt(Node *node, uint32 seqNum);  // returns the region beginning at seqNum
+    Summary getSummaryFrom(uint64 key) const;  // aggregates of the regions with key >= key
+    static Summary getSummaryFrom(const Node *subtree, uint64 key);
+
+    static void resetBits(Node *subtree, bool sacked, bool rexmitted);
+    void printRegions(const Node *subtree, uint32& j) const;
+    bool checkRegions(const Node *subtree, uint32& b, uint64& parentPriority) const;
+
   public:
     /**
      * Ctor
@@ -120,7 +186,7 @@ class INET_API TCPSACKRexmitQueue
     /**
      * Returns the number of blocks currently buffered in queue.
      */
-    virtual uint32 getQueueLength() const { return rexmitQueue.size(); }
+    virtual uint32 getQueueLength() const { return root ? root->summary.numRegions : 0; }
 
     /**
      * Returns the highest sequence number sacked by data receiver.
@@ -154,7 +220,12 @@ class INET_API TCPSACKRexmitQueue
     /**
      * Returns total amount of sacked bytes. Corresponds to update() function from RFC 3517.
      */
-    virtual uint32 getTotalAmountOfSackedBytes() const;
+    virtual uint32 getTotalAmountOfSackedBytes() const { return root ? root->summary.sackedBytes : 0; }
+
+    /**
+     * Returns total amount of rexmitted bytes.
+     */
+    virtual uint32 getTotalAmountOfRexmittedBytes() const { return root ? root->summary.rexmittedBytes : 0; }
 
     /**
      * Returns amount of sacked bytes above seqNum.
@@ -21,6 +21,10 @@
 
 
 #include <errno.h>
+#include <algorithm>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #include "PcapDump.h"
 
@@ -45,6 +49,9 @@
 
 #define PCAP_MAGIC           0xa1b2c3d4
 
+#define DEFAULT_BUFFER_SIZE  (1 << 20)
+#define NUM_ASYNC_BUFFERS    4
+
 /* "libpcap" file header (minus magic number). */
 struct pcap_hdr {
      uint32 magic;      /* magic */
@@ -64,31 +71,161 @@ struct pcaprec_hdr {
      uint32 orig_len;   /* actual length of packet */
 };
 
+/* link layer header (DLT_NULL) and its value for IPv4 and IPv6 */
+#define LINK_HEADER_LENGTH  sizeof(uint32)
+#define LINK_HEADER_VALUE   2   // AF_INET
+
+#ifdef HAVE_PTHREAD
+struct PcapDump::WriterThread
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t jobAvailable;
+    pthread_cond_t bufferAvailable;
+};
+#endif
 
 
 PcapDump::PcapDump()
 {
-     dumpfile = NULL;
+    dumpfile = NULL;
+    snaplen = 0;
+    fileIndex = 0;
+    maxFileSize = 0;
+    rotationInterval = 0;
+    fileSize = 0;
+    fileHasRecords = false;
+    bufferSize = DEFAULT_BUFFER_SIZE;
+    buffer = NULL;
+    bufferUsed = 0;
+    async = false;
+    stopWriter = false;
+    writeError = 0;
+    writer = NULL;
 }
 
 PcapDump::~PcapDump()
 {
-    closePcap();
+    try
+    {
+        closePcap();
+    }
+    catch (std::exception& e)
+    {
+        // destructors must not throw; call closePcap() explicitly to get write errors reported
+    }
 }
 
-void PcapDump::openPcap(const char* filename, unsigned int snaplen_par)
+void PcapDump::setBuffering(size_t bufferSize, bool async)
 {
-    struct pcap_hdr fh;
+    if (dumpfile)
+        throw cRuntimeError("PcapDump: cannot change buffering while the pcap file is open");
+
+    // the buffer must hold at least one record of maximum length
+    this->bufferSize = std::max(bufferSize, (size_t)(2 * MAXBUFLENGTH));
+#ifdef HAVE_PTHREAD
+    this->async = async;
+#else
+    this->async = false;
+#endif
+}
+
+void PcapDump::setRotation(uint64 maxFileSize, simtime_t rotationInterval)
+{
+    if (dumpfile)
+        throw cRuntimeError("PcapDump: cannot change rotation while the pcap file is open");
+    if (rotationInterval < 0)
+        throw cRuntimeError("PcapDump: negative rotation interval");
 
+    this->maxFileSize = maxFileSize;
+    this->rotationInterval = rotationInterval;
+}
+
+void PcapDump::openPcap(const char* filename, unsigned int snaplen_par)
+{
     if (!filename || !filename[0])
         throw cRuntimeError("Cannot open pcap file: file name is empty");
 
-    dumpfile = fopen(filename, "wb");
+    fileName = filename;
+    fileIndex = 0;
+    snaplen = snaplen_par;
+    writeError = 0;
+
+    int numBuffers = async ? NUM_ASYNC_BUFFERS : 1;
+    for (int i = 0; i < numBuffers; i++)
+    {
+        allBuffers.push_back(new char[bufferSize]);
+        freeBuffers.push_back(allBuffers.back());
+    }
+    buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+    bufferUsed = 0;
+
+    try
+    {
+        openFile();
+    }
+    catch (std::exception& e)
+    {
+        freeAllBuffers();
+        throw;
+    }
+
+#ifdef HAVE_PTHREAD
+    if (async)
+    {
+        writer = new WriterThread();
+        pthread_mutex_init(&writer->mutex, NULL);
+        pthread_cond_init(&writer->jobAvailable, NULL);
+        pthread_cond_init(&writer->bufferAvailable, NULL);
+        stopWriter = false;
+        if (pthread_create(&writer->thread, NULL, writerThreadMain, this) != 0)
+        {
+            // fall back to writing from the simulation thread
+            pthread_cond_destroy(&writer->bufferAvailable);
+            pthread_cond_destroy(&writer->jobAvailable);
+            pthread_mutex_destroy(&writer->mutex);
+            delete writer;
+            writer = NULL;
+            async = false;
+        }
+    }
+#endif
+}
+
+void PcapDump::freeAllBuffers()
+{
+    for (std::vector<char *>::iterator i = allBuffers.begin(); i != allBuffers.end(); ++i)
+        delete [] *i;
+    allBuffers.clear();
+    freeBuffers.clear();
+    buffer = NULL;
+    bufferUsed = 0;
+}
+
+void PcapDump::openFile()
+{
+    std::string name = fileName;
+    if (fileIndex > 0)
+    {
+        char suffix[16];
+        sprintf(suffix, ".%d", fileIndex);
+        name += suffix;
+    }
+
+    dumpfile = fopen(name.c_str(), "wb");
 
     if (!dumpfile)
-        throw cRuntimeError("Cannot open pcap file [%s] for writing: %s", filename, strerror(errno));
+        throw cRuntimeError("Cannot open pcap file [%s] for writing: %s", name.c_str(), strerror(errno));
 
-    snaplen = snaplen_par;
+    fileSize = 0;
+    fileHasRecords = false;
+    writeFileHeader();
+}
+
+void PcapDump::writeFileHeader()
+{
+    struct pcap_hdr fh;
 
     fh.magic = PCAP_MAGIC;
     fh.version_major = 2;
@@ -97,31 +234,178 @@ void PcapDump::openPcap(const char* filename, unsigned int snaplen_par)
     fh.sigfigs = 0;
     fh.snaplen = snaplen;
     fh.network = 0;
-    fwrite(&fh, sizeof(fh), 1, dumpfile);
+
+    memcpy(buffer + bufferUsed, &fh, sizeof(fh));
+    bufferUsed += sizeof(fh);
+    fileSize += sizeof(fh);
 }
 
-void PcapDump::writeFrame(simtime_t stime, const IPv4Datagram *ipPacket)
+#ifdef HAVE_PTHREAD
+void *PcapDump::writerThreadMain(void *arg)
 {
-    if (!dumpfile)
-        throw cRuntimeError("Cannot write frame: pcap output file is not open");
+    ((PcapDump *)arg)->writeJobs();
+    return NULL;
+}
 
-#ifdef WITH_IPv4
-    uint8 buf[MAXBUFLENGTH];
-    memset((void*)&buf, 0, sizeof(buf));
+void PcapDump::writeJobs()
+{
+    // runs in the writer thread until stopWriter is set and all jobs are done
+    pthread_mutex_lock(&writer->mutex);
+    while (true)
+    {
+        while (jobs.empty() && !stopWriter)
+            pthread_cond_wait(&writer->jobAvailable, &writer->mutex);
+        if (jobs.empty())
+            break;
+
+        WriteJob job = jobs.front();
+        pthread_mutex_unlock(&writer->mutex);
+
+        int error = 0;
+        if (job.length > 0 && fwrite(job.data, job.length, 1, job.file) != 1)
+            error = errno;
+        if (job.closeFile && fclose(job.file) != 0 && !error)
+            error = errno;
+
+        pthread_mutex_lock(&writer->mutex);
+        // the job is removed only now, so that flush() can wait for its completion
+        jobs.pop_front();
+        if (error && !writeError)
+            writeError = error;
+        freeBuffers.push_back(job.data);
+        pthread_cond_signal(&writer->bufferAvailable);
+    }
+    pthread_mutex_unlock(&writer->mutex);
+}
+#endif
+
+void PcapDump::submitBuffer(bool closeFile)
+{
+    if (!async)
+    {
+        // write directly, and keep the buffer
+        if (bufferUsed > 0 && fwrite(buffer, bufferUsed, 1, dumpfile) != 1 && !writeError)
+            writeError = errno;
+        if (closeFile && fclose(dumpfile) != 0 && !writeError)
+            writeError = errno;
+        bufferUsed = 0;
+        if (writeError)
+            throw cRuntimeError("Cannot write pcap file [%s]: %s", fileName.c_str(), strerror(writeError));
+        return;
+    }
+
+#ifdef HAVE_PTHREAD
+    WriteJob job;
+    job.data = buffer;
+    job.length = bufferUsed;
+    job.file = dumpfile;
+    job.closeFile = closeFile;
+
+    pthread_mutex_lock(&writer->mutex);
+    jobs.push_back(job);
+    pthread_cond_signal(&writer->jobAvailable);
+    pthread_mutex_unlock(&writer->mutex);
+
+    buffer = NULL;
+    bufferUsed = 0;
+#endif
+}
+
+void PcapDump::acquireBuffer()
+{
+    if (buffer)
+        return;
+
+    if (!async)
+    {
+        buffer = freeBuffers.back();
+        freeBuffers.pop_back();
+        return;
+    }
+
+#ifdef HAVE_PTHREAD
+    // wait for the writer thread if it lags behind
+    pthread_mutex_lock(&writer->mutex);
+    while (freeBuffers.empty())
+        pthread_cond_wait(&writer->bufferAvailable, &writer->mutex);
+    buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+    int error = writeError;
+    pthread_mutex_unlock(&writer->mutex);
+
+    if (error)
+        throw cRuntimeError("Cannot write pcap file [%s]: %s", fileName.c_str(), strerror(error));
+#endif
+}
 
+void PcapDump::rotateIfNeeded(simtime_t stime, size_t recordLength)
+{
+    if (!fileHasRecords)
+        return;
+
+    bool sizeExceeded = maxFileSize > 0 && fileSize + recordLength > maxFileSize;
+    bool timeExceeded = rotationInterval > 0 && stime - fileStartTime >= rotationInterval;
+    if (sizeExceeded || timeExceeded)
+    {
+        submitBuffer(true);
+        acquireBuffer();
+        fileIndex++;
+        openFile();
+    }
+}
+
+unsigned char *PcapDump::beginRecord(simtime_t stime, size_t packetLength)
+{
+    // packetLength is the expected length of the serialized packet, for the
+    // rotation decision; the serializers may write up to MAXBUFLENGTH bytes
+    packetLength = std::min(packetLength, (size_t)MAXBUFLENGTH);
+    rotateIfNeeded(stime, sizeof(pcaprec_hdr) + std::min(packetLength + LINK_HEADER_LENGTH, (size_t)snaplen));
+
+    if (bufferUsed + sizeof(pcaprec_hdr) + LINK_HEADER_LENGTH + MAXBUFLENGTH > bufferSize)
+    {
+        submitBuffer(false);
+        acquireBuffer();
+    }
+
+    // the packet is serialized in place, after the record and link headers
+    unsigned char *buf = (unsigned char *)buffer + bufferUsed + sizeof(pcaprec_hdr) + LINK_HEADER_LENGTH;
+    memset(buf, 0, MAXBUFLENGTH);
+    return buf;
+}
+
+void PcapDump::endRecord(simtime_t stime, unsigned int serializedLength)
+{
     struct pcaprec_hdr ph;
     ph.ts_sec = (int32)stime.dbl();
     ph.ts_usec = (uint32)((stime.dbl() - ph.ts_sec) * 1000000);
-     // Write Ethernet header
-    uint32 hdr = 2; //AF_INET
+    ph.orig_len = serializedLength + LINK_HEADER_LENGTH;
+    ph.incl_len = ph.orig_len > snaplen ? snaplen : ph.orig_len;
 
-    int32 serialized_ip = IPv4Serializer().serialize(ipPacket, buf, sizeof(buf), true);
-    ph.orig_len = serialized_ip + sizeof(uint32);
+    uint32 hdr = LINK_HEADER_VALUE;
+    char *record = buffer + bufferUsed;
+    memcpy(record, &ph, sizeof(ph));
+    memcpy(record + sizeof(ph), &hdr, LINK_HEADER_LENGTH);
 
-    ph.incl_len = ph.orig_len > snaplen ? snaplen : ph.orig_len;
-    fwrite(&ph, sizeof(ph), 1, dumpfile);
-    fwrite(&hdr, sizeof(uint32), 1, dumpfile);
-    fwrite(buf, ph.incl_len - sizeof(uint32), 1, dumpfile);
+    // bytes beyond snaplen are simply not kept
+    bufferUsed += sizeof(ph) + ph.incl_len;
+    fileSize += sizeof(ph) + ph.incl_len;
+
+    if (!fileHasRecords)
+    {
+        fileStartTime = stime;
+        fileHasRecords = true;
+    }
+}
+
+void PcapDump::writeFrame(simtime_t stime, const IPv4Datagram *ipPacket)
+{
+    if (!dumpfile)
+        throw cRuntimeError("Cannot write frame: pcap output file is not open");
+
+#ifdef WITH_IPv4
+    unsigned char *buf = beginRecord(stime, ipPacket->getByteLength());
+    int32 serialized_ip = IPv4Serializer().serialize(ipPacket, buf, MAXBUFLENGTH, true);
+    endRecord(stime, serialized_ip);
 #else
     throw cRuntimeError("Cannot write frame: INET compiled without IPv4 feature");
 #endif
@@ -133,35 +417,75 @@ void PcapDump::writeIPv6Frame(simtime_t stime, const IPv6Datagram *ipPacket)
         throw cRuntimeError("Cannot write frame: pcap output file is not open");
 
 #ifdef WITH_IPv6
-    uint8 buf[MAXBUFLENGTH];
-    memset((void*)&buf, 0, sizeof(buf));
+    unsigned char *buf = beginRecord(stime, ipPacket->getByteLength());
+    int32 serialized_ip = IPv6Serializer().serialize(ipPacket, buf, MAXBUFLENGTH);
+    if (serialized_ip > 0)
+        endRecord(stime, serialized_ip);
+#else
+    throw cRuntimeError("Cannot write frame: INET compiled without IPv6 feature");
+#endif
+}
 
-    struct pcaprec_hdr ph;
-    ph.ts_sec = (int32)stime.dbl();
-    ph.ts_usec = (uint32)((stime.dbl() - ph.ts_sec) * 1000000);
-     // Write Ethernet header
-    uint32 hdr = 2; //AF_INET
+void PcapDump::flush()
+{
+    if (!dumpfile)
+        return;
 
-    int32 serialized_ip = IPv6Serializer().serialize(ipPacket, buf, sizeof(buf));
-    if (serialized_ip > 0) {
-        ph.orig_len = serialized_ip + sizeof(uint32);
+    submitBuffer(false);
+    acquireBuffer();
 
-        ph.incl_len = ph.orig_len > snaplen ? snaplen : ph.orig_len;
-        fwrite(&ph, sizeof(ph), 1, dumpfile);
-        fwrite(&hdr, sizeof(uint32), 1, dumpfile);
-        fwrite(buf, ph.incl_len - sizeof(uint32), 1, dumpfile);
+#ifdef HAVE_PTHREAD
+    if (async)
+    {
+        pthread_mutex_lock(&writer->mutex);
+        while (!jobs.empty())
+            pthread_cond_wait(&writer->bufferAvailable, &writer->mutex);
+        int error = writeError;
+        pthread_mutex_unlock(&writer->mutex);
+        if (error)
+            throw cRuntimeError("Cannot write pcap file [%s]: %s", fileName.c_str(), strerror(error));
     }
-#else
-    throw cRuntimeError("Cannot write frame: INET compiled without IPv6 feature");
 #endif
+    fflush(dumpfile);
 }
 
 void PcapDump::closePcap()
 {
-    if (dumpfile)
+    if (!dumpfile)
+        return;
+
+    int error = 0;
+#ifdef HAVE_PTHREAD
+    if (async)
     {
-        fclose(dumpfile);
-        dumpfile = NULL;
+        submitBuffer(true);
+        pthread_mutex_lock(&writer->mutex);
+        stopWriter = true;
+        pthread_cond_signal(&writer->jobAvailable);
+        pthread_mutex_unlock(&writer->mutex);
+        pthread_join(writer->thread, NULL);
+        error = writeError;
+        pthread_cond_destroy(&writer->bufferAvailable);
+        pthread_cond_destroy(&writer->jobAvailable);
+        pthread_mutex_destroy(&writer->mutex);
+        delete writer;
+        writer = NULL;
     }
-}
+    else
+#endif
+    {
+        try
+        {
+            submitBuffer(true);
+        }
+        catch (std::exception& e)
+        {
+            error = writeError;
+        }
+    }
+    dumpfile = NULL;
+    freeAllBuffers();
 
+    if (error)
+        throw cRuntimeError("Cannot write pcap file [%s]: %s", fileName.c_str(), strerror(error));
+}
@@ -22,6 +22,9 @@
 #define __INET_PCAPDUMP_H
 
 
+#include <deque>
+#include <vector>
+
 #include "INETDefs.h"
 
 // Foreign declarations:
@@ -34,12 +37,65 @@ class IPv6Datagram;
  * http://www.tcpdump.org/ for details on the file format.
  * Note: The file is currently recorded in the "classic" format,
  * not in the "Next Generation" file format also on tcpdump.org.
+ *
+ * Records are collected in large write buffers. Full buffers are written
+ * to the file either directly, or, in asynchronous mode, by a background
+ * thread so that disk I/O does not block the simulation. Asynchronous mode
+ * needs POSIX threads (HAVE_PTHREAD, see makefrag); without them, buffers
+ * are always written directly. The output can
+ * be split into several files by size and/or by simulation time; the
+ * additional files are named <filename>.1, <filename>.2, etc.
  */
 class PcapDump
 {
     protected:
+        // a filled buffer waiting to be written into a file
+        struct WriteJob
+        {
+            char *data;
+            size_t length;
+            FILE *file;         // target file
+            bool closeFile;     // close the file after writing the data
+        };
+
         FILE *dumpfile;         // pcap file
         unsigned int snaplen;   // max. length of packets in pcap file
+        std::string fileName;   // name of the first file
+        int fileIndex;          // index of the current file, 0 for the first one
+
+        // rotation
+        uint64 maxFileSize;     // 0 means unlimited
+        simtime_t rotationInterval;  // 0 means no time based rotation
+        uint64 fileSize;        // bytes recorded into the current file
+        simtime_t fileStartTime;
+        bool fileHasRecords;
+
+        // write buffering
+        size_t bufferSize;
+        char *buffer;           // buffer being filled
+        size_t bufferUsed;
+        std::vector<char *> freeBuffers;
+
+        // background writer
+        bool async;
+        bool stopWriter;
+        int writeError;         // errno of the first failed write, 0 if none
+        std::deque<WriteJob> jobs;
+        std::vector<char *> allBuffers;
+        struct WriterThread;    // thread and synchronization, defined in PcapDump.cc
+        WriterThread *writer;   // NULL unless in asynchronous mode
+
+    protected:
+        static void *writerThreadMain(void *arg);
+        void writeJobs();
+        void submitBuffer(bool closeFile);
+        void acquireBuffer();
+        void writeFileHeader();
+        void openFile();
+        void rotateIfNeeded(simtime_t stime, size_t recordLength);
+        unsigned char *beginRecord(simtime_t stime, size_t packetLength);
+        void endRecord(simtime_t stime, unsigned int serializedLength);
+        void freeAllBuffers();
 
     public:
         /**
@@ -52,6 +108,21 @@ class PcapDump
          */
         ~PcapDump();
 
+        /**
+         * Sets the size of the write buffers (default: 1MiB), and whether the
+         * buffers are written by a background thread (default: false; ignored
+         * without HAVE_PTHREAD). Must be called before openPcap().
+         */
+        void setBuffering(size_t bufferSize, bool async);
+
+        /**
+         * Enables starting a new file when the current one would exceed
+         * maxFileSize bytes, or when rotationInterval of simulation time has
+         * passed since the first packet of the current file. Zero values
+         * disable the respective limit. Must be called before openPcap().
+         */
+        void setRotation(uint64 maxFileSize, simtime_t rotationInterval);
+
         /**
          * Opens a PCAP file with the given file name. The snaplen parameter
          * is the length that packets will be truncated to. Throws an exception
@@ -71,6 +142,11 @@ class PcapDump
         void writeFrame(simtime_t time, const IPv4Datagram *ipPacket);
         void writeIPv6Frame(simtime_t stime, const IPv6Datagram *ipPacket);
 
+        /**
+         * Writes out all buffered records, and waits until they are written.
+         */
+        void flush();
+
         /**
          * Closes the output file if it is open.
          */
@@ -105,7 +105,11 @@ void PcapRecorder::initialize()
     }
 
     if (*file)
+    {
+        pcapDumper.setBuffering((size_t)par("bufferSize").longValue(), par("asyncWrite").boolValue());
+        pcapDumper.setRotation((uint64)par("maxFileSize").longValue(), par("rotationInterval").doubleValue());
         pcapDumper.openPcap(file, snaplen);
+    }
 }
 
 void PcapRecorder::handleMessage(cMessage *msg)
@@ -16,6 +16,12 @@
 // along with this program; if not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "TCPIPchecksum.h"
 
 //#if !defined(_WIN32) && !defined(__WIN32__) && !defined(WIN32) && !defined(__CYGWIN__) && !defined(_WIN64)
@@ -24,19 +30,67 @@
 
 uint16_t TCPIPchecksum::_checksum(const void *addr, unsigned int count)
 {
-    uint32_t sum = 0;
+    // The one's complement sum of 16 bit words can be computed from the sum of
+    // 32 bit words (2^16 == 1 modulo 2^16-1), so we add 32 bit words into a
+    // 64 bit accumulator which cannot overflow, and fold it once at the end.
+    const uint8_t *ptr = (const uint8_t *)addr;
+    uint64_t sum = 0;
+
+#ifdef __SSE2__
+    if (count >= 64)
+    {
+        // zero-extend the 32 bit words of 32 bytes into 64 bit lanes, and add them up
+        const __m128i zero = _mm_setzero_si128();
+        __m128i acc0 = zero, acc1 = zero;
+        while (count >= 32)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)ptr);
+            __m128i b = _mm_loadu_si128((const __m128i *)(ptr + 16));
+            acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(a, zero));
+            acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(a, zero));
+            acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(b, zero));
+            acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(b, zero));
+            ptr += 32;
+            count -= 32;
+        }
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(acc0, acc1));
+        sum = lanes[0] + lanes[1];
+    }
+#endif
+
+    while (count >= 16)
+    {
+        uint32_t words[4];
+        memcpy(words, ptr, 16);   // no alignment requirement
+        sum += (uint64_t)words[0] + words[1] + words[2] + words[3];
+        ptr += 16;
+        count -= 16;
+    }
+
+    while (count >= 4)
+    {
+        uint32_t word;
+        memcpy(&word, ptr, 4);
+        sum += word;
+        ptr += 4;
+        count -= 4;
+    }
 
-    while (count > 1)
+    if (count >= 2)
     {
-        sum += *((const uint16_t *&)addr)++;
-        if (sum & 0x80000000)
-            sum = (sum & 0xFFFF) + (sum >> 16);
+        uint16_t word;
+        memcpy(&word, ptr, 2);
+        sum += word;
+        ptr += 2;
         count -= 2;
     }
 
     if (count)
-        sum += *(const uint8_t *)addr;
+        sum += *ptr;
 
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
     while (sum >> 16)
         sum = (sum & 0xFFFF) + (sum >> 16);
 
@@ -42,7 +42,39 @@ class TCPIPchecksum
             return ~ _checksum(addr, count);
         }
 
+        /*
+         * Returns the one's complement sum of the data, folded to 16 bits but
+         * not complemented. Words are summed in host byte order, so the result
+         * can be stored in the header as is.
+         */
         static uint16_t _checksum(const void *addr, unsigned int count);
+
+        /*
+         * Incremental update of a checksum stored in a header (RFC 1624, eqn. 3)
+         * after a 16 bit word of the checksummed data changed from oldWord to
+         * newWord, e.g. the TTL/protocol word of an IPv4 header. All values are
+         * taken in the byte order they are stored in the packet.
+        */
+        static uint16_t updateChecksum(uint16_t checksum, uint16_t oldWord, uint16_t newWord)
+        {
+            uint32_t sum = (uint32_t)(uint16_t)~checksum + (uint16_t)~oldWord + newWord;
+            sum = (sum & 0xFFFF) + (sum >> 16);
+            sum = (sum & 0xFFFF) + (sum >> 16);
+            return (uint16_t)~sum;
+        }
+
+        /*
+         * Incremental update of a checksum after count bytes of the checksummed
+         * data changed from oldData to newData, e.g. an address rewritten by NAT.
+         * The changed bytes must start at an even offset of the checksummed data.
+        */
+        static uint16_t updateChecksum(uint16_t checksum, const void *oldData, const void *newData, unsigned int count)
+        {
+            uint32_t sum = (uint32_t)(uint16_t)~checksum + (uint16_t)~_checksum(oldData, count) + _checksum(newData, count);
+            sum = (sum & 0xFFFF) + (sum >> 16);
+            sum = (sum & 0xFFFF) + (sum >> 16);
+            return (uint16_t)~sum;
+        }
 };
 
 #endif
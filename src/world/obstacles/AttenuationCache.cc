@@ -0,0 +1,161 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#include "world/obstacles/AttenuationCache.h"
+
+
+bool AttenuationCache::Key::operator==(const Key& o) const {
+    for (int i = 0; i < KEY_LENGTH; i++)
+        if (values[i] != o.values[i]) return false;
+    return true;
+}
+
+AttenuationCache::AttenuationCache(int capacity, double positionResolution) {
+    configure(capacity, positionResolution);
+}
+
+void AttenuationCache::configure(int capacity, double positionResolution) {
+    if (capacity < 0) throw cRuntimeError("AttenuationCache: negative capacity %d", capacity);
+    if (positionResolution < 0) throw cRuntimeError("AttenuationCache: negative position resolution %g", positionResolution);
+
+    this->positionResolution = positionResolution;
+    entries.resize(capacity);
+
+    // keep the load factor at or below 1/2
+    size_t numBuckets = 1;
+    while (numBuckets < 2 * (size_t)capacity) numBuckets *= 2;
+    buckets.resize(numBuckets);
+
+    numHits = numMisses = numEvictions = 0;
+    clear();
+}
+
+void AttenuationCache::clear() {
+    std::fill(buckets.begin(), buckets.end(), -1);
+    numEntries = 0;
+    lruHead = lruTail = -1;
+}
+
+int64 AttenuationCache::bitsOf(double value) {
+    int64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+int64 AttenuationCache::quantize(double position) const {
+    if (positionResolution == 0) return bitsOf(position);
+    return (int64)floor(position / positionResolution + 0.5);
+}
+
+AttenuationCache::Key AttenuationCache::makeKey(double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) const {
+    Key key;
+    key.values[0] = quantize(senderPos.x);
+    key.values[1] = quantize(senderPos.y);
+    key.values[2] = quantize(receiverPos.x);
+    key.values[3] = quantize(receiverPos.y);
+    key.values[4] = bitsOf(senderAngle);
+    key.values[5] = bitsOf(receiverAngle);
+    key.values[6] = bitsOf(carrierFrequency);
+    return key;
+}
+
+size_t AttenuationCache::bucketOf(const Key& key) const {
+    // 64-bit FNV-1a style mixing of the key words, folded to the table size
+    uint64 hash = 14695981039346656037ULL;
+    for (int i = 0; i < KEY_LENGTH; i++) {
+        hash ^= (uint64)key.values[i];
+        hash *= 1099511628211ULL;
+        hash ^= hash >> 29;
+    }
+    return (size_t)(hash & (buckets.size() - 1));
+}
+
+void AttenuationCache::unlinkLru(int index) {
+    Entry& e = entries[index];
+    if (e.lruPrev != -1) entries[e.lruPrev].lruNext = e.lruNext; else lruHead = e.lruNext;
+    if (e.lruNext != -1) entries[e.lruNext].lruPrev = e.lruPrev; else lruTail = e.lruPrev;
+}
+
+void AttenuationCache::pushLruHead(int index) {
+    Entry& e = entries[index];
+    e.lruPrev = -1;
+    e.lruNext = lruHead;
+    if (lruHead != -1) entries[lruHead].lruPrev = index; else lruTail = index;
+    lruHead = index;
+}
+
+void AttenuationCache::removeFromBucket(int index) {
+    int *link = &buckets[bucketOf(entries[index].key)];
+    while (*link != index) {
+        ASSERT(*link != -1);
+        link = &entries[*link].bucketNext;
+    }
+    *link = entries[index].bucketNext;
+}
+
+bool AttenuationCache::lookup(double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle, double& factor) {
+    if (entries.empty()) return false;
+
+    Key key = makeKey(carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
+    for (int i = buckets[bucketOf(key)]; i != -1; i = entries[i].bucketNext) {
+        if (entries[i].key == key) {
+            if (i != lruHead) {
+                unlinkLru(i);
+                pushLruHead(i);
+            }
+            factor = entries[i].factor;
+            numHits++;
+            return true;
+        }
+    }
+    numMisses++;
+    return false;
+}
+
+void AttenuationCache::insert(double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle, double factor) {
+    if (entries.empty()) return;
+
+    Key key = makeKey(carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
+    size_t bucket = bucketOf(key);
+    for (int i = buckets[bucket]; i != -1; i = entries[i].bucketNext) {
+        if (entries[i].key == key) {
+            entries[i].factor = factor;
+            return;
+        }
+    }
+
+    int index;
+    if (numEntries < (int)entries.size())
+        index = numEntries++;
+    else {
+        // reuse the least recently used entry
+        index = lruTail;
+        unlinkLru(index);
+        removeFromBucket(index);
+        numEvictions++;
+    }
+
+    Entry& e = entries[index];
+    e.key = key;
+    e.factor = factor;
+    e.bucketNext = buckets[bucket];
+    buckets[bucket] = index;
+    pushLruHead(index);
+}
@@ -0,0 +1,99 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+
+
+#ifndef WORLD_OBSTACLE_ATTENUATIONCACHE_H
+#define WORLD_OBSTACLE_ATTENUATIONCACHE_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "Coord.h"
+
+/**
+ * Fixed capacity cache of obstacle attenuation factors for ObstacleControl,
+ * with least recently used eviction.
+ *
+ * Entries are keyed on the sender and receiver positions (x and y only),
+ * the antenna angles and the carrier frequency. If a position resolution
+ * is given, positions are rounded to multiples of it, so that nodes moving
+ * less than the resolution reuse the cached value; with zero resolution
+ * the key is the exact position.
+ *
+ * Entries live in a preallocated array; they are chained into hash buckets
+ * and into a doubly linked LRU list by index, so lookups and insertions
+ * do not allocate memory.
+ */
+class INET_API AttenuationCache {
+    public:
+        /** A capacity of 0 disables the cache. */
+        AttenuationCache(int capacity = 0, double positionResolution = 0);
+
+        /** Changes the capacity and resolution; drops all entries. */
+        void configure(int capacity, double positionResolution);
+
+        /** Returns true and stores the factor in factor if the key is cached. */
+        bool lookup(double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle, double& factor);
+
+        /** Caches the factor, evicting the least recently used entry if the cache is full. */
+        void insert(double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle, double factor);
+
+        /** Drops all entries. */
+        void clear();
+
+        int getCapacity() const { return entries.size(); }
+        int getNumEntries() const { return numEntries; }
+        long getNumHits() const { return numHits; }
+        long getNumMisses() const { return numMisses; }
+        long getNumEvictions() const { return numEvictions; }
+
+    protected:
+        enum { KEY_LENGTH = 7 };
+
+        struct Key {
+            int64 values[KEY_LENGTH];
+            bool operator==(const Key& o) const;
+        };
+
+        struct Entry {
+            Key key;
+            double factor;
+            int bucketNext;     // next entry in the same bucket, or -1
+            int lruPrev;        // towards the most recently used entry, or -1
+            int lruNext;        // towards the least recently used entry, or -1
+        };
+
+        double positionResolution;
+        std::vector<Entry> entries;
+        std::vector<int> buckets;   // first entry of each bucket, or -1; size is a power of 2
+        int numEntries;             // entries[0..numEntries) are in use
+        int lruHead;                // most recently used entry, or -1
+        int lruTail;                // least recently used entry, or -1
+        long numHits;
+        long numMisses;
+        long numEvictions;
+
+        int64 quantize(double position) const;
+        static int64 bitsOf(double value);
+        Key makeKey(double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) const;
+        size_t bucketOf(const Key& key) const;
+        void unlinkLru(int index);
+        void pushLruHead(int index);
+        void removeFromBucket(int index);
+};
+
+#endif
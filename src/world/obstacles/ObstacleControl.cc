@@ -18,15 +18,22 @@
 //
 
 #include <sstream>
-#include <map>
-#include <set>
+#include <algorithm>
 
 #include "world/obstacles/ObstacleControl.h"
 
 
 Define_Module(ObstacleControl);
 
+ObstacleControl::ObstacleControl() :
+    obstaclesXml(NULL),
+    obstacleIndexValid(false),
+    annotations(NULL),
+    annotationGroup(NULL) {
+}
+
 ObstacleControl::~ObstacleControl() {
+    for (Obstacles::iterator i = obstacles.begin(); i != obstacles.end(); ++i) delete *i;
 }
 
 void ObstacleControl::initialize(int stage)
@@ -36,7 +43,8 @@ void ObstacleControl::initialize(int stage)
     if (stage == 0)
     {
         obstacles.clear();
-        cacheEntries.clear();
+        obstaclesChanged();
+        cache.configure(par("cacheSize").longValue(), par("cachePositionResolution").doubleValue());
 
         obstaclesXml = par("obstacles");
     }
@@ -51,12 +59,11 @@ void ObstacleControl::initialize(int stage)
 }
 
 void ObstacleControl::finish() {
-    for (Obstacles::iterator i = obstacles.begin(); i != obstacles.end(); ++i) {
-        for (ObstacleGridRow::iterator j = i->begin(); j != i->end(); ++j) {
-            while (j->begin() != j->end()) erase(*j->begin());
-        }
-    }
-    obstacles.clear();
+    recordScalar("attenuation cache hits", cache.getNumHits());
+    recordScalar("attenuation cache misses", cache.getNumMisses());
+    recordScalar("attenuation cache evictions", cache.getNumEvictions());
+
+    while (!obstacles.empty()) erase(obstacles.back());
 }
 
 void ObstacleControl::handleMessage(cMessage *msg) {
@@ -114,98 +121,64 @@ void ObstacleControl::addFromXml(cXMLElement* xml) {
 
 void ObstacleControl::add(Obstacle obstacle) {
     Obstacle* o = new Obstacle(obstacle);
-
-    size_t fromRow = std::max(0, int(o->getBboxP1().x / GRIDCELL_SIZE));
-    size_t toRow = std::max(0, int(o->getBboxP2().x / GRIDCELL_SIZE));
-    size_t fromCol = std::max(0, int(o->getBboxP1().y / GRIDCELL_SIZE));
-    size_t toCol = std::max(0, int(o->getBboxP2().y / GRIDCELL_SIZE));
-    for (size_t row = fromRow; row <= toRow; ++row) {
-        for (size_t col = fromCol; col <= toCol; ++col) {
-            if (obstacles.size() < col+1) obstacles.resize(col+1);
-            if (obstacles[col].size() < row+1) obstacles[col].resize(row+1);
-            (obstacles[col])[row].push_back(o);
-        }
-    }
+    obstacles.push_back(o);
 
     // visualize using AnnotationManager
     if (annotations) o->visualRepresentation = annotations->drawPolygon(o->getShape(), "red", annotationGroup);
 
-    cacheEntries.clear();
+    obstaclesChanged();
 }
 
 void ObstacleControl::erase(const Obstacle* obstacle) {
-    for (Obstacles::iterator i = obstacles.begin(); i != obstacles.end(); ++i) {
-        for (ObstacleGridRow::iterator j = i->begin(); j != i->end(); ++j) {
-            for (ObstacleGridCell::iterator k = j->begin(); k != j->end(); ) {
-                Obstacle* o = *k;
-                if (o == obstacle) {
-                    k = j->erase(k);
-                } else {
-                    ++k;
-                }
-            }
-        }
-    }
+    Obstacles::iterator it = std::find(obstacles.begin(), obstacles.end(), obstacle);
+    if (it != obstacles.end()) obstacles.erase(it);
 
     if (annotations && obstacle->visualRepresentation) annotations->erase(obstacle->visualRepresentation);
     delete obstacle;
 
-    cacheEntries.clear();
+    obstaclesChanged();
+}
+
+void ObstacleControl::obstaclesChanged() {
+    obstacleIndexValid = false;
+    cache.clear();
 }
 
 double ObstacleControl::calculateReceivedPower(double pSend, double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) const {
     Enter_Method_Silent();
 
     // return cached result, if available
-    CacheKey cacheKey(pSend, carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
-    CacheEntries::const_iterator cacheEntryIter = cacheEntries.find(cacheKey);
-    if (cacheEntryIter != cacheEntries.end()) return cacheEntryIter->second;
-
-    // calculate bounding box of transmission
-    Coord bboxP1 = Coord(std::min(senderPos.x, receiverPos.x), std::min(senderPos.y, receiverPos.y));
-    Coord bboxP2 = Coord(std::max(senderPos.x, receiverPos.x), std::max(senderPos.y, receiverPos.y));
-
-    size_t fromRow = std::max(0, int(bboxP1.x / GRIDCELL_SIZE));
-    size_t toRow = std::max(0, int(bboxP2.x / GRIDCELL_SIZE));
-    size_t fromCol = std::max(0, int(bboxP1.y / GRIDCELL_SIZE));
-    size_t toCol = std::max(0, int(bboxP2.y / GRIDCELL_SIZE));
+    double factor;
+    if (cache.lookup(carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle, factor)) return pSend * factor;
 
-    std::set<Obstacle*> processedObstacles;
-    for (size_t col = fromCol; col <= toCol; ++col) {
-        if (col >= obstacles.size()) break;
-        for (size_t row = fromRow; row <= toRow; ++row) {
-            if (row >= obstacles[col].size()) break;
-            const ObstacleGridCell& cell = (obstacles[col])[row];
-            for (ObstacleGridCell::const_iterator k = cell.begin(); k != cell.end(); ++k) {
-
-                Obstacle* o = *k;
-
-                if (processedObstacles.find(o) != processedObstacles.end()) continue;
-                processedObstacles.insert(o);
+    if (!obstacleIndexValid) {
+        obstacleIndex.build(obstacles);
+        obstacleIndexValid = true;
+    }
 
-                // bail if bounding boxes cannot overlap
-                if (o->getBboxP2().x < bboxP1.x) continue;
-                if (o->getBboxP1().x > bboxP2.x) continue;
-                if (o->getBboxP2().y < bboxP1.y) continue;
-                if (o->getBboxP1().y > bboxP2.y) continue;
+    // only obstacles whose bounding box is touched by the line of sight can attenuate
+    candidates.clear();
+    obstacleIndex.findIntersecting(senderPos, receiverPos, candidates);
 
-                double pSendOld = pSend;
+    // attenuation does not depend on the transmission power, so the factor is
+    // calculated (and cached) for unit power
+    factor = 1;
+    for (Obstacles::const_iterator k = candidates.begin(); k != candidates.end(); ++k) {
+        Obstacle* o = *k;
 
-                pSend = o->calculateReceivedPower(pSend, carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
+        double factorOld = factor;
 
-                // draw a "hit!" bubble
-                if (annotations && (pSend < pSendOld)) annotations->drawBubble(o->getBboxP1(), "hit");
+        factor = o->calculateReceivedPower(factor, carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
 
-                // bail if attenuation is already extremely high
-                if (pSend < 1e-30) break;
+        // draw a "hit!" bubble
+        if (annotations && (factor < factorOld)) annotations->drawBubble(o->getBboxP1(), "hit");
 
-            }
-        }
+        // bail if attenuation is already extremely high
+        if (factor < 1e-30) break;
     }
 
     // cache result
-    if (cacheEntries.size() >= 1000) cacheEntries.clear();
-    cacheEntries[cacheKey] = pSend;
+    cache.insert(carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle, factor);
 
-    return pSend;
+    return pSend * factor;
 }
@@ -21,13 +21,15 @@
 #ifndef WORLD_OBSTACLE_OBSTACLECONTROL_H
 #define WORLD_OBSTACLE_OBSTACLECONTROL_H
 
-#include <list>
+#include <vector>
 
 #include "INETDefs.h"
 
 #include "ModuleAccess.h"
 #include "Coord.h"
 #include "world/obstacles/Obstacle.h"
+#include "world/obstacles/ObstacleRTree.h"
+#include "world/obstacles/AttenuationCache.h"
 #include "world/annotations/AnnotationManager.h"
 
 /**
@@ -36,10 +38,16 @@
  * Each Obstacle is a polygon.
  * Transmissions that cross one of the polygon's lines will have
  * their receive power set to zero.
+ *
+ * Obstacles that a transmission may cross are looked up in an R-tree
+ * over their bounding boxes. The resulting attenuation factors are kept
+ * in an LRU cache keyed on the (optionally quantized) sender and receiver
+ * positions; the cache is cleared whenever obstacles are added or removed.
  */
 class INET_API ObstacleControl : public cSimpleModule
 {
     public:
+        ObstacleControl();
         virtual ~ObstacleControl();
         virtual void initialize(int stage);
         virtual int numInitStages() const { return 2; }
@@ -57,56 +65,19 @@ class INET_API ObstacleControl : public cSimpleModule
         double calculateReceivedPower(double pSend, double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) const;
 
     protected:
-        struct CacheKey {
-            const double pSend;
-            const double carrierFrequency;
-            const Coord senderPos;
-            const double senderAngle;
-            const Coord receiverPos;
-            const double receiverAngle;
-
-            CacheKey(double pSend, double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) :
-                pSend(pSend),
-                carrierFrequency(carrierFrequency),
-                senderPos(senderPos),
-                senderAngle(senderAngle),
-                receiverPos(receiverPos),
-                receiverAngle(receiverAngle) {
-            }
-            bool operator<(const CacheKey& o) const {
-                if (senderPos.x < o.senderPos.x) return true;
-                if (senderPos.x > o.senderPos.x) return false;
-                if (senderPos.y < o.senderPos.y) return true;
-                if (senderPos.y > o.senderPos.y) return false;
-                if (receiverPos.x < o.receiverPos.x) return true;
-                if (receiverPos.x > o.receiverPos.x) return false;
-                if (receiverPos.y < o.receiverPos.y) return true;
-                if (receiverPos.y > o.receiverPos.y) return false;
-                if (pSend < o.pSend) return true;
-                if (pSend > o.pSend) return false;
-                if (senderAngle < o.senderAngle) return true;
-                if (senderAngle > o.senderAngle) return false;
-                if (receiverAngle < o.receiverAngle) return true;
-                if (receiverAngle > o.receiverAngle) return false;
-                if (carrierFrequency < o.carrierFrequency) return true;
-                if (carrierFrequency > o.carrierFrequency) return false;
-                return false;
-            }
-        };
-
-        enum { GRIDCELL_SIZE = 1024 };
-
-        typedef std::list<Obstacle*> ObstacleGridCell;
-        typedef std::vector<ObstacleGridCell> ObstacleGridRow;
-        typedef std::vector<ObstacleGridRow> Obstacles;
-        typedef std::map<CacheKey, double> CacheEntries;
+        typedef std::vector<Obstacle*> Obstacles;
 
         cXMLElement* obstaclesXml; /**< obstacles to add at startup */
 
         Obstacles obstacles;
+        mutable ObstacleRTree obstacleIndex; /**< rebuilt lazily when obstacles change */
+        mutable bool obstacleIndexValid;
+        mutable Obstacles candidates; /**< scratch buffer for index queries */
         AnnotationManager* annotations;
         AnnotationManager::Group* annotationGroup;
-        mutable CacheEntries cacheEntries;
+        mutable AttenuationCache cache; /**< attenuation factors by sender and receiver position */
+
+        void obstaclesChanged();
 };
 
 class ObstacleControlAccess
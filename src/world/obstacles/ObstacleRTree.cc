@@ -0,0 +1,165 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+
+#include <algorithm>
+#include <math.h>
+
+#include "world/obstacles/ObstacleRTree.h"
+#include "world/obstacles/Obstacle.h"
+
+
+namespace {
+
+    // bounding boxes are enlarged by this much, so that rounding errors in
+    // the segment/box test cannot drop an obstacle that is touched at its edge
+    const double BOX_MARGIN = 1e-6;
+
+    // deep enough for MAX_CHILDREN^16 obstacles
+    const int MAX_STACK_DEPTH = 256;
+
+    template<typename T>
+    struct LessCenterX {
+        bool operator()(const T& a, const T& b) const { return a.box.centerX() < b.box.centerX(); }
+    };
+
+    template<typename T>
+    struct LessCenterY {
+        bool operator()(const T& a, const T& b) const { return a.box.centerY() < b.box.centerY(); }
+    };
+}
+
+ObstacleRTree::ObstacleRTree() {
+}
+
+void ObstacleRTree::clear() {
+    entries.clear();
+    nodes.clear();
+}
+
+void ObstacleRTree::build(const std::vector<Obstacle*>& obstacles) {
+    clear();
+    if (obstacles.empty()) return;
+
+    entries.reserve(obstacles.size());
+    for (std::vector<Obstacle*>::const_iterator i = obstacles.begin(); i != obstacles.end(); ++i) {
+        Entry e;
+        e.box.minX = (*i)->getBboxP1().x - BOX_MARGIN;
+        e.box.minY = (*i)->getBboxP1().y - BOX_MARGIN;
+        e.box.maxX = (*i)->getBboxP2().x + BOX_MARGIN;
+        e.box.maxY = (*i)->getBboxP2().y + BOX_MARGIN;
+        e.obstacle = *i;
+        entries.push_back(e);
+    }
+
+    // build the tree bottom-up; every level is tiled and packed into parents
+    sortTileRecursive(entries);
+    std::vector<Node> level = packLevel(entries, 0, true);
+    while (level.size() > 1) {
+        sortTileRecursive(level);
+        int base = nodes.size();
+        nodes.insert(nodes.end(), level.begin(), level.end());
+        level = packLevel(level, base, false);
+    }
+    nodes.push_back(level[0]);
+}
+
+template<typename T>
+void ObstacleRTree::sortTileRecursive(std::vector<T>& items) {
+    // sort by x into vertical slices of sliceCount nodes, then sort each slice by y
+    size_t numNodes = (items.size() + MAX_CHILDREN - 1) / MAX_CHILDREN;
+    size_t sliceCount = (size_t)ceil(sqrt((double)numNodes));
+    size_t sliceSize = sliceCount * MAX_CHILDREN;
+
+    std::sort(items.begin(), items.end(), LessCenterX<T>());
+    for (size_t start = 0; start < items.size(); start += sliceSize) {
+        size_t end = std::min(start + sliceSize, items.size());
+        std::sort(items.begin() + start, items.begin() + end, LessCenterY<T>());
+    }
+}
+
+template<typename T>
+std::vector<ObstacleRTree::Node> ObstacleRTree::packLevel(const std::vector<T>& items, int base, bool isLeaf) {
+    std::vector<Node> level;
+    level.reserve((items.size() + MAX_CHILDREN - 1) / MAX_CHILDREN);
+    for (size_t start = 0; start < items.size(); start += MAX_CHILDREN) {
+        size_t end = std::min(start + MAX_CHILDREN, items.size());
+        Node node;
+        node.box = items[start].box;
+        for (size_t i = start + 1; i < end; i++) {
+            const Box& b = items[i].box;
+            node.box.minX = std::min(node.box.minX, b.minX);
+            node.box.minY = std::min(node.box.minY, b.minY);
+            node.box.maxX = std::max(node.box.maxX, b.maxX);
+            node.box.maxY = std::max(node.box.maxY, b.maxY);
+        }
+        node.firstChild = base + start;
+        node.numChildren = end - start;
+        node.isLeaf = isLeaf;
+        level.push_back(node);
+    }
+    return level;
+}
+
+bool ObstacleRTree::segmentTouchesBox(double fromX, double fromY, double toX, double toY, const Box& box) {
+    // reject by the bounding box of the segment first
+    if (std::max(fromX, toX) < box.minX || std::min(fromX, toX) > box.maxX) return false;
+    if (std::max(fromY, toY) < box.minY || std::min(fromY, toY) > box.maxY) return false;
+
+    // clip the segment's parameter range [0,1] against the x and y slabs of the box
+    double tMin = 0, tMax = 1;
+    double dx = toX - fromX;
+    if (dx != 0) {
+        double t1 = (box.minX - fromX) / dx;
+        double t2 = (box.maxX - fromX) / dx;
+        if (t1 > t2) std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax) return false;
+    }
+    double dy = toY - fromY;
+    if (dy != 0) {
+        double t1 = (box.minY - fromY) / dy;
+        double t2 = (box.maxY - fromY) / dy;
+        if (t1 > t2) std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax) return false;
+    }
+    return true;
+}
+
+void ObstacleRTree::findIntersecting(const Coord& from, const Coord& to, std::vector<Obstacle*>& result) const {
+    if (nodes.empty()) return;
+
+    int stack[MAX_STACK_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = nodes.size() - 1;
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+        if (!segmentTouchesBox(from.x, from.y, to.x, to.y, node.box)) continue;
+        if (node.isLeaf) {
+            for (int i = node.firstChild; i < node.firstChild + node.numChildren; i++) {
+                if (segmentTouchesBox(from.x, from.y, to.x, to.y, entries[i].box))
+                    result.push_back(entries[i].obstacle);
+            }
+        }
+        else {
+            ASSERT(stackSize + node.numChildren <= MAX_STACK_DEPTH);
+            for (int i = node.firstChild + node.numChildren - 1; i >= node.firstChild; i--)
+                stack[stackSize++] = i;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+
+
+#ifndef WORLD_OBSTACLE_OBSTACLERTREE_H
+#define WORLD_OBSTACLE_OBSTACLERTREE_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "Coord.h"
+
+class Obstacle;
+
+/**
+ * Static R-tree over the bounding boxes of obstacles, used by ObstacleControl
+ * to find the obstacles a transmission may cross.
+ *
+ * The tree is bulk loaded with the Sort-Tile-Recursive (STR) algorithm, so
+ * it has to be rebuilt when the set of obstacles changes. Nodes are stored
+ * in a flat array, and the children of every node are stored contiguously.
+ */
+class INET_API ObstacleRTree {
+    public:
+        ObstacleRTree();
+
+        /** Builds the tree over the given obstacles, replacing the previous contents. */
+        void build(const std::vector<Obstacle*>& obstacles);
+
+        /** Removes all obstacles. */
+        void clear();
+
+        /**
+         * Appends the obstacles whose bounding box is touched by the line
+         * segment between the two positions to result. Only the x and y
+         * coordinates are considered.
+         */
+        void findIntersecting(const Coord& from, const Coord& to, std::vector<Obstacle*>& result) const;
+
+        int getNumObstacles() const { return entries.size(); }
+        int getNumNodes() const { return nodes.size(); }
+
+    protected:
+        enum { MAX_CHILDREN = 16 };
+
+        struct Box {
+            double minX, minY, maxX, maxY;
+            double centerX() const { return minX + maxX; }  // doubled, only used for sorting
+            double centerY() const { return minY + maxY; }
+        };
+
+        struct Entry {
+            Box box;
+            Obstacle* obstacle;
+        };
+
+        struct Node {
+            Box box;
+            int firstChild;     // index into nodes, or into entries for leaves
+            int numChildren;
+            bool isLeaf;
+        };
+
+        std::vector<Entry> entries;
+        std::vector<Node> nodes;    // the root is the last node
+
+        template<typename T> static void sortTileRecursive(std::vector<T>& items);
+        template<typename T> static std::vector<Node> packLevel(const std::vector<T>& items, int base, bool isLeaf);
+        static bool segmentTouchesBox(double fromX, double fromY, double toX, double toY, const Box& box);
+};
+
+#endif
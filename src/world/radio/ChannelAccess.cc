@@ -19,7 +19,8 @@
 #include "ChannelAccess.h"
 #include "IMobility.h"
 
-#define coreEV (ev.isDisabled()||!coreDebug) ? EV : EV << logName() << "::ChannelAccess: "
+// debug output, compiled out below LOGLEVEL_DEBUG and not formatted unless enabled
+#define coreEV if (!INET_LOG_ENABLED(LOGLEVEL_DEBUG) || ev.isDisabled() || !coreDebug) {} else EV << logName() << "::ChannelAccess: "
 
 simsignal_t ChannelAccess::mobilityStateChangedSignal = registerSignal("mobilityStateChanged");
 
@@ -61,6 +62,10 @@ void ChannelAccess::initialize(int stage)
         myRadioRef = NULL;
 
         positionUpdateArrived = false;
+        // with a neighbor margin ChannelControl does not need the position
+        // signalled regularly, so the mobility may only compute it on demand
+        cModule *ccModule = dynamic_cast<cModule *>(cc);
+        positionOnDemand = ccModule && ccModule->hasPar("neighborMargin") && ccModule->par("neighborMargin").doubleValue() > 0;
         // register to get a notification when position changes
         hostModule->subscribe(mobilityStateChangedSignal, this);
     }
@@ -85,7 +90,7 @@ void ChannelAccess::initialize(int stage)
         }
 
         myRadioRef = cc->registerRadio(this);
-        cc->setRadioPosition(myRadioRef, radioPos);
+        cc->setRadioPosition(myRadioRef, radioPos, mobility);
     }
 }
 
@@ -116,12 +121,20 @@ void ChannelAccess::receiveSignal(cComponent *source, simsignal_t signalID, cObj
 {
     if (signalID == mobilityStateChangedSignal)
     {
-        IMobility *mobility = check_and_cast<IMobility*>(obj);
+        mobility = check_and_cast<IMobility*>(obj);
         radioPos = mobility->getCurrentPosition();
         positionUpdateArrived = true;
 
         if (myRadioRef)
-            cc->setRadioPosition(myRadioRef, radioPos);
+            cc->setRadioPosition(myRadioRef, radioPos, mobility);
     }
 }
 
+const Coord& ChannelAccess::getRadioPosition() const
+{
+    // the mobility signals the position if it has changed since it was last
+    // asked for, and receiveSignal() updates radioPos
+    if (positionOnDemand && mobility)
+        mobility->getCurrentPosition();
+    return radioPos;
+}
@@ -31,6 +31,7 @@
 
 // Forward declarations
 class AirFrame;
+class IMobility;
 
 /**
  * @brief Basic class for all physical layers, please don't touch!!
@@ -59,9 +60,11 @@ class INET_API ChannelAccess : public BasicModule, protected cListener
     cModule *hostModule;    // the host that contains this radio model
     Coord radioPos;  // the physical position of the radio (derived from display string or from mobility models)
     bool positionUpdateArrived;
+    IMobility *mobility;  // the mobility that signalled the position, if any
+    bool positionOnDemand;  // the mobility is asked for the position, see ChannelControl's neighborMargin
 
   public:
-    ChannelAccess() : nb(NULL), cc(NULL), myRadioRef(NULL), hostModule(NULL) {}
+    ChannelAccess() : nb(NULL), cc(NULL), myRadioRef(NULL), hostModule(NULL), mobility(NULL), positionOnDemand(false) {}
     virtual ~ChannelAccess();
 
     /**
@@ -79,7 +82,7 @@ class INET_API ChannelAccess : public BasicModule, protected cListener
     virtual void sendToChannel(AirFrame *msg);
 
     virtual cPar& getChannelControlPar(const char *parName) { return dynamic_cast<cModule *>(cc)->par(parName); }
-    const Coord& getRadioPosition() const { return radioPos; }
+    const Coord& getRadioPosition() const;
     cModule *getHostModule() const { return hostModule; }
 
     /** Register with ChannelControl and subscribe to hostPos*/
@@ -18,10 +18,13 @@
 #include "ChannelControl.h"
 #include "FWMath.h"
 #include <cassert>
+#include <algorithm>
 
 #include "AirFrame_m.h"
+#include "IMobility.h"
 
-#define coreEV (ev.isDisabled()||!coreDebug) ? EV : EV << "ChannelControl: "
+// debug output, compiled out below LOGLEVEL_DEBUG and not formatted unless enabled
+#define coreEV if (!INET_LOG_ENABLED(LOGLEVEL_DEBUG) || ev.isDisabled() || !coreDebug) {} else EV << "ChannelControl: "
 
 Define_Module(ChannelControl);
 
@@ -42,6 +45,12 @@ std::ostream& operator<<(std::ostream& os, const ChannelControl::TransmissionLis
 
 ChannelControl::ChannelControl()
 {
+    useSpatialGrid = false;
+    minGridZ = maxGridZ = 0;
+    numFramesSent = numFramesDelivered = numFrameCopies = 0;
+    isUpdatingPositions = false;
+    neighborMargin = 0;
+    refreshTimer = NULL;
 }
 
 ChannelControl::~ChannelControl()
@@ -49,6 +58,7 @@ ChannelControl::~ChannelControl()
     for (unsigned int i = 0; i < transmissions.size(); i++)
         for (TransmissionList::iterator it = transmissions[i].begin(); it != transmissions[i].end(); it++)
             delete *it;
+    cancelAndDelete(refreshTimer);
 }
 
 /**
@@ -68,12 +78,35 @@ void ChannelControl::initialize()
     lastOngoingTransmissionsUpdate = 0;
 
     maxInterferenceDistance = calcInterfDist();
+    neighborMargin = par("neighborMargin");
+    if (neighborMargin < 0)
+        error("neighborMargin must not be negative");
+    neighborDistance = maxInterferenceDistance + neighborMargin;
+    refreshTimer = new cMessage("refresh");
+
+    // the grid only makes sense with a finite, positive cell size
+    useSpatialGrid = par("useSpatialGrid").boolValue() && neighborDistance > 0 && neighborDistance < 1e100;
+    minGridZ = maxGridZ = 0;
+
+    numFramesSent = numFramesDelivered = numFrameCopies = 0;
 
     WATCH(maxInterferenceDistance);
+    WATCH(neighborMargin);
+    WATCH(useSpatialGrid);
+    WATCH(numFramesSent);
+    WATCH(numFramesDelivered);
+    WATCH(numFrameCopies);
     WATCH_LIST(radios);
     WATCH_VECTOR(transmissions);
 }
 
+void ChannelControl::finish()
+{
+    recordScalar("frames sent", numFramesSent);
+    recordScalar("frames delivered", numFramesDelivered);
+    recordScalar("frame copies", numFrameCopies);
+}
+
 /**
  * Calculation of the interference distance based on the transmitter
  * power, wavelength, pathloss coefficient and a threshold for the
@@ -125,8 +158,14 @@ ChannelControl::RadioRef ChannelControl::registerRadio(cModule *radio, cGate *ra
     re.isNeighborListValid = false;
     re.channel = 0;  // for now
     re.isActive = true;
+    re.isMoved = false;
+    re.mobility = NULL;
+    re.refreshTime = -1;
     radios.push_back(re);
-    return &radios.back(); // last element
+    RadioRef r = &radios.back(); // last element
+    if (useSpatialGrid)
+        addToGrid(r, getGridCoord(r->pos));
+    return r;
 }
 
 void ChannelControl::unregisterRadio(RadioRef r)
@@ -137,14 +176,23 @@ void ChannelControl::unregisterRadio(RadioRef r)
         if (it->radioModule == r->radioModule)
         {
             RadioRef radioToRemove = &*it;
-            // erase radio from all registered radios' neighbor list
-            for (RadioList::iterator i2 = radios.begin(); i2 != radios.end(); ++i2)
+            // erase radio from its neighbors' neighbor list (the relation is symmetric)
+            for (std::set<RadioRef,RadioEntry::Compare>::iterator i2 = radioToRemove->neighbors.begin(); i2 != radioToRemove->neighbors.end(); ++i2)
             {
-                RadioRef otherRadio = &*i2;
+                RadioRef otherRadio = *i2;
                 otherRadio->neighbors.erase(radioToRemove);
                 otherRadio->isNeighborListValid = false;
-                radioToRemove->isNeighborListValid = false;
             }
+            radioToRemove->neighbors.clear();
+            radioToRemove->isNeighborListValid = false;
+
+            if (useSpatialGrid)
+                removeFromGrid(radioToRemove);
+
+            cancelRefresh(radioToRemove);
+
+            if (radioToRemove->isMoved)
+                movedRadios.erase(std::find(movedRadios.begin(), movedRadios.end(), radioToRemove));
 
             // erase radio from registered radios
             radios.erase(it);
@@ -179,39 +227,110 @@ const ChannelControl::RadioRefVector& ChannelControl::getNeighbors(RadioRef h)
 
 void ChannelControl::updateConnections(RadioRef h)
 {
-    Coord& hpos = h->pos;
-    double maxDistSquared = maxInterferenceDistance * maxInterferenceDistance;
-    for (RadioList::iterator it = radios.begin(); it != radios.end(); ++it)
-    {
-        RadioEntry *hi = &(*it);
-        if (hi == h)
-            continue;
+    double maxDistSquared = neighborDistance * neighborDistance;
 
-        // get the distance between the two radios.
-        // (omitting the square root (calling sqrdist() instead of distance()) saves about 5% CPU)
-        bool inRange = hpos.sqrdist(hi->pos) < maxDistSquared;
+    if (!useSpatialGrid)
+    {
+        for (RadioList::iterator it = radios.begin(); it != radios.end(); ++it)
+        {
+            RadioEntry *hi = &(*it);
+            if (hi != h && !hi->isMoved)
+                updateConnection(h, hi, maxDistSquared);
+        }
+        return;
+    }
 
-        if (inRange)
+    // drop the neighbors that went out of range; they may be anywhere by now,
+    // so they have to be checked one by one (copy, because the set gets modified)
+    RadioRefVector oldNeighbors(h->neighbors.begin(), h->neighbors.end());
+    for (RadioRefVector::iterator it = oldNeighbors.begin(); it != oldNeighbors.end(); ++it)
+        if (!(*it)->isMoved)
+            updateConnection(h, *it, maxDistSquared);
+
+    // new neighbors can only be in the radio's own cell or in the adjacent ones
+    const GridCoord& c = h->gridCell;
+    int zmin = std::max(c.z - 1, minGridZ);
+    int zmax = std::min(c.z + 1, maxGridZ);
+    for (int x = c.x - 1; x <= c.x + 1; x++)
+    {
+        for (int y = c.y - 1; y <= c.y + 1; y++)
         {
-            // nodes within communication range: connect
-            if (h->neighbors.insert(hi).second == true)
+            for (int z = zmin; z <= zmax; z++)
             {
-                hi->neighbors.insert(h);
-                h->isNeighborListValid = hi->isNeighborListValid = false;
+                Grid::iterator cellIt = grid.find(GridCoord(x, y, z));
+                if (cellIt == grid.end())
+                    continue;
+                RadioRefVector& cell = cellIt->second;
+                for (RadioRefVector::iterator it = cell.begin(); it != cell.end(); ++it)
+                    if (*it != h && !(*it)->isMoved)
+                        updateConnection(h, *it, maxDistSquared);
             }
         }
-        else
+    }
+}
+
+void ChannelControl::updateConnection(RadioRef h, RadioRef hi, double maxDistSquared)
+{
+    // get the distance between the two radios.
+    // (omitting the square root (calling sqrdist() instead of distance()) saves about 5% CPU)
+    bool inRange = h->pos.sqrdist(hi->pos) < maxDistSquared;
+
+    if (inRange)
+    {
+        // nodes within communication range: connect
+        if (h->neighbors.insert(hi).second == true)
         {
-            // out of range: disconnect
-            if (h->neighbors.erase(hi))
-            {
-                hi->neighbors.erase(h);
-                h->isNeighborListValid = hi->isNeighborListValid = false;
-            }
+            hi->neighbors.insert(h);
+            h->isNeighborListValid = hi->isNeighborListValid = false;
+        }
+    }
+    else
+    {
+        // out of range: disconnect
+        if (h->neighbors.erase(hi))
+        {
+            hi->neighbors.erase(h);
+            h->isNeighborListValid = hi->isNeighborListValid = false;
         }
     }
 }
 
+ChannelControl::GridCoord ChannelControl::getGridCoord(const Coord& pos) const
+{
+    return GridCoord((int)floor(pos.x / neighborDistance),
+                     (int)floor(pos.y / neighborDistance),
+                     (int)floor(pos.z / neighborDistance));
+}
+
+void ChannelControl::addToGrid(RadioRef r, const GridCoord& cell)
+{
+    r->gridCell = cell;
+    grid[cell].push_back(r);
+    if (cell.z < minGridZ)
+        minGridZ = cell.z;
+    if (cell.z > maxGridZ)
+        maxGridZ = cell.z;
+}
+
+void ChannelControl::removeFromGrid(RadioRef r)
+{
+    Grid::iterator cellIt = grid.find(r->gridCell);
+    ASSERT(cellIt != grid.end());
+    RadioRefVector& cell = cellIt->second;
+    for (RadioRefVector::iterator it = cell.begin(); it != cell.end(); ++it)
+    {
+        if (*it == r)
+        {
+            // order within a cell does not matter
+            *it = cell.back();
+            cell.pop_back();
+            break;
+        }
+    }
+    if (cell.empty())
+        grid.erase(cellIt);
+}
+
 void ChannelControl::checkChannel(int channel)
 {
     if (channel >= numChannels || channel < 0)
@@ -219,12 +338,152 @@ void ChannelControl::checkChannel(int channel)
 }
 
 void ChannelControl::setRadioPosition(RadioRef r, const Coord& pos)
+{
+    setRadioPosition(r, pos, NULL);
+}
+
+void ChannelControl::setRadioPosition(RadioRef r, const Coord& pos, IMobility *mobility)
 {
     Enter_Method_Silent();
+    if (neighborMargin > 0)
+    {
+        // the neighbor sets stay valid until the radio gets neighborMargin/2
+        // away from the position they were computed for
+        if (mobility && r->mobility == mobility && pos.distance(r->pos) < neighborMargin / 2)
+        {
+            scheduleRefresh(r, pos);
+            return;
+        }
+        r->mobility = mobility;
+    }
     r->pos = pos;
+    if (neighborMargin > 0)
+        scheduleRefresh(r, pos);
+    if (isUpdatingPositions)
+    {
+        // connections are updated at the end of the batch
+        if (!r->isMoved)
+        {
+            r->isMoved = true;
+            movedRadios.push_back(r);
+        }
+        return;
+    }
+    if (useSpatialGrid)
+    {
+        GridCoord cell = getGridCoord(pos);
+        if (cell != r->gridCell)
+        {
+            removeFromGrid(r);
+            addToGrid(r, cell);
+        }
+    }
     updateConnections(r);
 }
 
+void ChannelControl::scheduleRefresh(RadioRef r, const Coord& pos)
+{
+    cancelRefresh(r);
+    if (!r->mobility)
+        return;
+
+    // assume the current speed until the mobility signals the next change;
+    // the refresh is not needed if the radio stands still
+    double speed = r->mobility->getCurrentSpeed().length();
+    if (speed == 0)
+        return;
+    double timeToExpiry = (neighborMargin / 2 - pos.distance(r->pos)) / speed;
+    if (timeToExpiry >= (MAXTIME - simTime()).dbl())
+        return;
+
+    r->refreshTime = simTime() + timeToExpiry;
+    refreshSchedule[std::make_pair(r->refreshTime, r->radioModule->getId())] = r;
+    simtime_t firstRefreshTime = refreshSchedule.begin()->first.first;
+    if (!refreshTimer->isScheduled() || refreshTimer->getArrivalTime() != firstRefreshTime)
+    {
+        cancelEvent(refreshTimer);
+        scheduleAt(firstRefreshTime, refreshTimer);
+    }
+}
+
+void ChannelControl::cancelRefresh(RadioRef r)
+{
+    // the timer is left alone, handleMessage() copes with an empty schedule
+    if (r->refreshTime != -1)
+    {
+        refreshSchedule.erase(std::make_pair(r->refreshTime, r->radioModule->getId()));
+        r->refreshTime = -1;
+    }
+}
+
+void ChannelControl::handleMessage(cMessage *msg)
+{
+    if (msg != refreshTimer)
+        error("Unexpected message %s", msg->getName());
+
+    while (!refreshSchedule.empty() && refreshSchedule.begin()->first.first <= simTime())
+    {
+        RadioRef r = refreshSchedule.begin()->second;
+        refreshSchedule.erase(refreshSchedule.begin());
+        r->refreshTime = -1;
+
+        // asking for the position normally makes the mobility signal it, which
+        // arrives here through ChannelAccess; clearing r->mobility turns that
+        // into a full update
+        IMobility *mobility = r->mobility;
+        r->mobility = NULL;
+        Coord pos = mobility->getCurrentPosition();
+        if (!r->mobility)
+            setRadioPosition(r, pos, mobility);
+    }
+    if (!refreshSchedule.empty() && !refreshTimer->isScheduled())
+        scheduleAt(refreshSchedule.begin()->first.first, refreshTimer);
+}
+
+Coord ChannelControl::getCurrentRadioPosition(RadioRef r)
+{
+    return neighborMargin > 0 && r->mobility ? r->mobility->getCurrentPosition() : r->pos;
+}
+
+void ChannelControl::beginPositionUpdates()
+{
+    Enter_Method_Silent();
+    if (isUpdatingPositions)
+        error("beginPositionUpdates(): a batch of position updates is already in progress");
+    isUpdatingPositions = true;
+}
+
+void ChannelControl::endPositionUpdates()
+{
+    Enter_Method_Silent();
+    if (!isUpdatingPositions)
+        error("endPositionUpdates(): no batch of position updates in progress");
+    isUpdatingPositions = false;
+
+    // all radios must be in their new cells before the first lookup
+    if (useSpatialGrid)
+    {
+        for (RadioRefVector::iterator it = movedRadios.begin(); it != movedRadios.end(); ++it)
+        {
+            GridCoord cell = getGridCoord((*it)->pos);
+            if (cell != (*it)->gridCell)
+            {
+                removeFromGrid(*it);
+                addToGrid(*it, cell);
+            }
+        }
+    }
+
+    // updateConnections() skips the moved radios that are still pending, so a
+    // pair of moved radios is only checked when the second one is processed
+    for (RadioRefVector::iterator it = movedRadios.begin(); it != movedRadios.end(); ++it)
+    {
+        (*it)->isMoved = false;
+        updateConnections(*it);
+    }
+    movedRadios.clear();
+}
+
 void ChannelControl::setRadioChannel(RadioRef r, int channel)
 {
     Enter_Method_Silent();
@@ -291,28 +550,51 @@ void ChannelControl::sendToChannel(RadioRef srcRadio, AirFrame *airFrame)
 {
     // NOTE: no Enter_Method()! We pretend this method is part of ChannelAccess
 
-    // loop through all radios in range
+    numFramesSent++;
+
+    // collect the radios in range that listen on the frame's channel
     const RadioRefVector& neighbors = getNeighbors(srcRadio);
     int n = neighbors.size();
     int channel = airFrame->getChannelNumber();
+    Coord srcPos = getCurrentRadioPosition(srcRadio);
+    receivers.clear();
     for (int i=0; i<n; i++)
     {
         RadioRef r = neighbors[i];
         if (!r->isActive)
-        {
             coreEV << "skipping disabled radio interface \n";
-            continue;
-        }
-        if (r->channel == channel)
-        {
-            coreEV << "sending message to radio listening on the same channel\n";
-            // account for propagation delay, based on distance in meters
-            // Over 300m, dt=1us=10 bit times @ 10Mbps
-            simtime_t delay = srcRadio->pos.distance(r->pos) / SPEED_OF_LIGHT;
-            check_and_cast<cSimpleModule*>(srcRadio->radioModule)->sendDirect(airFrame->dup(), delay, airFrame->getDuration(), r->radioInGate);
-        }
-        else
+        else if (r->channel != channel)
             coreEV << "skipping radio listening on a different channel\n";
+        else if (neighborMargin > 0 && srcPos.distance(getCurrentRadioPosition(r)) >= maxInterferenceDistance)
+            coreEV << "skipping radio within neighborMargin only\n";
+        else
+            receivers.push_back(r);
+    }
+
+    // The copies only duplicate the AirFrame's own fields (per-reception data
+    // such as arrival time and receive power); the encapsulated MAC frame is
+    // shared among them by cPacket's reference counting, and only gets copied
+    // when a receiver actually decapsulates it. With a single channel the
+    // original frame is not kept as an ongoing transmission, so it can be
+    // handed over to the last receiver instead of being copied and deleted.
+    cSimpleModule *srcModule = check_and_cast<cSimpleModule*>(srcRadio->radioModule);
+    bool keepOriginal = numChannels != 1;
+    int numReceivers = receivers.size();
+    for (int i=0; i<numReceivers; i++)
+    {
+        RadioRef r = receivers[i];
+        coreEV << "sending message to radio listening on the same channel\n";
+        // account for propagation delay, based on distance in meters
+        // Over 300m, dt=1us=10 bit times @ 10Mbps
+        simtime_t delay = srcPos.distance(getCurrentRadioPosition(r)) / SPEED_OF_LIGHT;
+        bool handOver = !keepOriginal && i == numReceivers - 1;
+        AirFrame *frame = handOver ? airFrame : airFrame->dup();
+        if (!handOver)
+            numFrameCopies++;
+        numFramesDelivered++;
+        srcModule->sendDirect(frame, delay, frame->getDuration(), r->radioInGate);
+        if (handOver)
+            return;
     }
 
     // register transmission
@@ -20,6 +20,7 @@
 #include <vector>
 #include <list>
 #include <set>
+#include <map>
 
 #include "INETDefs.h"
 #include "Coord.h"
@@ -27,6 +28,7 @@
 
 // Forward declarations
 class AirFrame;
+class IMobility;
 
 #define TRANSMISSION_PURGE_INTERVAL 1.0
 
@@ -53,6 +55,22 @@ struct IChannelControl::RadioEntry {
     std::vector<RadioRef> neighborList;
     bool isNeighborListValid;
     bool isActive;
+    bool isMoved;  // position changed in the current batch of position updates, proximity info not updated yet
+    IMobility *mobility;  // known with neighborMargin only: asked for the position when the proximity info expires
+    simtime_t refreshTime;  // when the proximity info expires (-1 if never)
+
+    /** Coordinates of the spatial grid cell the radio is currently filed under */
+    struct GridCoord {
+        int x, y, z;
+        GridCoord() : x(0), y(0), z(0) {}
+        GridCoord(int x, int y, int z) : x(x), y(y), z(z) {}
+        bool operator<(const GridCoord& other) const {
+            return x != other.x ? x < other.x : y != other.y ? y < other.y : z < other.z;
+        }
+        bool operator==(const GridCoord& other) const { return x == other.x && y == other.y && z == other.z; }
+        bool operator!=(const GridCoord& other) const { return !(*this == other); }
+    };
+    GridCoord gridCell;
 };
 
 /**
@@ -66,9 +84,20 @@ class INET_API ChannelControl : public cSimpleModule, public IChannelControl
   protected:
     typedef std::list<RadioEntry> RadioList;
     typedef std::vector<RadioRef> RadioRefVector;
+    typedef RadioEntry::GridCoord GridCoord;
+    typedef std::map<GridCoord, RadioRefVector> Grid;
 
     RadioList radios;
 
+    /**
+     * Uniform spatial grid over the registered radios. The cell size equals
+     * neighborDistance, so every radio in range of a given radio is
+     * filed under the same or one of the adjacent cells.
+     */
+    bool useSpatialGrid;
+    Grid grid;
+    int minGridZ, maxGridZ;  // z range of the cells used so far; lets 2D scenarios skip the z-1/z+1 layers
+
     /** keeps track of ongoing transmissions; this is needed when a radio
      * switches to another channel (then it needs to know whether the target channel
      * is empty or busy)
@@ -91,15 +120,67 @@ class INET_API ChannelControl : public cSimpleModule, public IChannelControl
     /** the number of controlled channels */
     int numChannels;
 
+    /** statistics: transmitted frames, and AirFrame objects delivered to receivers */
+    long numFramesSent;
+    long numFramesDelivered;
+    long numFrameCopies;  // deliveries that needed a dup() of the original frame
+
+    /** scratch vector for sendToChannel(), kept to avoid reallocation */
+    RadioRefVector receivers;
+
+    /** batch of position updates in progress, see beginPositionUpdates() */
+    bool isUpdatingPositions;
+    RadioRefVector movedRadios;
+
+    /**
+     * With a positive neighborMargin, the neighbor sets also contain the radios
+     * up to neighborMargin farther than maxInterferenceDistance, and the
+     * proximity info of a radio is only updated after it moved neighborMargin/2.
+     * Radios with a known mobility are refreshed when they are predicted to
+     * have moved that far, so their positions need not be signalled regularly.
+     */
+    double neighborMargin;
+    double neighborDistance;  // maxInterferenceDistance + neighborMargin
+    typedef std::map<std::pair<simtime_t, int>, RadioRef> RefreshSchedule;
+    RefreshSchedule refreshSchedule;  // keyed by refresh time and radio module id
+    cMessage *refreshTimer;
+
   protected:
     virtual void updateConnections(RadioRef h);
 
+    /** Schedules the refresh of the proximity info of r, which is now at pos; see neighborMargin */
+    virtual void scheduleRefresh(RadioRef r, const Coord& pos);
+
+    /** Removes r from the refresh schedule */
+    virtual void cancelRefresh(RadioRef r);
+
+    /** Returns the exact position of the radio; the cached one may lag behind with neighborMargin */
+    virtual Coord getCurrentRadioPosition(RadioRef r);
+
+    /** Connects/disconnects h to/from the given radio, depending on their distance */
+    virtual void updateConnection(RadioRef h, RadioRef other, double maxDistSquared);
+
+    /** Returns the grid cell that contains the given position */
+    virtual GridCoord getGridCoord(const Coord& pos) const;
+
+    /** Files the radio under the given grid cell */
+    virtual void addToGrid(RadioRef r, const GridCoord& cell);
+
+    /** Removes the radio from the grid cell it is currently filed under */
+    virtual void removeFromGrid(RadioRef r);
+
     /** Calculate interference distance*/
     virtual double calcInterfDist();
 
     /** Reads init parameters and calculates a maximal interference distance*/
     virtual void initialize();
 
+    /** Refreshes the proximity info of the radios whose refresh time has come */
+    virtual void handleMessage(cMessage *msg);
+
+    /** Records delivery statistics */
+    virtual void finish();
+
     /** Throws away expired transmissions. */
     virtual void purgeOngoingTransmissions();
 
@@ -137,6 +218,15 @@ class INET_API ChannelControl : public cSimpleModule, public IChannelControl
     /** To be called when the host moved; updates proximity info */
     virtual void setRadioPosition(RadioRef r, const Coord& pos);
 
+    /** To be called when the host moved; with neighborMargin, updates proximity info only if it expired */
+    virtual void setRadioPosition(RadioRef r, const Coord& pos, IMobility *mobility);
+
+    /** Starts a batch of position updates, see IChannelControl */
+    virtual void beginPositionUpdates();
+
+    /** Ends a batch of position updates, and updates proximity info */
+    virtual void endPositionUpdates();
+
     /** Called when host switches channel */
     virtual void setRadioChannel(RadioRef r, int channel);
 
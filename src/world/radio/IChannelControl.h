@@ -25,6 +25,7 @@
 
 // Forward declarations
 class AirFrame;
+class IMobility;
 
 /**
  * Interface to implement for a module that controls radio frequency channel access.
@@ -59,6 +60,22 @@ class INET_API IChannelControl
     /** To be called when the host moved; updates proximity info */
     virtual void setRadioPosition(RadioRef r, const Coord& pos) = 0;
 
+    /**
+     * To be called when the host moved, if its mobility is known; lets the
+     * implementation ask the mobility for the position later on its own.
+     */
+    virtual void setRadioPosition(RadioRef r, const Coord& pos, IMobility *mobility) { setRadioPosition(r, pos); }
+
+    /**
+     * Starts a batch of position updates: the proximity info of the radios
+     * passed to setRadioPosition() is only updated by endPositionUpdates().
+     * No frames may be sent in between.
+     */
+    virtual void beginPositionUpdates() = 0;
+
+    /** Ends a batch of position updates, and updates proximity info */
+    virtual void endPositionUpdates() = 0;
+
     /** Called when host switches channel */
     virtual void setRadioChannel(RadioRef r, int channel) = 0;
 
@@ -23,7 +23,8 @@
 #include "IMobility.h"
 
 
-#define coreEV (ev.isDisabled()||!coreDebug) ? EV : EV << logName() << "::IdealChannelModelAccess: "
+// debug output, compiled out below LOGLEVEL_DEBUG and not formatted unless enabled
+#define coreEV if (!INET_LOG_ENABLED(LOGLEVEL_DEBUG) || ev.isDisabled() || !coreDebug) {} else EV << logName() << "::IdealChannelModelAccess: "
 
 simsignal_t IdealChannelModelAccess::mobilityStateChangedSignal = registerSignal("mobilityStateChanged");
 